@@ -7,15 +7,25 @@ set(lslsources
         src/cancellation.cpp
         src/common.cpp
         src/common.h
+        src/compiled_query.cpp
+        src/compiled_query.h
         src/consumer_queue.cpp
         src/consumer_queue.h
         src/data_receiver.cpp
         src/data_receiver.h
+        src/feed_compression.cpp
+        src/feed_compression.h
         src/forward.h
         src/info_receiver.cpp
         src/info_receiver.h
+        src/info_reply.cpp
+        src/info_reply.h
         src/inlet_connection.cpp
         src/inlet_connection.h
+        src/io_context_pool.cpp
+        src/io_context_pool.h
+        src/local_outlets.cpp
+        src/local_outlets.h
         src/lsl_resolver_c.cpp
         src/lsl_inlet_c.cpp
         src/lsl_outlet_c.cpp
@@ -35,8 +45,12 @@ set(lslsources
         src/sample.h
         src/send_buffer.cpp
         src/send_buffer.h
+        src/shm_ring.cpp
+        src/shm_ring.h
         src/socket_utils.cpp
         src/socket_utils.h
+        src/stats.cpp
+        src/stats.h
         src/stream_info_impl.cpp
         src/stream_info_impl.h
         src/stream_inlet_impl.h
@@ -56,6 +70,10 @@ set(lslsources
         src/util/endian.hpp
         src/util/inireader.hpp
         src/util/inireader.cpp
+        src/util/lru_cache.hpp
+        src/util/lz4.cpp
+        src/util/lz4.hpp
+        src/util/simd.hpp
         src/util/strfuns.hpp
         src/util/strfuns.cpp
         src/util/uuid.hpp
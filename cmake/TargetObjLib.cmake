@@ -24,7 +24,9 @@ if(UNIX AND NOT APPLE)
     # check that clock_gettime is present in the stdlib, link against librt otherwise
     include(CheckSymbolExists)
     check_symbol_exists(clock_gettime time.h HAS_GETTIME)
-    if(NOT HAS_GETTIME)
+    # same for shm_open (needed by the shared memory transport)
+    check_symbol_exists(shm_open sys/mman.h HAS_SHM_OPEN)
+    if(NOT HAS_GETTIME OR NOT HAS_SHM_OPEN)
         target_link_libraries(lslobj PRIVATE rt)
     endif()
     if(LSL_DEBUGLOG)
@@ -161,10 +161,86 @@ typedef enum {
 	/// The supplied max_buf should be scaled by 0.001.
 	transp_bufsize_thousandths = 2,
 
+	/** Inlets only: poll for new samples for a while before going to sleep.
+	 * Lowers the latency of pulls at the cost of CPU time, see `tuning.BusyPollSpins`.
+	 * Has no effect on machines with a single CPU core. */
+	transp_busy_poll = 4,
+
+	/** Inlets only: if the inlet's buffer is full, drop new samples instead of the oldest ones.
+	 * The number of dropped samples is counted in the inlet's statistics (lsl_stat_dropped). */
+	transp_drop_newest = 8,
+
+	/** Inlets only: if the inlet's buffer is full, make the sender wait for the application to
+	 * pull samples, up to `tuning.OverflowBlockTimeout` seconds. If the application doesn't pull
+	 * in time, the oldest samples are dropped until it does. */
+	transp_block_when_full = 16,
+
+	/** Inlets only: ask the outlet to compress the samples (LZ4 with a prefilter for numeric
+	 * channels), which trades CPU time on both ends for bandwidth, e.g. on wireless links.
+	 * Has no effect on outlets that don't support it. See also `tuning.FeedCompression`. */
+	transp_compress = 32,
+
 	// prevent compilers from assuming an instance fits in a single byte
 	_lsl_transport_options_maxval = 0x7f000000
 } lsl_transport_options_t;
 
+/**
+ * Entries of the statistics reported by lsl_outlet_get_stats() and lsl_inlet_get_stats().
+ *
+ * New entries are only ever appended, so a program can pass an array sized for the entries it
+ * knows about. Durations are in nanoseconds.
+ */
+typedef enum {
+	/// Samples pushed into the outlet, or received by the inlet.
+	lsl_stat_samples = 0,
+
+	/// Bytes sent to all inlets over the network, or received by the inlet (without the shared
+	/// memory and in-process transfers).
+	lsl_stat_bytes = 1,
+
+	/// Samples dropped because an inlet didn't keep up and its buffer (in the outlet or in the
+	/// inlet) was full.
+	lsl_stat_dropped = 2,
+
+	/// Number of times the sample pool had to allocate memory, see lsl_get_sample_pool_stats().
+	lsl_stat_pool_grows = 3,
+
+	/// Number of samples whose time in a buffer was measured, i.e. the time between being pushed
+	/// into the buffer and being sent (outlets) or pulled (inlets).
+	lsl_stat_dwell_count = 4,
+
+	/// Percentiles of the time samples spent in a buffer.
+	lsl_stat_dwell_p50 = 5,
+	lsl_stat_dwell_p90 = 6,
+	lsl_stat_dwell_p99 = 7,
+	lsl_stat_dwell_p999 = 8,
+
+	/// The number of entries in this version of the header.
+	lsl_stat_count = 9,
+
+	// prevent compilers from assuming an instance fits in a single byte
+	_lsl_stat_maxval = 0x7f000000
+} lsl_stat_t;
+
+/// Kinds of changes of a continuous resolver's results, see lsl_resolver_changes().
+typedef enum {
+	/// The resolver no longer knows all changes since the given generation: forget all streams
+	/// and apply the following changes. The stream info for this entry is NULL.
+	lsl_resolver_reset = 0,
+
+	/// A stream was found.
+	lsl_resolver_added = 1,
+
+	/// A stream's info changed, e.g. because it was also found via another IP protocol.
+	lsl_resolver_changed = 2,
+
+	/// A stream hasn't been seen for forget_after seconds and was removed from the results.
+	lsl_resolver_removed = 3,
+
+	// prevent compilers from assuming an instance fits in a single byte
+	_lsl_resolver_change_maxval = 0x7f000000
+} lsl_resolver_change_t;
+
 /// Return an explanation for the last error
 extern LIBLSL_C_API const char *lsl_last_error(void);
 
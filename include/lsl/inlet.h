@@ -282,6 +282,18 @@ extern LIBLSL_C_API uint32_t lsl_samples_available(lsl_inlet in);
 /// Drop all queued not-yet pulled samples, return the nr of dropped samples
 extern LIBLSL_C_API uint32_t lsl_inlet_flush(lsl_inlet in);
 
+/**
+* Get statistics about the samples received by the inlet.
+*
+* The counters are kept with little overhead while samples are transferred and can be read at any
+* time, from any thread.
+* @param stats An array that receives the statistics, indexed by lsl_stat_t.
+* @param num_stats The number of entries in the array; entries beyond lsl_stat_count are left
+* unchanged.
+* @return The number of entries written, or lsl_argument_error.
+*/
+extern LIBLSL_C_API int32_t lsl_inlet_get_stats(lsl_inlet in, uint64_t *stats, int32_t num_stats);
+
 /**
 * Query whether the clock was potentially reset since the last call to lsl_was_clock_reset().
 *
@@ -239,6 +239,33 @@ extern LIBLSL_C_API int32_t lsl_have_consumers(lsl_outlet out);
 */
 extern LIBLSL_C_API int32_t lsl_wait_for_consumers(lsl_outlet out, double timeout);
 
+/**
+* Get statistics about the samples allocated by the outlet.
+* The samples are kept until all inlets have received them, so this shows how large the
+* `OutletBufferReserveMs` / `OutletBufferReserveSamples` settings should be to avoid allocations
+* while pushing. Each pointer may be NULL if the value isn't needed.
+* @param allocated Receives the number of samples currently allocated.
+* @param in_use Receives the number of samples currently pushed but not yet sent to all inlets.
+* @param peak Receives the largest number of samples in use since the outlet was created.
+* @return 0 or an error code from lsl_error_code_t.
+*/
+extern LIBLSL_C_API int32_t lsl_get_sample_pool_stats(
+	lsl_outlet out, uint32_t *allocated, uint32_t *in_use, uint32_t *peak);
+
+/**
+* Get statistics about the samples pushed into the outlet and sent to its inlets.
+*
+* The counters are kept with little overhead while samples are transferred and can be read at any
+* time, from any thread. The dwell time is the time samples wait in the outlet's buffer until
+* they're sent to an inlet.
+* @param stats An array that receives the statistics, indexed by lsl_stat_t.
+* @param num_stats The number of entries in the array; entries beyond lsl_stat_count are left
+* unchanged.
+* @return The number of entries written, or lsl_argument_error.
+*/
+extern LIBLSL_C_API int32_t lsl_outlet_get_stats(
+	lsl_outlet out, uint64_t *stats, int32_t num_stats);
+
 /**
  * Retrieve a handle to the stream info provided by this outlet.
  * This is what was used to create the stream (and also has the Additional Network Information
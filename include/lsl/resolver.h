@@ -69,6 +69,59 @@ extern LIBLSL_C_API lsl_continuous_resolver lsl_create_continuous_resolver_bypre
  */
 extern LIBLSL_C_API int32_t lsl_resolver_results(lsl_continuous_resolver res, lsl_streaminfo *buffer, uint32_t buffer_elements);
 
+/**
+ * Obtain the changes of the results after a given generation.
+ *
+ * Each change of the results (a stream is found, changes or is forgotten) increments the resolver's
+ * generation. Applying the changes in order keeps a copy of the results up to date without
+ * copying all results on every poll.
+ * @param res A continuous resolver.
+ * @param[in,out] generation The generation returned by the previous call, or 0 to obtain all
+ * current results as added. Receives the generation up to which the changes were written.
+ * @param buffer A user-allocated buffer that receives the stream infos. The caller has to destroy
+ * them, as in lsl_resolver_results().
+ * @param changes A user-allocated buffer that receives the kind of each change
+ * (values of #lsl_resolver_change_t).
+ * @param buffer_elements The length of both buffers. If there are more changes, the remaining
+ * ones are returned by the next call. Some changes have to be returned together, e.g. the reset
+ * and all current results or a stream that was found and then changed. If they don't fit, nothing
+ * is written, the generation is left unchanged and the needed length is returned.
+ * @return The number of changes written into the buffers, a number larger than buffer_elements if
+ * the buffers are too small, or a negative number if an error has occurred (values corresponding
+ * to #lsl_error_code_t).
+ */
+extern LIBLSL_C_API int32_t lsl_resolver_changes(lsl_continuous_resolver res, uint64_t *generation,
+	lsl_streaminfo *buffer, int32_t *changes, uint32_t buffer_elements);
+
+/**
+ * Wait until the results of a continuous resolver change after the given generation.
+ *
+ * @param res A continuous resolver.
+ * @param generation The generation returned by lsl_resolver_changes().
+ * @param timeout The maximum time to wait, in seconds (LSL_FOREVER to wait indefinitely).
+ * @return 1 if the results changed, 0 if the timeout expired, or a negative number if an error
+ * has occurred (values corresponding to #lsl_error_code_t).
+ */
+extern LIBLSL_C_API int32_t lsl_resolver_wait_changes(
+	lsl_continuous_resolver res, uint64_t generation, double timeout);
+
+/// A function that is called with the resolver, its new generation and the user data.
+typedef void (*lsl_resolver_callback)(lsl_continuous_resolver res, uint64_t generation, void *userdata);
+
+/**
+ * Set a function that is called whenever the results of a continuous resolver change.
+ *
+ * The function is called from the resolver's background thread and should return quickly, e.g.
+ * after signalling another thread to call lsl_resolver_changes().
+ * @param res A continuous resolver.
+ * @param callback The function, or NULL to remove the current function.
+ * @param userdata A pointer passed to the function.
+ * @return 0 or a negative number if an error has occurred (values corresponding to
+ * #lsl_error_code_t).
+ */
+extern LIBLSL_C_API int32_t lsl_resolver_set_callback(
+	lsl_continuous_resolver res, lsl_resolver_callback callback, void *userdata);
+
 /// Destructor for the continuous resolver.
 extern LIBLSL_C_API void lsl_destroy_continuous_resolver(lsl_continuous_resolver res);
 
@@ -761,6 +761,23 @@ public:
 	 */
 	bool wait_for_consumers(double timeout) { return lsl_wait_for_consumers(obj.get(), timeout) != 0; }
 
+	/** Get statistics about the samples allocated by this outlet, in samples.
+	 * Can be used to find a good value for the `OutletBufferReserveMs` setting, see
+	 * lsl_get_sample_pool_stats().
+	 */
+	void sample_pool_stats(uint32_t &allocated, uint32_t &in_use, uint32_t &peak) {
+		check_error(lsl_get_sample_pool_stats(obj.get(), &allocated, &in_use, &peak));
+	}
+
+	/** Get the statistics about the samples pushed into this outlet and sent to its inlets.
+	 * @return The values indexed by lsl_stat_t, see lsl_outlet_get_stats().
+	 */
+	std::vector<uint64_t> stats() {
+		std::vector<uint64_t> result(lsl_stat_count);
+		result.resize(check_error(lsl_outlet_get_stats(obj.get(), result.data(), lsl_stat_count)));
+		return result;
+	}
+
 	/** Retrieve the stream info provided by this outlet.
 	 * This is what was used to create the stream (and also has the Additional Network Information
 	 * fields assigned).
@@ -1442,6 +1459,15 @@ public:
 	/// Drop all queued not-yet pulled samples, return the nr of dropped samples
 	uint32_t flush() noexcept { return lsl_inlet_flush(obj.get()); }
 
+	/** Get the statistics about the samples received by this inlet.
+	 * @return The values indexed by lsl_stat_t, see lsl_inlet_get_stats().
+	 */
+	std::vector<uint64_t> stats() {
+		std::vector<uint64_t> result(lsl_stat_count);
+		result.resize(check_error(lsl_inlet_get_stats(obj.get(), result.data(), lsl_stat_count)));
+		return result;
+	}
+
 	/**
 	 * Query whether the clock was potentially reset since the last call to was_clock_reset().
 	 *
@@ -1672,6 +1698,48 @@ public:
 			buffer, buffer + check_error(lsl_resolver_results(obj.get(), buffer, sizeof(buffer))));
 	}
 
+	/// A change of the results, see changes().
+	struct change {
+		lsl_resolver_change_t kind;
+		/// The stream as it is now (or was when it was removed); empty for lsl_resolver_reset.
+		stream_info info;
+	};
+
+	/**
+	 * Obtain the changes of the results after a given generation.
+	 *
+	 * Applying the changes in order keeps a copy of the results up to date without copying all
+	 * of them on every poll, see lsl_resolver_changes().
+	 * @param generation The generation returned by the previous call, or 0 to obtain all current
+	 * results as added. Receives the new generation. If there are many changes, only the first
+	 * ones are returned and the next call returns the remaining ones.
+	 */
+	std::vector<change> changes(uint64_t &generation) {
+		std::vector<lsl_streaminfo> buffer(1024);
+		std::vector<int32_t> kinds(1024);
+		int32_t n;
+		// grow the buffers if the first changes need more space
+		while ((n = check_error(lsl_resolver_changes(obj.get(), &generation, buffer.data(),
+					kinds.data(), static_cast<uint32_t>(buffer.size())))) >
+			   static_cast<int32_t>(buffer.size())) {
+			buffer.resize(n);
+			kinds.resize(n);
+		}
+		std::vector<change> result;
+		result.reserve(n);
+		for (int32_t k = 0; k < n; k++)
+			result.push_back(change{static_cast<lsl_resolver_change_t>(kinds[k]), buffer[k]});
+		return result;
+	}
+
+	/**
+	 * Wait until the results change after the given generation.
+	 * @return Whether the results changed before the timeout expired.
+	 */
+	bool wait_for_changes(uint64_t generation, double timeout = FOREVER) {
+		return check_error(lsl_resolver_wait_changes(obj.get(), generation, timeout)) > 0;
+	}
+
 	/// Move constructor for stream_inlet
 	continuous_resolver(continuous_resolver &&rhs) noexcept = default;
 	continuous_resolver &operator=(continuous_resolver &&rhs) noexcept = default;
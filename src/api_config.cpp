@@ -321,6 +321,15 @@ void api_config::load(INI &pt) {
 	socket_receive_buffer_size_ = pt.get("tuning.ReceiveSocketBufferSize", 0);
 	smoothing_halftime_ = pt.get("tuning.SmoothingHalftime", 90.0F);
 	force_default_timestamps_ = pt.get("tuning.ForceDefaultTimestamps", false);
+	async_transfer_ = pt.get("tuning.AsyncTransfer", false);
+	shared_io_threads_ = pt.get("tuning.SharedIOThreads", 0);
+	shared_memory_transport_ = pt.get("tuning.SharedMemoryTransport", false);
+	intra_process_inlets_ = pt.get("tuning.IntraProcessInlets", false);
+	busy_poll_ = pt.get("tuning.BusyPoll", false);
+	busy_poll_spins_ = pt.get("tuning.BusyPollSpins", 10000);
+	sample_pool_trim_interval_ = pt.get("tuning.SamplePoolTrimInterval", 10.0);
+	overflow_block_timeout_ = pt.get("tuning.OverflowBlockTimeout", 0.5);
+	feed_compression_ = pt.get("tuning.FeedCompression", false);
 }
 
 static std::once_flag api_config_once_flag;
@@ -230,6 +230,24 @@ public:
 	float smoothing_halftime() const { return smoothing_halftime_; }
 	/// Override timestamps with lsl clock if True
 	bool force_default_timestamps() const { return force_default_timestamps_; }
+	/// Send samples to inlets from the outlet's IO thread instead of one thread per inlet
+	bool async_transfer() const { return async_transfer_; }
+	/// Number of IO threads shared by all outlets and inlets, or 0 for dedicated threads
+	int shared_io_threads() const { return shared_io_threads_; }
+	/// Let inlets request a shared memory transfer from outlets on the same host
+	bool shared_memory_transport() const { return shared_memory_transport_; }
+	/// Let inlets read directly from the send buffer of outlets in the same process
+	bool intra_process_inlets() const { return intra_process_inlets_; }
+	/// Let all inlets busy-poll for new samples, not only those created with transp_busy_poll
+	bool busy_poll() const { return busy_poll_; }
+	/// Number of times a busy-polling inlet checks for new data before it goes to sleep
+	int busy_poll_spins() const { return busy_poll_spins_; }
+	/// Time after which samples allocated for a burst are released again, in seconds (0: never)
+	double sample_pool_trim_interval() const { return sample_pool_trim_interval_; }
+	/// How long samples wait for room in full queues of inlets that block when full, in seconds
+	double overflow_block_timeout() const { return overflow_block_timeout_; }
+	/// Let all inlets ask for a compressed data feed, not only those created with transp_compress
+	bool feed_compression() const { return feed_compression_; }
 
 	/// Deleted copy constructor (noncopyable).
 	api_config(const api_config &rhs) = delete;
@@ -305,6 +323,15 @@ private:
 	int socket_receive_buffer_size_;
 	float smoothing_halftime_;
 	bool force_default_timestamps_;
+	bool async_transfer_;
+	int shared_io_threads_;
+	bool shared_memory_transport_;
+	bool intra_process_inlets_;
+	bool busy_poll_;
+	int busy_poll_spins_;
+	double sample_pool_trim_interval_;
+	double overflow_block_timeout_;
+	bool feed_compression_;
 };
 
 // initialize configuration file name
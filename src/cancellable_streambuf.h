@@ -15,9 +15,11 @@
 
 #define BOOST_ASIO_NO_DEPRECATED
 #include "cancellation.h"
+#include "stats.h"
 #include <asio/basic_stream_socket.hpp>
 #include <asio/io_context.hpp>
 #include <asio/ip/tcp.hpp>
+#include <cstdint>
 #include <exception>
 #include <streambuf>
 
@@ -78,9 +80,20 @@ public:
 		ec_ = asio::error::would_block;
 		do as_context().run_one();
 		while (!cancel_issued_ && ec_ == asio::error::would_block);
+		// busy polling needs reads that return immediately; async operations work either way
+		if (!ec_ && busy_poll_spins_) {
+			asio::error_code ec;
+			socket().non_blocking(true, ec);
+		}
 		return !ec_ ? this : nullptr;
 	}
 
+	/// Let reads poll the socket this many times before they wait for data (lsl addition).
+	void set_busy_poll_spins(uint32_t spins) { busy_poll_spins_ = spins; }
+
+	/// Add the number of received bytes to a counter (lsl addition).
+	void count_received_bytes(stat_counter *counter) { bytes_received_ = counter; }
+
 	/// Close the connection.
 	/**
 	 * @return \c this if a connection was successfully established, a null
@@ -125,9 +138,33 @@ protected:
 		// will be processed by the run_one
 	}
 
+	/**
+	 * Poll the socket for data without blocking (lsl addition).
+	 * @param bytes_transferred The number of bytes read, 0 if there was nothing to read.
+	 * @return False if the read failed.
+	 */
+	bool poll_receive(std::size_t &bytes_transferred) {
+		bytes_transferred = 0;
+		if (!busy_poll_spins_ || !socket().non_blocking()) return true;
+		for (uint32_t spin = 0; spin < busy_poll_spins_ && !cancel_issued_; ++spin) {
+			bytes_transferred =
+				socket().receive(asio::buffer(asio::buffer(get_buffer_) + putback_max), 0, ec_);
+			if (ec_ != asio::error::would_block && ec_ != asio::error::try_again) return !ec_;
+		}
+		bytes_transferred = 0;
+		return true;
+	}
+
 	int_type underflow() override {
 		if (gptr() == egptr()) {
 			std::size_t bytes_transferred_;
+			if (!poll_receive(bytes_transferred_)) return traits_type::eof();
+			if (bytes_transferred_) {
+				if (bytes_received_) bytes_received_->add(bytes_transferred_);
+				setg(&get_buffer_[0], &get_buffer_[0] + putback_max,
+					&get_buffer_[0] + putback_max + bytes_transferred_);
+				return traits_type::to_int_type(*gptr());
+			}
 			socket().async_receive(asio::buffer(asio::buffer(get_buffer_) + putback_max),
 				[this, &bytes_transferred_](
 					const asio::error_code &ec, std::size_t bytes_transferred = 0) {
@@ -141,6 +178,7 @@ protected:
 			while (!cancel_issued_ && ec_ == asio::error::would_block);
 			if (ec_) return traits_type::eof();
 
+			if (bytes_received_) bytes_received_->add(bytes_transferred_);
 			setg(&get_buffer_[0], &get_buffer_[0] + putback_max,
 				&get_buffer_[0] + putback_max + bytes_transferred_);
 			return traits_type::to_int_type(*gptr());
@@ -195,6 +233,8 @@ protected:
 	asio::error_code ec_;
 	std::atomic<bool> cancel_issued_{false};
 	bool cancel_started_{false};
+	uint32_t busy_poll_spins_{0};
+	stat_counter *bytes_received_{nullptr};
 	std::recursive_mutex cancel_mut_;
 };
 } // namespace lsl
@@ -0,0 +1,263 @@
+#include "compiled_query.h"
+#include "api_config.h"
+#include "stream_info_impl.h"
+#include "util/cast.hpp"
+#include "util/lru_cache.hpp"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <string_view>
+
+namespace lsl {
+
+/**
+ * Recursive descent parser for the supported subset of XPath:
+ *
+ *     or_expr   := and_expr ('or' and_expr)*
+ *     and_expr  := primary ('and' primary)*
+ *     primary   := '(' or_expr ')' | 'not' '(' or_expr ')'
+ *                | ('starts-with' | 'contains') '(' string_field ',' literal ')'
+ *                | string_field ('=' | '!=') literal
+ *                | number_field ('=' | '!=' | '<' | '<=' | '>' | '>=') number
+ *
+ * Anything else makes parse() fail, so the query is evaluated as XPath instead.
+ */
+class compiled_query::parser {
+public:
+	parser(const std::string &query, std::vector<term> &terms)
+		: p_(query.c_str()), terms_(terms) {}
+
+	/// Parse the whole query, return false if it's not of the supported form.
+	bool parse() { return parse_or() && (skip_ws(), *p_ == 0); }
+
+private:
+	bool parse_or() { return parse_binary(op::op_or, "or", &parser::parse_and); }
+	bool parse_and() { return parse_binary(op::op_and, "and", &parser::parse_primary); }
+
+	/// Parse a left-associative chain of operands joined by the keyword.
+	bool parse_binary(op operation, const char *keyword, bool (parser::*operand)()) {
+		const std::size_t start = terms_.size();
+		if (!(this->*operand)()) return false;
+		while (accept_keyword(keyword)) {
+			// the operation goes in front of its left operand
+			terms_.insert(terms_.begin() + start, term(operation));
+			if (!(this->*operand)()) return false;
+		}
+		return true;
+	}
+
+	bool parse_primary() {
+		if (accept('(')) return parse_or() && accept(')');
+		std::string name;
+		if (!read_name(name)) return false;
+		if (accept('(')) {
+			// function call
+			if (name == "not") {
+				terms_.emplace_back(op::op_not);
+				return parse_or() && accept(')');
+			}
+			if (name != "starts-with" && name != "contains") return false;
+			term t(name == "starts-with" ? op::starts_with : op::contains);
+			if (!read_name(name) || !lookup_field(name, t.lhs) || !is_string_field(t.lhs) ||
+				!accept(',') || !read_literal(t.str) || !accept(')'))
+				return false;
+			terms_.push_back(std::move(t));
+			return true;
+		}
+		// comparison
+		term t(op::equal);
+		if (!lookup_field(name, t.lhs) || !read_comparison(t.operation)) return false;
+		if (is_string_field(t.lhs)) {
+			// relational operators would compare the strings as numbers
+			if (t.operation != op::equal && t.operation != op::not_equal) return false;
+			if (!read_literal(t.str)) return false;
+		} else if (!read_number(t.num))
+			return false;
+		terms_.push_back(std::move(t));
+		return true;
+	}
+
+	void skip_ws() {
+		while (*p_ == ' ' || *p_ == '\t' || *p_ == '\r' || *p_ == '\n') ++p_;
+	}
+
+	bool accept(char c) {
+		skip_ws();
+		if (*p_ != c) return false;
+		++p_;
+		return true;
+	}
+
+	bool accept_keyword(const char *keyword) {
+		skip_ws();
+		const char *p = p_;
+		std::string name;
+		if (read_name(name) && name == keyword) return true;
+		p_ = p;
+		return false;
+	}
+
+	static bool is_name_start(char c) {
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+	}
+	static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+	/// Read an element or function name (as in XPath, names may contain '-' and '.').
+	bool read_name(std::string &name) {
+		skip_ws();
+		if (!is_name_start(*p_)) return false;
+		const char *begin = p_;
+		while (is_name_start(*p_) || is_digit(*p_) || *p_ == '-' || *p_ == '.') ++p_;
+		// namespace prefixes, axes etc. aren't supported
+		if (*p_ == ':') return false;
+		name.assign(begin, p_);
+		return true;
+	}
+
+	bool read_literal(std::string &value) {
+		skip_ws();
+		const char quote = *p_;
+		if (quote != '\'' && quote != '"') return false;
+		const char *end = std::strchr(p_ + 1, quote);
+		if (!end) return false;
+		value.assign(p_ + 1, end);
+		p_ = end + 1;
+		return true;
+	}
+
+	bool read_number(double &value) {
+		skip_ws();
+		const char *begin = p_;
+		if (*p_ == '-') ++p_;
+		bool digits = false;
+		for (; is_digit(*p_); ++p_) digits = true;
+		if (*p_ == '.')
+			for (++p_; is_digit(*p_); ++p_) digits = true;
+		if (!digits) return false;
+		value = from_string<double>(std::string(begin, p_));
+		return true;
+	}
+
+	bool read_comparison(op &operation) {
+		skip_ws();
+		switch (*p_++) {
+		case '=': operation = op::equal; return true;
+		case '!': operation = op::not_equal; return *p_++ == '=';
+		case '<': operation = op::less; break;
+		case '>': operation = op::greater; break;
+		default: return false;
+		}
+		if (*p_ == '=') {
+			++p_;
+			operation = operation == op::less ? op::less_equal : op::greater_equal;
+		}
+		return true;
+	}
+
+	static bool lookup_field(const std::string &name, field &result) {
+		static const std::pair<const char *, field> fields[] = {{"name", field::name},
+			{"type", field::type}, {"channel_format", field::channel_format},
+			{"source_id", field::source_id}, {"uid", field::uid},
+			{"session_id", field::session_id}, {"hostname", field::hostname},
+			{"v4address", field::v4address}, {"v6address", field::v6address},
+			{"channel_count", field::channel_count}, {"nominal_srate", field::nominal_srate}};
+		for (const auto &f : fields)
+			if (name == f.first) {
+				result = f.second;
+				return true;
+			}
+		return false;
+	}
+
+	static bool is_string_field(field f) {
+		return f != field::channel_count && f != field::nominal_srate;
+	}
+
+	const char *p_;
+	std::vector<term> &terms_;
+};
+
+compiled_query::compiled_query(const std::string &query) {
+	if (!parser(query, terms_).parse()) {
+		terms_.clear();
+		xpath_ = std::make_unique<pugi::xpath_query>(query.c_str());
+	}
+}
+
+std::shared_ptr<const compiled_query> compiled_query::get(const std::string &query) {
+	static std::mutex mut;
+	static lru_cache<std::shared_ptr<const compiled_query>> cache(
+		std::max(api_config::get_instance()->max_cached_queries(), 0));
+
+	{
+		std::lock_guard<std::mutex> lock(mut);
+		if (auto *cached = cache.find(query)) return *cached;
+	}
+	// compile outside the lock; if another thread compiles the same query, one of them wins
+	auto compiled = std::make_shared<const compiled_query>(query);
+	std::lock_guard<std::mutex> lock(mut);
+	cache.insert(query, compiled);
+	return compiled;
+}
+
+/// the strings of the channel formats, as in the XML document
+static const char *channel_format_strings[] = {
+	"undefined", "float32", "double64", "string", "int32", "int16", "int8", "int64"};
+
+bool compiled_query::matches(const stream_info_impl &info) const {
+	std::size_t pos = 0;
+	return eval(info, pos);
+}
+
+bool compiled_query::eval(const stream_info_impl &info, std::size_t &pos) const {
+	const term &t = terms_[pos++];
+	switch (t.operation) {
+	case op::op_and: {
+		// both operands are evaluated, so pos ends up behind the second one
+		const bool lhs = eval(info, pos);
+		return eval(info, pos) && lhs;
+	}
+	case op::op_or: {
+		const bool lhs = eval(info, pos);
+		return eval(info, pos) || lhs;
+	}
+	case op::op_not: return !eval(info, pos);
+	default: break;
+	}
+
+	if (t.lhs == field::channel_count || t.lhs == field::nominal_srate) {
+		const double num = t.lhs == field::channel_count
+							   ? info.channel_count()
+							   // compare the value in the XML document, i.e. with 16 digits
+							   : from_string<double>(to_string(info.nominal_srate()));
+		switch (t.operation) {
+		case op::equal: return num == t.num;
+		case op::not_equal: return num != t.num;
+		case op::less: return num < t.num;
+		case op::less_equal: return num <= t.num;
+		case op::greater: return num > t.num;
+		default: return num >= t.num;
+		}
+	}
+
+	std::string_view str;
+	switch (t.lhs) {
+	case field::name: str = info.name(); break;
+	case field::type: str = info.type(); break;
+	case field::channel_format: str = channel_format_strings[info.channel_format()]; break;
+	case field::source_id: str = info.source_id(); break;
+	case field::uid: str = info.uid(); break;
+	case field::session_id: str = info.session_id(); break;
+	case field::hostname: str = info.hostname(); break;
+	case field::v4address: str = info.v4address(); break;
+	default: str = info.v6address(); break;
+	}
+	switch (t.operation) {
+	case op::equal: return str == t.str;
+	case op::not_equal: return str != t.str;
+	case op::starts_with: return str.compare(0, t.str.size(), t.str) == 0;
+	default: return str.find(t.str) != std::string_view::npos;
+	}
+}
+
+} // namespace lsl
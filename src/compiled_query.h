@@ -0,0 +1,105 @@
+#ifndef COMPILED_QUERY_H
+#define COMPILED_QUERY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <pugixml.hpp>
+#include <string>
+#include <vector>
+
+namespace lsl {
+class stream_info_impl;
+
+/**
+ * A query (an XPath 1.0 predicate over the stream info's XML) in a form that's fast to evaluate.
+ *
+ * The common kinds of queries, i.e. comparisons of the stream info's fields with constants
+ * (`name='X'`, `channel_count>5`), `starts-with(field,'X')`, `contains(field,'X')`, `not(...)`
+ * and combinations with `and`/`or`, are compiled to predicates that are evaluated against the
+ * fields of the stream_info_impl directly. Anything else is compiled to an XPath query that has to
+ * be evaluated against the XML document.
+ *
+ * Compiled queries are immutable, so they can be shared by all stream infos in a process (see
+ * get()).
+ */
+class compiled_query {
+public:
+	/**
+	 * Compile a query.
+	 * @throws pugi::xpath_exception if the query is not a valid XPath expression.
+	 */
+	explicit compiled_query(const std::string &query);
+
+	/**
+	 * Get the compiled form of a query from a process-wide cache of the most recently used
+	 * queries (see api_config::max_cached_queries()), compiling it if necessary.
+	 * @throws pugi::xpath_exception if the query is not a valid XPath expression.
+	 */
+	static std::shared_ptr<const compiled_query> get(const std::string &query);
+
+	/// Whether the query has to be evaluated against the XML document with matches_xml().
+	bool needs_xml() const { return terms_.empty(); }
+
+	/// Evaluate a query that doesn't need the XML document against the fields of a stream info.
+	bool matches(const stream_info_impl &info) const;
+
+	/// Evaluate the query against the `<info>` element of a stream info's XML document.
+	bool matches_xml(const pugi::xml_node &info) const { return xpath_->evaluate_boolean(info); }
+
+private:
+	/// the stream info fields a predicate can refer to
+	enum class field : uint8_t {
+		name,
+		type,
+		channel_format,
+		source_id,
+		uid,
+		session_id,
+		hostname,
+		v4address,
+		v6address,
+		channel_count,
+		nominal_srate
+	};
+
+	/// The operation of a term. Terms are stored in prefix order, i.e. the operands of a logical
+	/// operation follow it.
+	enum class op : uint8_t {
+		op_and,
+		op_or,
+		op_not,
+		equal,
+		not_equal,
+		less,
+		less_equal,
+		greater,
+		greater_equal,
+		starts_with,
+		contains
+	};
+
+	struct term {
+		explicit term(op operation) : operation(operation) {}
+
+		op operation;
+		field lhs{field::name};
+		/// the constant to compare the field with
+		std::string str;
+		double num{0};
+	};
+
+	class parser;
+
+	/// Evaluate the term at pos (and its operands), and advance pos past them.
+	bool eval(const stream_info_impl &info, std::size_t &pos) const;
+
+	/// the predicate, empty if the query has to be evaluated as XPath
+	std::vector<term> terms_;
+	/// the XPath query, if needed
+	std::unique_ptr<pugi::xpath_query> xpath_;
+};
+
+} // namespace lsl
+
+#endif
@@ -1,4 +1,5 @@
 #include "consumer_queue.h"
+#include "api_config.h"
 #include "common.h"
 #include "send_buffer.h"
 #include <chrono>
@@ -7,12 +8,16 @@
 
 using namespace lsl;
 
-consumer_queue::consumer_queue(std::size_t size, send_buffer_p registry)
+consumer_queue::consumer_queue(std::size_t size, send_buffer_p registry,
+	std::function<void()> on_push, overflow_policy policy)
 	: buffer_(new item_t[size]), size_(size),
 	  // largest integer at which we can wrap correctly
 	  wrap_at_(std::numeric_limits<std::size_t>::max() - size -
 			   std::numeric_limits<std::size_t>::max() % size),
-	  registry_(std::move(registry)) {
+	  registry_(std::move(registry)), on_push_(std::move(on_push)), policy_(policy),
+	  block_timeout_(policy == overflow_policy::block
+						 ? api_config::get_instance()->overflow_block_timeout()
+						 : 0.0) {
 	assert(size_ > 1);
 	for (std::size_t i = 0; i < size_; ++i)
 		buffer_[i].seq_state.store(i, std::memory_order_release);
@@ -20,6 +25,8 @@ consumer_queue::consumer_queue(std::size_t size, send_buffer_p registry)
 }
 
 consumer_queue::~consumer_queue() {
+	// the send buffer waits for a push that might be waiting for us to make room
+	closing_.store(true, std::memory_order_release);
 	try {
 		if (registry_) registry_->unregister_consumer(this);
 	} catch (std::exception &e) {
@@ -32,10 +39,43 @@ consumer_queue::~consumer_queue() {
 
 uint32_t consumer_queue::flush() noexcept {
 	uint32_t n = 0;
-	while (try_pop()) n++;
+	while (std::size_t popped = try_pop_chunk(nullptr, size_)) n += static_cast<uint32_t>(popped);
 	return n;
 }
 
+bool consumer_queue::wait_for_room() {
+	const uint64_t popped = pop_seq_.load(std::memory_order_relaxed);
+	// don't wait for consumers that haven't popped anything since they last let us down
+	if (stalled_ && popped == stalled_at_) return false;
+	stalled_ = false;
+	// the consumer might be asleep while the samples pushed so far wait for it
+	notify_consumer();
+	const auto deadline =
+		std::chrono::steady_clock::now() + std::chrono::duration<double>(block_timeout_);
+	for (;;) {
+		const std::size_t write_index = write_idx_.load(std::memory_order_relaxed);
+		if (buffer_[write_index % size_].seq_state.load(std::memory_order_acquire) == write_index)
+			return true;
+		if (closing_.load(std::memory_order_acquire) ||
+			std::chrono::steady_clock::now() >= deadline)
+			break;
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+	stalled_ = true;
+	stalled_at_ = pop_seq_.load(std::memory_order_relaxed);
+	return false;
+}
+
+bool consumer_queue::arm_push_notification() {
+	push_notification_armed_.store(true, std::memory_order_relaxed);
+	// pairs with the fence in notify_consumer()
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (empty()) return true;
+	// samples arrived in the meantime, so take the notification back unless the producer has
+	// already consumed it
+	return !push_notification_armed_.exchange(false, std::memory_order_acq_rel);
+}
+
 std::size_t consumer_queue::read_available() const {
 	std::size_t write_index = write_idx_.load(std::memory_order_acquire);
 	std::size_t read_index = read_idx_.load(std::memory_order_relaxed);
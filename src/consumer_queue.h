@@ -3,8 +3,10 @@
 
 #include "common.h"
 #include "sample.h"
+#include "stats.h"
 #include <atomic>
 #include <condition_variable>
+#include <functional>
 #include <mutex>
 #include <thread>
 
@@ -31,10 +33,22 @@ template <typename E1, typename E2, typename... T> struct Padding {
 	const char pad[padding<E1, E2, T...>()]{0};
 };
 
+/// What a consumer_queue does when a sample is pushed while it's full.
+enum class overflow_policy {
+	/// drop the oldest sample in the queue (the default)
+	drop_oldest,
+	/// drop the new sample
+	drop_newest,
+	/// let the producer wait until the consumer makes room, up to a timeout (afterwards, the
+	/// oldest samples are dropped until the consumer pops something again)
+	block
+};
+
 /**
  * A thread-safe producer/consumer queue of unread samples.
  *
- * Erases the oldest samples if max capacity is exceeded. Implemented as a ring buffer (wait-free
+ * Drops samples if max capacity is exceeded, as per its overflow_policy, and tells consumers how
+ * many samples were dropped before each one they pop. Implemented as a ring buffer (wait-free
  * unless the buffer is full or empty).
  */
 class consumer_queue {
@@ -45,50 +59,119 @@ public:
 	 * the oldest samples are dropped.
 	 * @param registry Optionally a pointer to a registration facility, for multiple-reader
 	 * arrangements.
+	 * @param on_push Optionally a callback that is invoked by the producer after pushing samples
+	 * if it has been armed with arm_push_notification(), for consumers that don't block on the
+	 * queue. The callback should return quickly, e.g. by posting a handler to an io_context.
+	 * @param policy What to do with new samples if the queue is full. The timeout for
+	 * overflow_policy::block is the api_config's overflow_block_timeout().
 	 */
-	explicit consumer_queue(std::size_t size, send_buffer_p registry = send_buffer_p());
+	explicit consumer_queue(std::size_t size, send_buffer_p registry = send_buffer_p(),
+		std::function<void()> on_push = nullptr,
+		overflow_policy policy = overflow_policy::drop_oldest);
 
 	/// Destructor. Unregisters from the send buffer, if any.
 	~consumer_queue();
 
 	/**
 	 * Push a new sample onto the queue. Can only be called by one thread (single-producer).
-	 * This deletes the oldest sample if the max capacity is exceeded.
+	 * If the max capacity is exceeded, the overflow policy decides which sample is dropped.
+	 * @param now The current time as per latency_histogram::now(), to measure how long the sample
+	 * stays in the queue.
+	 * @param skipped The number of samples the producer lost before this one (e.g., further
+	 * upstream). They're reported to the consumer like samples dropped by the queue.
 	 */
-	template <class T> void push_sample(T &&sample) {
-		while (!try_push(std::forward<T>(sample))) {
-			// buffer full, drop oldest sample
-			if (!done_sync_.load(std::memory_order_acquire)) {
-				// synchronizes-with store to done_sync_ in ctor
-				std::atomic_thread_fence(std::memory_order_acquire);
-				done_sync_.store(true, std::memory_order_release);
-			}
-			try_pop();
+	template <class T>
+	void push_sample(T &&sample, int64_t now = latency_histogram::now(), uint32_t skipped = 0) {
+		next_seq_ += skipped;
+		stats_.pushed.add();
+		if (UNLIKELY(!try_push(std::forward<T>(sample), now))) {
+			if (!make_room(sample != nullptr)) return;
+			while (!try_push(std::forward<T>(sample), now)) drop_oldest();
 		}
-		{
-			// ensure that notify_one doesn't happen in between try_pop and wait_for
-			std::lock_guard<std::mutex> lk(mut_);
-			cv_.notify_one();
+		notify_consumer();
+	}
+
+	/**
+	 * Push a batch of samples onto the queue. Can only be called by one thread (single-producer).
+	 * Like push_sample(), this drops samples as per the overflow policy if the max capacity is
+	 * exceeded, but a waiting consumer is woken up only once for the whole batch.
+	 */
+	void push_chunk(
+		const sample_p *samples, std::size_t n, int64_t now = latency_histogram::now()) {
+		std::size_t write_index = write_idx_.load(std::memory_order_acquire);
+		for (const sample_p *end = samples + n; samples != end; ++samples) {
+			item_t &item = buffer_[write_index % size_];
+			if (UNLIKELY(write_index != item.seq_state.load(std::memory_order_acquire))) {
+				// buffer full: publish what we have so far and make room (unless the new sample
+				// is dropped instead)
+				write_idx_.store(write_index, std::memory_order_release);
+				if (!make_room(*samples != nullptr)) continue;
+				while (write_index != item.seq_state.load(std::memory_order_acquire))
+					drop_oldest();
+			}
+			write_index = add1_wrap(write_index);
+			item.value = *samples;
+			item.pushed_at = now;
+			item.seq = next_seq_++;
+			item.seq_state.store(write_index, std::memory_order_release);
 		}
+		write_idx_.store(write_index, std::memory_order_release);
+		stats_.pushed.add(n);
+		notify_consumer();
 	}
 
 	/**
 	 * Pop a sample from the queue. Can be called by multiple threads (multi-consumer).
 	 * Blocks if empty and if a nonzero timeout is used.
 	 * @param timeout Timeout for the blocking, in seconds. If expired, an empty sample is returned.
+	 * @param dropped Optionally receives the number of samples that were dropped (or skipped by
+	 * the producer) between the previously popped sample and this one.
 	 */
-	sample_p pop_sample(double timeout = FOREVER) {
+	sample_p pop_sample(double timeout = FOREVER, uint32_t *dropped = nullptr) {
 		sample_p result;
-		bool success = try_pop(result);
-		if (!success && timeout > 0.0) {
-			// only acquire mutex if we have to do a blocking wait with timeout
-			std::chrono::duration<double> sec(timeout);
-			std::unique_lock<std::mutex> lk(mut_);
-			if (!try_pop(result)) cv_.wait_for(lk, sec, [&] { return this->try_pop(result); });
-		}
+		if (!try_pop(&result, dropped) && timeout > 0.0)
+			wait_for([&] { return try_pop(&result, dropped); }, timeout);
 		return result;
 	}
 
+	/**
+	 * Pop up to max_n samples from the queue into out. Can be called by multiple threads
+	 * (multi-consumer); all samples that are ready are claimed at once.
+	 * Blocks if empty and if a nonzero timeout is used.
+	 * @param timeout Timeout for the blocking, in seconds.
+	 * @param dropped Optionally an array of max_n entries that receive the number of samples that
+	 * were dropped before each popped sample (see pop_sample()).
+	 * @return The number of samples that were popped (0 if the timeout expired).
+	 */
+	std::size_t pop_chunk(sample_p *out, std::size_t max_n, double timeout = FOREVER,
+		uint32_t *dropped = nullptr) {
+		std::size_t n = try_pop_chunk(out, max_n, dropped);
+		if (!n && timeout > 0.0)
+			wait_for([&] { return (n = try_pop_chunk(out, max_n, dropped)) != 0; }, timeout);
+		return n;
+	}
+
+	/**
+	 * Statistics about the samples that went through the queue.
+	 * The bytes counter is maintained by the network transfer that feeds or drains the queue.
+	 */
+	queue_stats &stats() noexcept { return stats_; }
+	const queue_stats &stats() const noexcept { return stats_; }
+
+	/**
+	 * Let blocking pops retry a number of times before they go to sleep.
+	 * This trades CPU time for latency when the next sample is expected very soon.
+	 */
+	void set_wait_spins(uint32_t spins) { wait_spins_ = spins; }
+
+	/**
+	 * Arm the push notification, i.e. let the producer invoke the on_push callback once after
+	 * the next push.
+	 * @return False if samples arrived in the meantime and the notification was not armed, i.e.
+	 * the caller should pop them instead of waiting for the callback.
+	 */
+	bool arm_push_notification();
+
 	/// Number of available samples. This is approximate unless called by the thread calling the
 	/// pop_sample().
 	std::size_t read_available() const;
@@ -110,11 +193,15 @@ private:
 	struct item_t {
 		std::atomic<std::size_t> seq_state;
 		sample_p value;
+		/// when the sample was pushed, as per latency_histogram::now()
+		int64_t pushed_at;
+		/// sequence number of the sample, to detect gaps left by dropped samples
+		uint64_t seq;
 	};
 
 	// Push a new element to the queue.
 	// Returns true if successful or false if queue full.
-	template <class T> bool try_push(T &&sample) {
+	template <class T> bool try_push(T &&sample, int64_t now) {
 		std::size_t write_index = write_idx_.load(std::memory_order_acquire);
 		std::size_t next_idx = add1_wrap(write_index);
 		item_t &item = buffer_[write_index % size_];
@@ -122,13 +209,16 @@ private:
 			return false; // item currently occupied, queue full
 		write_idx_.store(next_idx, std::memory_order_release);
 		copy_or_move(item.value, std::forward<T>(sample));
+		item.pushed_at = now;
+		item.seq = next_seq_++;
 		item.seq_state.store(next_idx, std::memory_order_release);
 		return true;
 	}
 
-	// Pop an element from the queue (can be called with zero or one argument). Returns true if
+	// Pop an element from the queue and move it to result (or drop it if result is nullptr), and
+	// store the number of samples dropped before it in dropped (if given). Returns true if
 	// successful or false if queue is empty. Uses the same method as Vyukov's bounded MPMC queue.
-	template <class... T> bool try_pop(T &...result) {
+	bool try_pop(sample_p *result = nullptr, uint32_t *dropped = nullptr) {
 		item_t *item;
 		std::size_t read_index = read_idx_.load(std::memory_order_relaxed);
 		for (;;) {
@@ -147,18 +237,142 @@ private:
 				// we're behind or ahead of another pop, try again
 				read_index = read_idx_.load(std::memory_order_relaxed);
 		}
-		move_or_drop(item->value, result...);
+		// only samples that are handed to a consumer count towards the dwell time and the gaps
+		if (result) {
+			stats_.dwell.record_since(item->pushed_at, latency_histogram::now());
+			uint64_t expected = pop_seq_.load(std::memory_order_relaxed);
+			const uint32_t gap = gap_before(item->seq, expected);
+			pop_seq_.store(expected, std::memory_order_relaxed);
+			if (dropped) *dropped = gap;
+			*result = std::move(item->value);
+		} else
+			item->value.reset();
 		// mark item as free for next pass
 		item->seq_state.store(add_wrap(read_index, size_), std::memory_order_release);
 		return true;
 	}
 
+	// Pop up to max_n consecutive elements from the queue and move them to out (or drop them if
+	// out is nullptr), with the number of samples dropped before each in dropped (if given). The
+	// whole run is claimed with a single CAS on read_idx_.
+	// Returns the number of popped elements, i.e. 0 if the queue is empty.
+	std::size_t try_pop_chunk(sample_p *out, std::size_t max_n, uint32_t *dropped = nullptr) {
+		std::size_t read_index = read_idx_.load(std::memory_order_relaxed), n, end_index;
+		for (;;) {
+			// find the run of items that are ready to be popped
+			std::size_t seq_state = 0;
+			for (n = 0, end_index = read_index; n < max_n; ++n) {
+				const std::size_t next_idx = add1_wrap(end_index);
+				seq_state = buffer_[end_index % size_].seq_state.load(std::memory_order_acquire);
+				if (seq_state != next_idx) break;
+				end_index = next_idx;
+			}
+			if (LIKELY(n > 0)) {
+				// try to claim all of them at once
+				if (LIKELY(read_idx_.compare_exchange_weak(
+						read_index, end_index, std::memory_order_relaxed)))
+					break;
+			} else if (LIKELY(seq_state == read_index) || max_n == 0)
+				return 0; // queue empty
+			else
+				// we're behind or ahead of another pop, try again
+				read_index = read_idx_.load(std::memory_order_relaxed);
+		}
+		const int64_t now = out ? latency_histogram::now() : 0;
+		uint64_t expected = pop_seq_.load(std::memory_order_relaxed);
+		for (std::size_t i = 0; i < n; ++i, read_index = add1_wrap(read_index)) {
+			item_t &item = buffer_[read_index % size_];
+			if (out) {
+				stats_.dwell.record_since(item.pushed_at, now);
+				const uint32_t gap = gap_before(item.seq, expected);
+				if (dropped) dropped[i] = gap;
+				out[i] = std::move(item.value);
+			} else
+				item.value.reset();
+			// mark item as free for next pass
+			item.seq_state.store(add_wrap(read_index, size_), std::memory_order_release);
+		}
+		// flushed samples aren't gaps, but the ones dropped before them are still reported with
+		// the next popped sample
+		pop_seq_.store(out ? expected : expected + n, std::memory_order_relaxed);
+		return n;
+	}
+
+	/// The number of samples missing before the one with sequence number seq, given the expected
+	/// sequence number (which is advanced past seq).
+	static uint32_t gap_before(uint64_t seq, uint64_t &expected) noexcept {
+		const uint64_t gap = seq > expected ? seq - expected : 0;
+		expected = seq + 1;
+		return gap > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(gap);
+	}
+
+	/**
+	 * Make room for a new sample as per the overflow policy (called by the producer if full).
+	 * @param droppable Whether the new sample may be dropped instead of an old one.
+	 * @return False if the new sample was dropped, otherwise the caller has to retry the push
+	 * (and drop the oldest sample if that fails).
+	 */
+	bool make_room(bool droppable) {
+		if (policy_ == overflow_policy::drop_newest && droppable) {
+			++next_seq_;
+			stats_.dropped.add();
+			return false;
+		}
+		if (policy_ != overflow_policy::block || !wait_for_room()) drop_oldest();
+		return true;
+	}
+
+	/// Wait until the consumer has made room or the blocking timeout expires.
+	bool wait_for_room();
+
+	/// Drop the oldest sample to make room for a new one (called by the producer if full).
+	void drop_oldest() {
+		if (!done_sync_.load(std::memory_order_acquire)) {
+			// synchronizes-with store to done_sync_ in ctor
+			std::atomic_thread_fence(std::memory_order_acquire);
+			done_sync_.store(true, std::memory_order_release);
+		}
+		if (try_pop()) stats_.dropped.add();
+	}
+
+	/// Wait until pop() succeeds or the timeout expires.
+	template <class F> void wait_for(F &&pop, double timeout) {
+		for (uint32_t spin = 0; spin < wait_spins_; ++spin) {
+			std::this_thread::yield();
+			if (pop()) return;
+		}
+		// announce that we're going to sleep, so the producer knows that it has to wake us up
+		waiting_.fetch_add(1, std::memory_order_relaxed);
+		// pairs with the fence in notify_consumer(): either the producer sees us waiting or we
+		// see the samples it has pushed
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		{
+			std::unique_lock<std::mutex> lk(mut_);
+			if (!pop()) cv_.wait_for(lk, std::chrono::duration<double>(timeout), pop);
+		}
+		waiting_.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	/// Wake up a consumer that might be blocked in pop_sample() or waiting for the push
+	/// notification.
+	void notify_consumer() {
+		// pairs with the fences in wait_for() and arm_push_notification(): either we see the
+		// waiting consumer (or the armed flag) or the consumer sees the samples we just pushed
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (on_push_ && push_notification_armed_.load(std::memory_order_relaxed) &&
+			push_notification_armed_.exchange(false, std::memory_order_acq_rel))
+			on_push_();
+		// only take the mutex (and make the system call) if a consumer is actually asleep
+		if (waiting_.load(std::memory_order_relaxed)) {
+			// ensure that notify_one doesn't happen in between pop() and wait_for
+			std::lock_guard<std::mutex> lk(mut_);
+			cv_.notify_one();
+		}
+	}
+
 	// helper to either copy or move a value, depending on whether it's an rvalue ref
 	inline static void copy_or_move(sample_p &dst, const sample_p &src) { dst = src; }
 	inline static void copy_or_move(sample_p &dst, sample_p &&src) { dst = std::move(src); }
-	// helper to either move or drop a value, depending on whether a dst argument is given
-	inline static void move_or_drop(sample_p &src) { src.reset(); }
-	inline static void move_or_drop(sample_p &src, sample_p &dst) { dst = std::move(src); }
 
 	/// helper to add a delta to the given index and wrap correctly
 	inline std::size_t add_wrap(std::size_t x, std::size_t delta) const noexcept {
@@ -177,9 +391,17 @@ private:
 	std::condition_variable cv_;
 	/// the sample buffer
 	item_t *buffer_;
+	/// number of consumers that sleep (or are about to) until the producer notifies them
+	std::atomic<int> waiting_{0};
+	/// number of retries of a blocking pop before it goes to sleep
+	uint32_t wait_spins_{0};
+	/// sequence number of the next sample the consumers expect, i.e. anything below it that they
+	/// haven't seen was dropped
+	std::atomic<uint64_t> pop_seq_{0};
 
 	/// padding to ensure read_idx_ and write_idx_ don't share a cacheline
-	Padding<std::size_t, std::size_t, std::condition_variable, void *> pad;
+	Padding<std::size_t, std::size_t, std::condition_variable, void *, int, uint32_t, uint64_t>
+		pad;
 
 	/// current write position
 	std::atomic<std::size_t> write_idx_{0};
@@ -192,14 +414,34 @@ private:
 
 	/// optional consumer registry
 	send_buffer_p registry_;
+	/// optional callback for consumers that wait for a push notification
+	const std::function<void()> on_push_;
 
 	/// padding to ensure write_ix_ and done_sync_ don't share a cacheline
 #if UINTPTR_MAX <= 0xFFFFFFFF
-	Padding<std::size_t, bool, std::size_t, std::size_t, std::mutex, send_buffer_p> pad2;
+	Padding<std::size_t, bool, std::size_t, std::size_t, std::mutex, send_buffer_p,
+		std::function<void()>>
+		pad2;
 #endif
 
 	/// whether we have performed a sync on the data stored by the constructor
 	std::atomic<bool> done_sync_{false};
+	/// whether the producer should invoke on_push_ after the next push
+	std::atomic<bool> push_notification_armed_{false};
+	/// sequence number of the next pushed sample (producer only)
+	uint64_t next_seq_{0};
+	/// what to do if the queue is full
+	const overflow_policy policy_;
+	/// how long the producer waits for room with overflow_policy::block
+	const double block_timeout_;
+	/// set when the queue is destroyed, so a producer stops waiting for room
+	std::atomic<bool> closing_{false};
+	/// set if the last wait for room timed out, together with the consumers' pop_seq_ back then,
+	/// so the producer doesn't wait again until they pop something (producer only)
+	bool stalled_{false};
+	uint64_t stalled_at_{0};
+	/// statistics, updated by the producer (counters) and the consumers (dwell times)
+	queue_stats stats_;
 };
 
 } // namespace lsl
@@ -1,18 +1,27 @@
 #include "data_receiver.h"
 #include "api_config.h"
 #include "cancellable_streambuf.h"
+#include "feed_compression.h"
 #include "inlet_connection.h"
+#include "local_outlets.h"
 #include "sample.h"
+#include "send_buffer.h"
+#include "shm_ring.h"
 #include "socket_utils.h"
 #include "util/cast.hpp"
 #include "util/endian.hpp"
 #include "util/strfuns.hpp"
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <exception>
 #include <iostream>
 #include <loguru.hpp>
 #include <memory>
+#include <new>
 #include <string>
+#include <thread>
 #include <vector>
 
 // a convention that applies when including portable_oarchive.h in multiple .cpp files.
@@ -23,7 +32,19 @@
 
 namespace lsl {
 
-data_receiver::data_receiver(inlet_connection &conn, int max_buflen, int max_chunklen)
+/// maximum number of samples that pull_chunk_typed() takes off the queue at once
+const std::size_t max_pull_batch = 64;
+
+/// The number of times to poll for new data before going to sleep, if busy-polling is requested.
+static uint32_t busy_poll_spins(bool requested) {
+	const api_config *cfg = api_config::get_instance();
+	// spinning only pays off if the sender can make progress on another core in the meantime
+	if (!(requested || cfg->busy_poll()) || std::thread::hardware_concurrency() < 2) return 0;
+	return static_cast<uint32_t>(std::max(0, cfg->busy_poll_spins()));
+}
+
+data_receiver::data_receiver(inlet_connection &conn, int max_buflen, int max_chunklen,
+	bool busy_poll, overflow_policy overflow, bool compress)
 	: conn_(conn),
 	  sample_factory_(
 		  new factory(conn.type_info().channel_format(), conn.type_info().channel_count(),
@@ -32,11 +53,15 @@ data_receiver::data_receiver(inlet_connection &conn, int max_buflen, int max_chu
 									 api_config::get_instance()->inlet_buffer_reserve_ms() / 1000)
 				  : api_config::get_instance()->inlet_buffer_reserve_samples())),
 	  check_thread_start_(true), closing_stream_(false), connected_(false),
-	  sample_queue_(max_buflen), max_buflen_(max_buflen), max_chunklen_(max_chunklen) {
+	  sample_queue_(max_buflen, nullptr, nullptr, overflow), max_buflen_(max_buflen),
+	  max_chunklen_(max_chunklen), busy_poll_spins_(busy_poll_spins(busy_poll)),
+	  overflow_policy_(overflow),
+	  compress_(compress || api_config::get_instance()->feed_compression()) {
 	if (max_buflen < 0)
 		throw std::invalid_argument("The max_buflen argument must not be smaller than 0.");
 	if (max_chunklen < 0)
 		throw std::invalid_argument("The max_chunklen argument must not be smaller than 0.");
+	sample_queue_.set_wait_spins(busy_poll_spins_);
 	conn_.register_onlost(this, &connected_upd_);
 }
 
@@ -59,8 +84,9 @@ void data_receiver::open_stream(double timeout) {
 	if (!connection_completed()) {
 		// start thread if not yet running
 		if (check_thread_start_ && !data_thread_.joinable()) {
-			data_thread_ = std::thread(&data_receiver::data_thread, this);
-			check_thread_start_ = false;
+			lock.unlock();
+			start_transfer();
+			lock.lock();
 		}
 		// wait until the connection attempt completes (or we time out)
 		if (timeout >= FOREVER)
@@ -77,60 +103,257 @@ void data_receiver::open_stream(double timeout) {
 void data_receiver::close_stream() {
 	check_thread_start_ = true;
 	closing_stream_ = true;
+	// stop buffering samples in the local outlet's send buffer
+	release_local_queue();
 	cancel_all_registered();
 }
 
-sample_p lsl::data_receiver::try_get_next_sample(double timeout) {
+void data_receiver::prepare_pull() {
 	if (conn_.lost())
 		throw lost_error("The stream read by this outlet has been lost. To recover, you need to "
 						 "re-resolve the source and re-create the inlet.");
-	// start data thread implicitly if necessary
-	if (check_thread_start_ && !data_thread_.joinable()) {
-		data_thread_ = std::thread(&data_receiver::data_thread, this);
-		check_thread_start_ = false;
+	// start data transfer implicitly if necessary
+	if (check_thread_start_ && !data_thread_.joinable()) start_transfer();
+}
+
+void data_receiver::start_transfer() {
+	check_thread_start_ = false;
+	// an outlet in this process pushes its samples into our queue directly (a queue holds at
+	// least two samples, and the data thread wouldn't get samples for a max_buflen of 0 either)
+	local_outlet outlet;
+	if (api_config::get_instance()->intra_process_inlets() && max_buflen_ > 1)
+		outlet = find_local_outlet(conn_.current_uid());
+	if (outlet.buffer) {
+		// the queued samples go back to their factory when the queue is destroyed, so the
+		// factory is released after that (even if the outlet is gone by then)
+		std::shared_ptr<consumer_queue> queue(
+			new consumer_queue(max_buflen_, outlet.buffer, nullptr, overflow_policy_),
+			[factory = std::move(outlet.factory)](consumer_queue *q) { delete q; });
+		queue->set_wait_spins(busy_poll_spins_);
+		{
+			std::lock_guard<std::mutex> lock(local_queue_mut_);
+			local_queue_ = std::move(queue);
+		}
+		local_srate_ = conn_.current_srate();
+		local_last_timestamp_ = 0.0;
+		{
+			std::lock_guard<std::mutex> lock(connected_mut_);
+			connected_ = true;
+		}
+		connected_upd_.notify_all();
+		return;
 	}
-	// get the sample with timeout
-	if (sample_p s = sample_queue_.pop_sample(timeout))
-		return s;
-	if (conn_.lost())
-		throw lost_error("The stream read by this inlet has been lost. To recover, you need to "
-						 "re-resolve the source and re-create the inlet.");
+	data_thread_ = std::thread(&data_receiver::data_thread, this);
+}
+
+bool data_receiver::detach_from_lost_local_outlet() {
+	// the outlet unregisters before it pushes the sentinel that wakes us up
+	{
+		std::lock_guard<std::mutex> lock(local_queue_mut_);
+		if (!local_queue_) return false;
+	}
+	if (find_local_outlet(conn_.current_uid()).buffer) return false;
+	// fall back to the data thread, which recovers the stream (or gives up) as usual
+	release_local_queue();
+	check_thread_start_ = true;
+	return true;
+}
+
+void data_receiver::release_local_queue() {
+	std::shared_ptr<consumer_queue> queue;
+	{
+		std::lock_guard<std::mutex> lock(local_queue_mut_);
+		if (!local_queue_) return;
+		released_stats_.merge(local_queue_->stats());
+		queue = std::move(local_queue_);
+	}
+	// unregistering from the send buffer might have to wait for a push, so do it without the lock
+	// (unless a pull on another thread still uses the queue, then it's destroyed after that pull)
+	queue.reset();
+}
+
+std::shared_ptr<consumer_queue> data_receiver::queue() {
+	std::lock_guard<std::mutex> lock(local_queue_mut_);
+	if (local_queue_) return local_queue_;
+	// our own queue lives as long as we do, so the pointer doesn't own it
+	return std::shared_ptr<consumer_queue>(std::shared_ptr<consumer_queue>(), &sample_queue_);
+}
+
+int32_t data_receiver::get_stats(uint64_t *stats, int32_t num_stats) {
+	queue_stats total;
+	total.merge(sample_queue_.stats());
+	{
+		std::lock_guard<std::mutex> lock(local_queue_mut_);
+		total.merge(released_stats_);
+		if (local_queue_) total.merge(local_queue_->stats());
+	}
+	return report_stats(
+		total.pushed.value(), total, sample_factory_->stats().grows, stats, num_stats);
+}
+
+double data_receiver::resolve_timestamp(const sample_p &s, uint32_t dropped) {
+	// samples from the data thread have their time stamps deduced already, but the local outlet's
+	// samples are shared with other consumers and mustn't be modified
+	double timestamp = s->timestamp();
+	if (timestamp == DEDUCED_TIMESTAMP) {
+		timestamp = local_last_timestamp_;
+		if (local_srate_ != IRREGULAR_RATE) timestamp += (1.0 + dropped) / local_srate_;
+	}
+	local_last_timestamp_ = timestamp;
+	return timestamp;
+}
+
+sample_p lsl::data_receiver::try_get_next_sample(double timeout, uint32_t &dropped) {
+	const double end_time = lsl_clock() + timeout;
+	dropped = 0;
+	do {
+		prepare_pull();
+		// get the sample with timeout; the gap before a sentinel carries over to the next sample
+		uint32_t gap = 0;
+		sample_p s = queue()->pop_sample(timeout, &gap);
+		dropped += gap;
+		if (s) return s;
+		if (conn_.lost())
+			throw lost_error("The stream read by this inlet has been lost. To recover, you need "
+							 "to re-resolve the source and re-create the inlet.");
+		timeout = std::max(0.0, end_time - lsl_clock());
+	} while (detach_from_lost_local_outlet());
 	return nullptr;
 }
 
 
 template <class T>
-double data_receiver::pull_sample_typed(T *buffer, uint32_t buffer_elements, double timeout) {
-	if(sample_p s = try_get_next_sample(timeout))
-	{
+double data_receiver::pull_sample_typed(
+	T *buffer, uint32_t buffer_elements, double timeout, uint32_t *dropped) {
+	uint32_t gap;
+	if (sample_p s = try_get_next_sample(timeout, gap)) {
+		if (dropped) *dropped = gap;
 		if (buffer_elements != conn_.type_info().channel_count())
 			throw std::range_error("The number of buffer elements provided does not match the "
 								   "number of channels in the sample.");
 		s->retrieve_typed(buffer);
-		return s->timestamp();
+		return resolve_timestamp(s, gap);
 	}
 	return 0.0;
 }
 
-template double data_receiver::pull_sample_typed<char>(char *, uint32_t, double);
-template double data_receiver::pull_sample_typed<int16_t>(int16_t *, uint32_t, double);
-template double data_receiver::pull_sample_typed<int32_t>(int32_t *, uint32_t, double);
-template double data_receiver::pull_sample_typed<int64_t>(int64_t *, uint32_t, double);
-template double data_receiver::pull_sample_typed<float>(float *, uint32_t, double);
-template double data_receiver::pull_sample_typed<double>(double *, uint32_t, double);
-template double data_receiver::pull_sample_typed<std::string>(std::string *, uint32_t, double);
+template double data_receiver::pull_sample_typed<char>(
+	char *, uint32_t, double, uint32_t *);
+template double data_receiver::pull_sample_typed<int16_t>(
+	int16_t *, uint32_t, double, uint32_t *);
+template double data_receiver::pull_sample_typed<int32_t>(
+	int32_t *, uint32_t, double, uint32_t *);
+template double data_receiver::pull_sample_typed<int64_t>(
+	int64_t *, uint32_t, double, uint32_t *);
+template double data_receiver::pull_sample_typed<float>(
+	float *, uint32_t, double, uint32_t *);
+template double data_receiver::pull_sample_typed<double>(
+	double *, uint32_t, double, uint32_t *);
+template double data_receiver::pull_sample_typed<std::string>(
+	std::string *, uint32_t, double, uint32_t *);
+
+template <class T>
+uint32_t data_receiver::pull_chunk_typed(T *buffer, double *timestamps, uint32_t max_samples,
+	double timeout, std::vector<sample_gap> *gaps) {
+	prepare_pull();
+	const uint32_t num_chans = conn_.type_info().channel_count();
+	const double end_time = timeout > 0.0 ? lsl_clock() + timeout : 0.0;
+	sample_p batch[max_pull_batch];
+	uint32_t dropped[max_pull_batch];
+	uint32_t samples_written = 0, gap = 0;
+	while (samples_written < max_samples) {
+		const std::size_t num_popped = queue()->pop_chunk(batch,
+			std::min<std::size_t>(max_samples - samples_written, max_pull_batch),
+			timeout > 0.0 ? end_time - lsl_clock() : 0.0, dropped);
+		bool got_sentinel = false;
+		for (std::size_t k = 0; k < num_popped; k++) {
+			gap += dropped[k];
+			// a blank sample is the wakeup notifier of a lost connection
+			if (!batch[k]) {
+				got_sentinel = true;
+				continue;
+			}
+			if (gap && gaps) gaps->push_back({samples_written, gap});
+			batch[k]->retrieve_typed(buffer + samples_written * num_chans);
+			timestamps[samples_written++] = resolve_timestamp(batch[k], gap);
+			batch[k].reset();
+			gap = 0;
+		}
+		if (!num_popped || got_sentinel) {
+			if (conn_.lost())
+				throw lost_error("The stream read by this inlet has been lost. To recover, you "
+								 "need to re-resolve the source and re-create the inlet.");
+			if (!detach_from_lost_local_outlet()) break;
+			prepare_pull();
+		}
+	}
+	return samples_written;
+}
+
+template uint32_t data_receiver::pull_chunk_typed<char>(
+	char *, double *, uint32_t, double, std::vector<sample_gap> *);
+template uint32_t data_receiver::pull_chunk_typed<int16_t>(
+	int16_t *, double *, uint32_t, double, std::vector<sample_gap> *);
+template uint32_t data_receiver::pull_chunk_typed<int32_t>(
+	int32_t *, double *, uint32_t, double, std::vector<sample_gap> *);
+template uint32_t data_receiver::pull_chunk_typed<int64_t>(
+	int64_t *, double *, uint32_t, double, std::vector<sample_gap> *);
+template uint32_t data_receiver::pull_chunk_typed<float>(
+	float *, double *, uint32_t, double, std::vector<sample_gap> *);
+template uint32_t data_receiver::pull_chunk_typed<double>(
+	double *, double *, uint32_t, double, std::vector<sample_gap> *);
+template uint32_t data_receiver::pull_chunk_typed<std::string>(
+	std::string *, double *, uint32_t, double, std::vector<sample_gap> *);
 
-double data_receiver::pull_sample_untyped(void *buffer, int buffer_bytes, double timeout) {
-	if(sample_p s = try_get_next_sample(timeout)) {
+double data_receiver::pull_sample_untyped(
+	void *buffer, int buffer_bytes, double timeout, uint32_t *dropped) {
+	uint32_t gap;
+	if (sample_p s = try_get_next_sample(timeout, gap)) {
+		if (dropped) *dropped = gap;
 		if (buffer_bytes != conn_.type_info().sample_bytes())
 			throw std::range_error("The size of the provided buffer does not match the number of "
 								   "bytes in the sample.");
 		s->retrieve_untyped(buffer);
-		return s->timestamp();
+		return resolve_timestamp(s, gap);
 	}
 	return 0.0;
 }
 
+double data_receiver::pull_sample_buf(char **buffer, uint32_t *buffer_lengths,
+	uint32_t buffer_elements, double timeout, uint32_t *dropped) {
+	const uint32_t num_chans = conn_.type_info().channel_count();
+	if (buffer_elements < num_chans)
+		throw std::range_error(
+			"The provided buffer has fewer elements than the stream's number of channels.");
+	uint32_t gap;
+	sample_p s = try_get_next_sample(timeout, gap);
+	if (!s) {
+		// leave nothing behind that looks like it needs to be freed
+		std::fill_n(buffer, num_chans, nullptr);
+		std::fill_n(buffer_lengths, num_chans, 0);
+		return 0.0;
+	}
+	// numeric values need to be formatted first
+	std::vector<std::string> formatted;
+	if (conn_.type_info().channel_format() != cft_string) {
+		formatted.resize(num_chans);
+		s->retrieve_typed(formatted.data());
+	}
+	for (uint32_t k = 0; k < num_chans; k++) {
+		std::size_t len;
+		const char *value = formatted.empty() ? s->string_value(k, len)
+											  : (len = formatted[k].size(), formatted[k].data());
+		buffer[k] = static_cast<char *>(malloc(len));
+		if (!buffer[k] && len) {
+			for (uint32_t k2 = 0; k2 < k; k2++) free(buffer[k2]);
+			throw std::bad_alloc();
+		}
+		buffer_lengths[k] = static_cast<uint32_t>(len);
+		if (len) memcpy(buffer[k], value, len);
+	}
+	if (dropped) *dropped = gap;
+	return resolve_timestamp(s, gap);
+}
 
 // === internal processing ===
 
@@ -148,6 +371,8 @@ void data_receiver::data_thread() {
 				cancellable_streambuf buffer;
 				buffer.register_at(&conn_);
 				buffer.register_at(this);
+				buffer.set_busy_poll_spins(busy_poll_spins_);
+				buffer.count_received_bytes(&sample_queue_.stats().bytes);
 				std::iostream server_stream(&buffer);
 				std::unique_ptr<eos::portable_iarchive> inarch;
 				// connect to endpoint
@@ -160,6 +385,8 @@ void data_receiver::data_thread() {
 				int data_protocol_version = 100;  // which protocol version we shall use for data
 												  // transmission (100=version 1.00)
 				bool suppress_subnormals = false; // whether we shall suppress subnormal numbers
+				std::string shm_name; // the shared memory ring offered by the server (if any)
+				bool compressed = false; // whether the server compresses the chunks
 
 				// propose to use the highest protocol version supported by both parties
 				int proposed_protocol_version =
@@ -187,6 +414,13 @@ void data_receiver::data_thread() {
 					server_stream << "Hostname: " << conn_.type_info().hostname() << "\r\n";
 					server_stream << "Source-Id: " << conn_.type_info().source_id() << "\r\n";
 					server_stream << "Session-Id: " << conn_.type_info().session_id() << "\r\n";
+					if (api_config::get_instance()->shared_memory_transport() && !shm_failed_ &&
+						conn_.type_info().channel_format() != cft_string)
+						server_stream << "Shared-Memory: 1\r\n";
+					if (overflow_policy_ == overflow_policy::block)
+						server_stream << "Overflow-Policy: block\r\n";
+					server_stream << "Drop-Notices: 1\r\n";
+					if (compress_) server_stream << "Compression: lz4\r\n";
 					server_stream << "\r\n" << std::flush;
 
 					// check server response line (LSL/[Version] [StatusCode] [Message])
@@ -238,6 +472,14 @@ void data_receiver::data_thread() {
 							}
 							if (type == "suppress-subnormals")
 								suppress_subnormals = lsl::from_string<bool>(rest);
+							if (type == "shared-memory") shm_name = rest;
+							if (type == "compression") {
+								if (rest != "lz4")
+									throw std::runtime_error(
+										"The compression requested by the other party is not "
+										"supported.");
+								compressed = true;
+							}
 							if (type == "uid" && rest != conn_.current_uid())
 								throw lost_error("The received UID does not match the current "
 												 "connection's UID.");
@@ -296,6 +538,25 @@ void data_receiver::data_thread() {
 					}
 				}
 
+				// the samples after the test patterns arrive in compressed chunks
+				std::unique_ptr<chunk_decoder> decoder;
+				if (compressed)
+					decoder = std::make_unique<chunk_decoder>(buffer,
+						conn_.type_info().channel_format(), conn_.type_info().channel_count());
+				std::streambuf &feed = decoder ? static_cast<std::streambuf &>(*decoder) : buffer;
+
+				// attach to the shared memory ring if the server has set one up for us
+				std::unique_ptr<shm_ring> shm;
+				if (!shm_name.empty()) try {
+						shm = shm_ring::attach(shm_name, conn_.type_info().sample_bytes());
+					} catch (std::exception &e) {
+						// e.g., the server runs in another container; reconnect without it
+						LOG_F(WARNING, "Can't use the shared memory transport (%s), reconnecting",
+							e.what());
+						shm_failed_ = true;
+						continue;
+					}
+
 				// signal to accessor functions on other threads that the protocol negotiation has
 				// been successful, so we're now connected (and remain to be even if we later
 				// recover silently)
@@ -312,19 +573,34 @@ void data_receiver::data_thread() {
 				for (int k = 0; !conn_.lost() && !conn_.shutdown() && !closing_stream_; k++) {
 					// allocate and fetch a new sample
 					sample_p samp(factory->new_sample(0.0, false));
-					if (data_protocol_version >= 110)
-						samp->load_streambuf(
-							buffer, data_protocol_version, reverse_byte_order, suppress_subnormals);
+					uint32_t dropped = 0;
+					if (shm) {
+						const char *slot = shm->peek();
+						for (uint32_t spin = 0; !slot && spin < busy_poll_spins_; ++spin)
+							slot = shm->peek();
+						// wait for the server's wakeup byte unless samples arrived in the meantime
+						for (; !slot; slot = shm->peek())
+							if (shm->prepare_wait() &&
+								buffer.sbumpc() == std::char_traits<char>::eof())
+								throw lost_error("Server connection lost.");
+						std::memcpy(
+							&samp->timestamp(), slot + shm_ring::timestamp_offset, sizeof(double));
+						samp->assign_untyped(slot + shm_ring::data_offset);
+						shm->pop();
+					} else if (data_protocol_version >= 110)
+						samp->load_streambuf(feed, data_protocol_version, reverse_byte_order,
+							suppress_subnormals, &dropped);
 					else
 						*inarch >> *samp;
-					// deduce timestamp if necessary
+					// deduce timestamp if necessary (assuming that dropped samples were regular)
 					if (samp->timestamp() == DEDUCED_TIMESTAMP) {
 						samp->timestamp() = last_timestamp;
-						if (srate != IRREGULAR_RATE) samp->timestamp() += 1.0 / srate;
+						if (srate != IRREGULAR_RATE) samp->timestamp() += (1.0 + dropped) / srate;
 					}
 					last_timestamp = samp->timestamp();
-					// push it into the sample queue
-					sample_queue_.push_sample(samp);
+					// push it into the sample queue, passing on the outlet's gap
+					if (dropped) sample_queue_.stats().dropped.add(dropped);
+					sample_queue_.push_sample(samp, latency_histogram::now(), dropped);
 					// periodically update the last receive time to keep the watchdog happy
 					if (srate <= 16 || (k & 0xF) == 0) conn_.update_receive_time(lsl_clock());
 				}
@@ -8,13 +8,23 @@
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 namespace lsl {
 
 class inlet_connection; // Forward declaration
 
+/// Samples missing from a pulled chunk since they were dropped before they could be pulled.
+struct sample_gap {
+	/// the index of the pulled sample that the gap precedes
+	uint32_t position;
+	/// the number of samples that are missing
+	uint32_t dropped;
+};
+
 /** Internal class of an inlet that's retrieving the data (the samples) of the inlet.
  *
  * The actual communication runs in an internal background thread, while the public functions
@@ -36,8 +46,17 @@ public:
 	 * (the default corresponds to the chunk sizes used by the sender). Recording applications can
 	 * use a generous size here (leaving it to the network how to pack things), while real-time
 	 * applications may want a finer (perhaps 1-sample) granularity.
+	 * @param busy_poll Whether the data thread and pulls should poll for new samples for a while
+	 * before they go to sleep (always on if enabled in the configuration).
+	 * @param overflow What to do if the buffer is full. Blocking is also requested from the
+	 * outlet, so the back-pressure reaches the producer. Either way, the outlet tells us how many
+	 * samples it dropped.
+	 * @param compress Whether to ask the outlet to compress the samples (always on if enabled in
+	 * the configuration).
 	 */
-	data_receiver(inlet_connection &conn, int max_buflen = 360, int max_chunklen = 0);
+	data_receiver(inlet_connection &conn, int max_buflen = 360, int max_chunklen = 0,
+		bool busy_poll = false, overflow_policy overflow = overflow_policy::drop_oldest,
+		bool compress = false);
 
 	/// Destructor. Stops the background activities.
 	~data_receiver() final;
@@ -62,26 +81,86 @@ public:
 	 */
 	void close_stream();
 
-	/// Retrieve a sample from the sample queue and assign its contents to the given typed buffer.
+	/**
+	 * Retrieve a sample from the sample queue and assign its contents to the given typed buffer.
+	 * @param dropped Optionally receives the number of samples that were dropped (by the outlet
+	 * or our own buffer) between the previously pulled sample and this one.
+	 */
 	template <class T>
-	double pull_sample_typed(T *buffer, uint32_t buffer_elements, double timeout = FOREVER);
+	double pull_sample_typed(T *buffer, uint32_t buffer_elements, double timeout = FOREVER,
+		uint32_t *dropped = nullptr);
 
 	/// Read sample from the inlet and read it into a pointer to raw data.
-	double pull_sample_untyped(void *buffer, int buffer_bytes, double timeout = FOREVER);
+	double pull_sample_untyped(void *buffer, int buffer_bytes, double timeout = FOREVER,
+		uint32_t *dropped = nullptr);
+
+	/**
+	 * Retrieve a sample and copy each value into a newly malloc()ed buffer.
+	 * The values of string-formatted samples are copied straight from the sample.
+	 * @throws std::bad_alloc if a buffer couldn't be allocated (after freeing the others).
+	 */
+	double pull_sample_buf(char **buffer, uint32_t *buffer_lengths, uint32_t buffer_elements,
+		double timeout = FOREVER, uint32_t *dropped = nullptr);
+
+	/**
+	 * Retrieve up to max_samples samples from the sample queue and assign their contents to the
+	 * given multiplexed buffer (max_samples * channel_count elements) and their time stamps to
+	 * the timestamps buffer (max_samples elements).
+	 *
+	 * The queue is drained in batches, so a backlog can be picked up without paying for the
+	 * synchronization of a single pull_sample_typed() call per sample.
+	 * @param timeout The timeout for the whole operation. When it expires, fewer than max_samples
+	 * samples may be returned. A timeout of 0.0 only retrieves samples available immediately.
+	 * @param gaps Optionally receives the positions of samples that were dropped before they
+	 * could be pulled (see pull_sample_typed()), in ascending order.
+	 * @return The number of samples written to the buffers.
+	 */
+	template <class T>
+	uint32_t pull_chunk_typed(T *buffer, double *timestamps, uint32_t max_samples,
+		double timeout = 0.0, std::vector<sample_gap> *gaps = nullptr);
 
 	/// Check whether the underlying buffer is empty. This value may be inaccurate.
-	bool empty() { return sample_queue_.empty(); }
+	bool empty() { return queue()->empty(); }
 
-	std::size_t samples_available() { return sample_queue_.read_available(); }
+	std::size_t samples_available() { return queue()->read_available(); }
 
 	/// Flush the queue, return the number of dropped samples
-	uint32_t flush() noexcept { return sample_queue_.flush(); }
+	uint32_t flush() noexcept { return queue()->flush(); }
+
+	/**
+	 * Get the transfer statistics; can be called from any thread.
+	 * @param stats An array that receives up to num_stats entries, indexed by lsl_stat_t.
+	 * @return The number of entries written.
+	 */
+	int32_t get_stats(uint64_t *stats, int32_t num_stats);
 
 private:
 	/// The data reader thread.
 	void data_thread();
 
-	sample_p try_get_next_sample(double timeout);
+	/// Throw if the connection was lost and start the data transfer if it isn't running yet.
+	void prepare_pull();
+
+	/// Read from the outlet's send buffer if it's in this process, otherwise start the data thread.
+	void start_transfer();
+
+	/// Switch back to the data thread if the local outlet has gone away, returns true if so.
+	bool detach_from_lost_local_outlet();
+
+	/// Stop reading from the local outlet's send buffer, keeping the queue's statistics.
+	void release_local_queue();
+
+	/// The queue that samples are pulled from, kept alive while it's used even if close_stream()
+	/// releases it on another thread.
+	std::shared_ptr<consumer_queue> queue();
+
+	/// Get the time stamp of a pulled sample, deducing it if necessary (from the previous one and
+	/// the number of samples dropped in between).
+	double resolve_timestamp(const sample_p &s, uint32_t dropped);
+
+	/// Pop the next sample (nullptr if the timeout expired) and the number of samples dropped
+	/// before it.
+	sample_p try_get_next_sample(double timeout, uint32_t &dropped);
 
 	/// the underlying connection
 	inlet_connection &conn_;
@@ -103,12 +182,29 @@ private:
 	std::mutex connected_mut_;
 	/// condition variable to indicate that an update for the connected state is available
 	std::condition_variable connected_upd_;
+	/// queue on the send buffer of an outlet in the same process, used instead of the data thread
+	/// (its deleter keeps the outlet's sample factory alive until the queue is destroyed)
+	std::shared_ptr<consumer_queue> local_queue_;
+	/// the nominal sampling rate and last time stamp, to deduce time stamps of local samples
+	double local_srate_{0.0}, local_last_timestamp_{0.0};
+	/// the statistics of local queues that have been released
+	queue_stats released_stats_;
+	/// protects local_queue_ and released_stats_ against pulls and get_stats() on other threads
+	std::mutex local_queue_mut_;
 
 	// internal data used by the reader thread
 	/// the maximum number of samples to be buffered for this inlet
 	int max_buflen_;
 	// the desired maximum chunklen for received samples
 	int max_chunklen_;
+	/// whether attaching to a shared memory ring failed, so it isn't requested again
+	bool shm_failed_{false};
+	/// number of times to poll for new data before going to sleep (0: don't busy-poll)
+	uint32_t busy_poll_spins_;
+	/// what the sample queues do if they're full
+	overflow_policy overflow_policy_;
+	/// whether a compressed feed is requested
+	bool compress_;
 };
 
 } // namespace lsl
@@ -0,0 +1,240 @@
+#include "feed_compression.h"
+#include "sample.h"
+#include "util/lz4.hpp"
+#include <boost/endian/conversion.hpp>
+#include <cstring>
+#include <stdexcept>
+
+using namespace lsl;
+
+const std::size_t frame_header_bytes = 3 * sizeof(uint32_t) + 2;
+/// chunks larger than this are rejected instead of allocating memory for them
+const uint32_t max_chunk_bytes = 1U << 28;
+/// every this many chunks, the encoder checks if the prefilter still pays off
+const unsigned filter_trial_interval = 64;
+
+enum frame_codec : uint8_t { codec_stored = 0, codec_lz4 = 1 };
+
+template <typename T> static void put_le(std::string &out, T value) {
+	lslboost::endian::native_to_little_inplace(value);
+	out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T> static T get_le(const char *p) {
+	T value;
+	memcpy(&value, p, sizeof(value));
+	lslboost::endian::little_to_native_inplace(value);
+	return value;
+}
+
+/// The size of the sample header (including a drop notice) at p, or 0 if it's malformed.
+static std::size_t sample_header_bytes(const char *p, std::size_t avail) {
+	std::size_t len = 0;
+	if (avail > 0 && static_cast<uint8_t>(p[0]) == TAG_DROPPED_SAMPLES)
+		len = sample::drop_notice_bytes;
+	if (avail <= len) return 0;
+	switch (static_cast<uint8_t>(p[len])) {
+	case TAG_DEDUCED_TIMESTAMP: len += 1; break;
+	case TAG_TRANSMITTED_TIMESTAMP: len += 1 + sizeof(double); break;
+	default: return 0;
+	}
+	return len <= avail ? len : 0;
+}
+
+/**
+ * Replace each value by its difference to (or XOR with) the value `stride` values before it, or
+ * undo this. Values are encoded back to front so the previous values are still the original ones,
+ * and decoded front to back so they're already restored.
+ */
+template <typename T, bool use_xor, bool decode>
+static void delta_typed(char *values, std::size_t count, std::size_t stride) {
+	const int sign_shift = sizeof(T) * 8 - 1;
+	auto apply = [values, stride, sign_shift](std::size_t i) {
+		char *cur = values + i * sizeof(T);
+		const T a = get_le<T>(cur), b = get_le<T>(cur - stride * sizeof(T));
+		T result;
+		if (use_xor)
+			result = static_cast<T>(a ^ b);
+		else if (decode) {
+			// undo the zigzag encoding, then add the previous value
+			const T d = static_cast<T>((a >> 1) ^ static_cast<T>(0 - (a & 1)));
+			result = static_cast<T>(d + b);
+		} else {
+			// zigzag encode the difference so small negative ones don't turn into 0xFF... bytes
+			const T d = static_cast<T>(a - b);
+			result = static_cast<T>(
+				static_cast<T>(d << 1) ^ static_cast<T>(0 - (d >> sign_shift)));
+		}
+		lslboost::endian::native_to_little_inplace(result);
+		memcpy(cur, &result, sizeof(T));
+	};
+	if (decode)
+		for (std::size_t i = stride; i < count; ++i) apply(i);
+	else
+		for (std::size_t i = count; i-- > stride;) apply(i);
+}
+
+template <bool decode>
+static void delta(char *values, std::size_t count, std::size_t stride, std::size_t value_bytes,
+	bool use_xor) {
+	switch (value_bytes * 2 + use_xor) {
+	case 2: delta_typed<uint8_t, false, decode>(values, count, stride); break;
+	case 3: delta_typed<uint8_t, true, decode>(values, count, stride); break;
+	case 4: delta_typed<uint16_t, false, decode>(values, count, stride); break;
+	case 5: delta_typed<uint16_t, true, decode>(values, count, stride); break;
+	case 8: delta_typed<uint32_t, false, decode>(values, count, stride); break;
+	case 9: delta_typed<uint32_t, true, decode>(values, count, stride); break;
+	case 16: delta_typed<uint64_t, false, decode>(values, count, stride); break;
+	case 17: delta_typed<uint64_t, true, decode>(values, count, stride); break;
+	default: throw std::invalid_argument("Unsupported value size for the delta prefilter.");
+	}
+}
+
+/// Group the bytes of `count` values by their significance, or undo this.
+template <bool decode>
+static void shuffle(const char *src, char *dst, std::size_t count, std::size_t value_bytes) {
+	for (std::size_t i = 0; i < count; ++i)
+		for (std::size_t b = 0; b < value_bytes; ++b)
+			if (decode)
+				dst[i * value_bytes + b] = src[b * count + i];
+			else
+				dst[b * count + i] = src[i * value_bytes + b];
+}
+
+chunk_encoder::chunk_encoder(lsl_channel_format_t format, uint32_t channel_count)
+	: filter_(chunk_filter::none), value_bytes_(format == cft_string ? 0 : format_sizes[format]),
+	  sample_bytes_(value_bytes_ * channel_count) {
+	// on synthetic EEG, the zigzag encoded differences compress best for all numeric formats
+	// (even for floating point values), see the feed compression benchmark
+	filter_ = sample_bytes_ ? chunk_filter::delta : chunk_filter::none;
+}
+
+void chunk_encoder::set_filter(chunk_filter filter) {
+	filter_ = sample_bytes_ ? filter : chunk_filter::none;
+	adaptive_ = false;
+}
+
+void chunk_encoder::encode(const char *chunk, std::size_t len, std::string &out) {
+	if (len > max_chunk_bytes) throw std::length_error("The chunk is too large to be sent.");
+	if (!adaptive_ || filter_ == chunk_filter::none) return append_frame(chunk, len, filter_, out);
+	if (trial_countdown_--)
+		return append_frame(chunk, len, use_filter_ ? filter_ : chunk_filter::none, out);
+
+	// now and then, check if the data compresses better without the prefilter (e.g., values
+	// that repeat exactly, but not in consecutive samples)
+	trial_countdown_ = filter_trial_interval - 1;
+	const std::size_t start = out.size();
+	append_frame(chunk, len, filter_, out);
+	std::string unfiltered;
+	append_frame(chunk, len, chunk_filter::none, unfiltered);
+	use_filter_ = out.size() - start <= unfiltered.size();
+	if (!use_filter_) out.replace(start, std::string::npos, unfiltered);
+}
+
+void chunk_encoder::append_frame(
+	const char *chunk, std::size_t len, chunk_filter filter, std::string &out) {
+	const char *data = chunk;
+	uint32_t num_samples = 0;
+	if (filter != chunk_filter::none) {
+		// separate the sample headers from the channel data
+		planar_.clear();
+		values_.clear();
+		std::size_t pos = 0;
+		while (pos < len) {
+			const std::size_t header = sample_header_bytes(chunk + pos, len - pos);
+			if (!header || len - pos - header < sample_bytes_) break;
+			planar_.insert(planar_.end(), chunk + pos, chunk + pos + header);
+			pos += header;
+			values_.insert(values_.end(), chunk + pos, chunk + pos + sample_bytes_);
+			pos += sample_bytes_;
+			++num_samples;
+		}
+		if (pos == len) {
+			const std::size_t headers = planar_.size(), count = values_.size() / value_bytes_;
+			if (filter != chunk_filter::shuffle)
+				delta<false>(values_.data(), count, sample_bytes_ / value_bytes_, value_bytes_,
+					filter == chunk_filter::xor_delta);
+			planar_.resize(headers + values_.size());
+			shuffle<false>(values_.data(), planar_.data() + headers, count, value_bytes_);
+			data = planar_.data();
+		} else {
+			// not a chunk of numeric samples, so it's sent as it is
+			filter = chunk_filter::none;
+			num_samples = 0;
+		}
+	}
+
+	compressed_.resize(lz4_compress_bound(len));
+	const std::size_t compressed = lz4_compress(data, len, compressed_.data());
+	const bool stored = compressed >= len;
+	put_le(out, static_cast<uint32_t>(len));
+	put_le(out, static_cast<uint32_t>(stored ? len : compressed));
+	put_le(out, num_samples);
+	out += static_cast<char>(stored ? codec_stored : codec_lz4);
+	out += static_cast<char>(filter);
+	out.append(stored ? data : compressed_.data(), stored ? len : compressed);
+}
+
+chunk_decoder::chunk_decoder(
+	std::streambuf &src, lsl_channel_format_t format, uint32_t channel_count)
+	: src_(src), value_bytes_(format == cft_string ? 0 : format_sizes[format]),
+	  sample_bytes_(value_bytes_ * channel_count) {}
+
+chunk_decoder::int_type chunk_decoder::underflow() {
+	// empty chunks are skipped
+	while (gptr() == egptr())
+		if (!next_frame()) return traits_type::eof();
+	return traits_type::to_int_type(*gptr());
+}
+
+bool chunk_decoder::next_frame() {
+	char header[frame_header_bytes];
+	if (src_.sgetn(header, sizeof(header)) != static_cast<std::streamsize>(sizeof(header)))
+		return false;
+	const auto len = get_le<uint32_t>(header), stored = get_le<uint32_t>(header + 4),
+			   num_samples = get_le<uint32_t>(header + 8);
+	const auto codec = static_cast<uint8_t>(header[12]);
+	const auto filter = static_cast<chunk_filter>(header[13]);
+	if (len > max_chunk_bytes || stored > lz4_compress_bound(len))
+		throw std::runtime_error("Received a malformed compressed chunk.");
+
+	frame_.resize(stored);
+	if (stored && src_.sgetn(frame_.data(), stored) != static_cast<std::streamsize>(stored))
+		return false;
+	char *data = frame_.data();
+	if (codec == codec_lz4) {
+		planar_.resize(len);
+		if (lz4_decompress(frame_.data(), stored, planar_.data(), len) != len)
+			throw std::runtime_error("Received a truncated compressed chunk.");
+		data = planar_.data();
+	} else if (codec != codec_stored || stored != len)
+		throw std::runtime_error("Received a chunk with an unknown codec.");
+
+	if (filter != chunk_filter::none) {
+		if (!sample_bytes_ || filter > chunk_filter::xor_delta || num_samples > len / sample_bytes_)
+			throw std::runtime_error("Received a malformed compressed chunk.");
+		const std::size_t values_len = num_samples * sample_bytes_, headers = len - values_len,
+						  count = values_len / value_bytes_;
+		values_.resize(values_len);
+		shuffle<true>(data + headers, values_.data(), count, value_bytes_);
+		if (filter != chunk_filter::shuffle)
+			delta<true>(values_.data(), count, sample_bytes_ / value_bytes_, value_bytes_,
+				filter == chunk_filter::xor_delta);
+		// interleave the sample headers and the channel data again
+		chunk_.resize(len);
+		std::size_t in = 0, out = 0;
+		for (std::size_t k = 0; k < num_samples; ++k) {
+			const std::size_t header = sample_header_bytes(data + in, headers - in);
+			if (!header) throw std::runtime_error("Received a malformed compressed chunk.");
+			memcpy(chunk_.data() + out, data + in, header);
+			in += header;
+			out += header;
+			memcpy(chunk_.data() + out, values_.data() + k * sample_bytes_, sample_bytes_);
+			out += sample_bytes_;
+		}
+		if (in != headers) throw std::runtime_error("Received a malformed compressed chunk.");
+		data = chunk_.data();
+	}
+	setg(data, data, data + len);
+	return true;
+}
@@ -0,0 +1,102 @@
+#ifndef FEED_COMPRESSION_H
+#define FEED_COMPRESSION_H
+
+#include "common.h"
+#include <cstddef>
+#include <cstdint>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace lsl {
+
+/// Prefilters that make the channel data of a chunk easier to compress.
+enum class chunk_filter : uint8_t {
+	/// the chunk is compressed as it was serialized
+	none = 0,
+	/// the bytes of the values are grouped by their significance
+	shuffle = 1,
+	/// integers are replaced by the difference to the previous sample's value, then shuffled
+	delta = 2,
+	/// floating point values are XOR'ed with the previous sample's value, then shuffled
+	xor_delta = 3
+};
+
+/**
+ * Compresses the chunks of a data feed that negotiated the `Compression: lz4` feed header.
+ *
+ * Each chunk of samples (serialized as in protocol 1.10) is sent as a frame: the chunk size, the
+ * size of the stored data, the number of samples, the codec and the prefilter (all integers are
+ * little endian), followed by the stored data.
+ * For numeric streams, the sample headers are stored before all channel data, so the prefilter
+ * can exploit the similarity of consecutive samples. The values are interpreted as little endian
+ * integers regardless of the byte order of the feed, so both parties agree on the result.
+ */
+class chunk_encoder {
+public:
+	/**
+	 * Create an encoder for a stream.
+	 *
+	 * Numeric streams use the delta prefilter, unless the periodic comparison with the
+	 * unfiltered data shows that it doesn't pay off.
+	 */
+	chunk_encoder(lsl_channel_format_t format, uint32_t channel_count);
+
+	/// Always use the given prefilter (e.g., for comparisons). String streams are never filtered.
+	void set_filter(chunk_filter filter);
+
+	/// Append the frame for a chunk of serialized samples to `out`.
+	void encode(const char *chunk, std::size_t len, std::string &out);
+
+private:
+	/// Append the frame for a chunk with the given prefilter to `out`.
+	void append_frame(const char *chunk, std::size_t len, chunk_filter filter, std::string &out);
+
+	chunk_filter filter_;
+	/// whether the prefilter is dropped if it doesn't pay off
+	bool adaptive_{true};
+	/// whether the last comparison was in favor of the prefilter
+	bool use_filter_{true};
+	/// the number of chunks until the next comparison
+	unsigned trial_countdown_{0};
+	/// the size of a value and of a sample's channel data, 0 for strings
+	std::size_t value_bytes_, sample_bytes_;
+	/// the sample headers followed by the filtered channel data
+	std::vector<char> planar_;
+	/// the channel data of the current chunk
+	std::vector<char> values_;
+	/// the compressed data of the current chunk
+	std::vector<char> compressed_;
+};
+
+/**
+ * A stream buffer that reads the frames written by a chunk_encoder from another stream buffer
+ * and provides the chunks of serialized samples, so they can be read with
+ * sample::load_streambuf() as if the feed wasn't compressed.
+ */
+class chunk_decoder final : public std::streambuf {
+public:
+	chunk_decoder(std::streambuf &src, lsl_channel_format_t format, uint32_t channel_count);
+
+protected:
+	int_type underflow() override;
+
+private:
+	/// Read and decode the next frame, false if the source has no more data.
+	bool next_frame();
+
+	std::streambuf &src_;
+	std::size_t value_bytes_, sample_bytes_;
+	/// the stored data of the current frame
+	std::vector<char> frame_;
+	/// the decompressed data of the current frame
+	std::vector<char> planar_;
+	/// the restored channel data of the current frame
+	std::vector<char> values_;
+	/// the current chunk of serialized samples
+	std::vector<char> chunk_;
+};
+
+} // namespace lsl
+
+#endif
@@ -1,14 +1,23 @@
 #include "info_receiver.h"
 #include "cancellable_streambuf.h"
+#include "info_reply.h"
 #include "inlet_connection.h"
 #include "stream_info_impl.h"
+#include "util/lru_cache.hpp"
 #include <chrono>
+#include <cstdint>
 #include <exception>
 #include <istream>
 #include <loguru.hpp>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <utility>
+
+/// The most recently received stream infos with their hashes, by stream UID.
+/// Lets inlets that are re-created for the same stream skip receiving an unchanged stream info.
+static std::mutex fullinfo_cache_mut;
+static lsl::lru_cache<std::pair<uint64_t, lsl::stream_info_impl_p>> fullinfo_cache(64);
 
 lsl::info_receiver::info_receiver(inlet_connection &conn) : conn_(conn) {
 	conn_.register_onlost(this, &fullinfo_upd_);
@@ -56,14 +65,55 @@ void lsl::info_receiver::info_thread() {
 				{
 					throw asio::system_error(buffer.error());
 				}
-				// send the query
-				server_stream << "LSL:fullinfo\r\n" << std::flush;
+				// send the query, along with the hash of the info we already have (if any)
+				const std::string uid = conn_.current_uid();
+				// a recovered connection may lead to a different server, so ask it again
+				if (uid != fullinfo_uid_) {
+					fullinfo_uid_ = uid;
+					binary_fullinfo_ = true;
+				}
+				std::pair<uint64_t, stream_info_impl_p> cached;
+				if (binary_fullinfo_) {
+					std::lock_guard<std::mutex> lock(fullinfo_cache_mut);
+					if (auto *entry = fullinfo_cache.find(uid)) cached = *entry;
+				}
+				if (!binary_fullinfo_)
+					server_stream << "LSL:fullinfo\r\n" << std::flush;
+				else if (cached.second)
+					server_stream << "LSL:fullinfo/2 " << std::hex << cached.first << "\r\n"
+								  << std::flush;
+				else
+					server_stream << "LSL:fullinfo/2\r\n" << std::flush;
 				// receive and parse the response
 				std::ostringstream os;
 				os << server_stream.rdbuf();
 				stream_info_impl info;
 				std::string msg = os.str();
-				info.from_fullinfo_message(msg);
+				if (!binary_fullinfo_)
+					info.from_fullinfo_message(msg);
+				else if (msg.empty()) {
+					// servers that don't know the request close the connection without reply,
+					// anything else (reset, cancelled, ...) is retried with the same request
+					if (buffer.error() != asio::error::eof)
+						throw asio::system_error(buffer.error());
+					binary_fullinfo_ = false;
+					continue;
+				} else {
+					fullinfo_reply reply = fullinfo_reply::parse(msg);
+					if (reply.unchanged) {
+						if (!cached.second || reply.hash != cached.first)
+							throw std::runtime_error("unexpected unchanged stream info reply");
+						info = *cached.second;
+					} else {
+						if (reply.xml)
+							info.from_fullinfo_message(reply.message);
+						else
+							info.from_fullinfo_binary(reply.message.data(), reply.message.size());
+						std::lock_guard<std::mutex> lock(fullinfo_cache_mut);
+						fullinfo_cache.insert(
+							uid, {reply.hash, std::make_shared<stream_info_impl>(info)});
+					}
+				}
 				// if this is not a valid streaminfo we retry
 				if (info.created_at() == 0.0) continue;
 				// store the result for pickup & return
@@ -5,6 +5,7 @@
 #include "forward.h"
 #include <condition_variable>
 #include <mutex>
+#include <string>
 #include <thread>
 
 namespace lsl {
@@ -53,6 +54,11 @@ private:
 	std::mutex fullinfo_mut_;
 	/// condition variable to indicate that an update for the fullinfo is available
 	std::condition_variable fullinfo_upd_;
+	/// whether the server understands `LSL:fullinfo/2` requests (assumed until it closes the
+	/// connection without a reply)
+	bool binary_fullinfo_{true};
+	/// the UID of the stream that binary_fullinfo_ was determined for
+	std::string fullinfo_uid_;
 };
 
 } // namespace lsl
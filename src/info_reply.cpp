@@ -0,0 +1,91 @@
+#include "info_reply.h"
+#include "util/lz4.hpp"
+#include <boost/endian/conversion.hpp>
+#include <cstring>
+#include <stdexcept>
+
+using namespace lsl;
+
+const char reply_magic[4] = {'L', 'S', 'L', 'r'};
+const uint8_t reply_version = 1;
+const std::size_t reply_header_len = sizeof(reply_magic) + 2 + sizeof(uint64_t);
+/// messages larger than this are rejected instead of allocating memory for them
+const uint32_t max_message_size = 1U << 30;
+
+enum reply_flags : uint8_t { flag_unchanged = 1, flag_compressed = 2, flag_xml = 4 };
+
+template <typename T> static void put_le(std::string &m, T value) {
+	lslboost::endian::native_to_little_inplace(value);
+	m.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T> static T get_le(const char *p) {
+	T value;
+	memcpy(&value, p, sizeof(value));
+	lslboost::endian::little_to_native_inplace(value);
+	return value;
+}
+
+static std::string reply_header(uint8_t flags, uint64_t hash) {
+	std::string reply(reply_magic, sizeof(reply_magic));
+	put_le(reply, reply_version);
+	put_le(reply, flags);
+	put_le(reply, hash);
+	return reply;
+}
+
+std::string fullinfo_reply::make(const std::string &message, uint64_t hash, bool xml) {
+	if (message.size() > max_message_size)
+		throw std::length_error("The stream info is too large to be sent.");
+	std::string compressed(lz4_compress_bound(message.size()), '\0');
+	compressed.resize(lz4_compress(message.data(), message.size(), &compressed[0]));
+	const bool compress = compressed.size() < message.size();
+
+	std::string reply =
+		reply_header((compress ? flag_compressed : 0) | (xml ? flag_xml : 0), hash);
+	put_le(reply, static_cast<uint32_t>(message.size()));
+	reply += compress ? compressed : message;
+	return reply;
+}
+
+std::string fullinfo_reply::make_unchanged(uint64_t hash) {
+	return reply_header(flag_unchanged, hash);
+}
+
+fullinfo_reply fullinfo_reply::parse(const std::string &reply) {
+	if (reply.size() < reply_header_len || memcmp(reply.data(), reply_magic, sizeof(reply_magic)) ||
+		static_cast<uint8_t>(reply[sizeof(reply_magic)]) != reply_version)
+		throw std::runtime_error("Received an unknown full-info reply.");
+	const auto flags = static_cast<uint8_t>(reply[sizeof(reply_magic) + 1]);
+	fullinfo_reply result;
+	result.hash = get_le<uint64_t>(reply.data() + sizeof(reply_magic) + 2);
+	result.unchanged = flags & flag_unchanged;
+	result.xml = flags & flag_xml;
+	if (result.unchanged) return result;
+
+	if (reply.size() < reply_header_len + sizeof(uint32_t))
+		throw std::runtime_error("Received a truncated full-info reply.");
+	const auto size = get_le<uint32_t>(reply.data() + reply_header_len);
+	if (size > max_message_size) throw std::runtime_error("Received a too large full-info reply.");
+	const char *body = reply.data() + reply_header_len + sizeof(uint32_t);
+	const std::size_t body_len = reply.size() - reply_header_len - sizeof(uint32_t);
+	if (flags & flag_compressed) {
+		result.message.resize(size);
+		if (lz4_decompress(body, body_len, &result.message[0], size) != size)
+			throw std::runtime_error("Received a truncated full-info reply.");
+	} else {
+		if (body_len != size) throw std::runtime_error("Received a truncated full-info reply.");
+		result.message.assign(body, body_len);
+	}
+	return result;
+}
+
+uint64_t lsl::fullinfo_hash(const std::string &message) {
+	// 64 bit FNV-1a
+	uint64_t hash = 14695981039346656037ULL;
+	for (unsigned char c : message) {
+		hash ^= c;
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
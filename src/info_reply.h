@@ -0,0 +1,49 @@
+#ifndef INFO_REPLY_H
+#define INFO_REPLY_H
+
+#include <cstdint>
+#include <string>
+
+namespace lsl {
+
+/**
+ * Replies to `LSL:fullinfo/2 [hash]` requests.
+ *
+ * A reply starts with a magic, a format version, flags and the hash of the stream info's
+ * full-info message (little endian). Clients send the hash of the stream info they already know;
+ * if it's still current, the reply ends there. Otherwise the message follows, preceded by its
+ * uncompressed size and LZ4 compressed if that makes it smaller.
+ */
+struct fullinfo_reply {
+	/// the hash of the stream info's message, see fullinfo_hash()
+	uint64_t hash{0};
+	/// whether the client's stream info is current (and no message was sent)
+	bool unchanged{false};
+	/// whether the message is an XML full-info message instead of a binary one
+	bool xml{false};
+	/// the (decompressed) message
+	std::string message;
+
+	/**
+	 * Build the reply that sends a full-info message.
+	 * @param xml Whether the message is an XML full-info message (because the stream info can't
+	 * be encoded as a binary one).
+	 */
+	static std::string make(const std::string &message, uint64_t hash, bool xml);
+
+	/// Build the reply telling the client that its stream info is current.
+	static std::string make_unchanged(uint64_t hash);
+
+	/**
+	 * Parse a reply.
+	 * @throws std::runtime_error if the reply is malformed.
+	 */
+	static fullinfo_reply parse(const std::string &reply);
+};
+
+/// Hash a full-info message to identify the version of a stream info.
+uint64_t fullinfo_hash(const std::string &message);
+
+} // namespace lsl
+
+#endif
@@ -1,6 +1,8 @@
 #include "inlet_connection.h"
 #include "api_config.h"
+#include "io_context_pool.h"
 #include "resolver_impl.h"
+#include "socket_utils.h"
 #include <asio/io_context.hpp>
 #include <asio/ip/address.hpp>
 #include <asio/ip/basic_resolver.hpp>
@@ -77,7 +79,13 @@ inlet_connection::inlet_connection(const stream_info_impl &info, bool recover)
 }
 
 void inlet_connection::engage() {
-	if (recovery_enabled_) watchdog_thread_ = std::thread(&inlet_connection::watchdog_thread, this);
+	if (!recovery_enabled_) return;
+	if (io_context_pool *pool = io_context_pool::get_instance()) {
+		watchdog_io_ = pool->next();
+		watchdog_timer_ = std::make_unique<steady_timer>(*watchdog_io_);
+		io_context_pool::run_sync(*watchdog_io_, [this]() { schedule_watchdog_check(); });
+	} else
+		watchdog_thread_ = std::thread(&inlet_connection::watchdog_thread, this);
 }
 
 void inlet_connection::disengage() {
@@ -91,7 +99,13 @@ void inlet_connection::disengage() {
 	resolver_.cancel();
 	cancel_and_shutdown();
 	// and wait for the watchdog to finish
-	if (recovery_enabled_) watchdog_thread_.join();
+	if (watchdog_timer_) {
+		io_context_pool::run_sync(*watchdog_io_, [this]() { watchdog_timer_->cancel(); });
+		// a check that was queued in the meantime runs before this and sees shutdown_
+		io_context_pool::run_sync(*watchdog_io_, []() {});
+		if (recovery_thread_.joinable()) recovery_thread_.join();
+	} else if (recovery_enabled_)
+		watchdog_thread_.join();
 }
 
 
@@ -246,21 +260,20 @@ bool inlet_connection::set_protocols(const stream_info_impl &info, bool prefer_v
 	return false;
 }
 
+bool inlet_connection::watchdog_recovery_due() {
+	// we only try to recover if a) there are active transmissions and b) we haven't seen
+	// new data for some time
+	std::lock_guard<std::mutex> lock(client_status_mut_);
+	return (active_transmissions_ > 0) &&
+		   (lsl_clock() - last_receive_time_ >
+			   api_config::get_instance()->watchdog_time_threshold());
+}
+
 void inlet_connection::watchdog_thread() {
 	loguru::set_thread_name((std::string("W_") += type_info().name().substr(0, 12)).c_str());
 	while (!lost_ && !shutdown_) {
 		try {
-			// we only try to recover if a) there are active transmissions and b) we haven't seen
-			// new data for some time
-			{
-				std::unique_lock<std::mutex> lock(client_status_mut_);
-				if ((active_transmissions_ > 0) &&
-					(lsl_clock() - last_receive_time_ >
-						api_config::get_instance()->watchdog_time_threshold())) {
-					lock.unlock();
-					try_recover();
-				}
-			}
+			if (watchdog_recovery_due()) try_recover();
 			// instead of sleeping we're waiting on a condition variable for the sleep duration
 			// so that the watchdog can be cancelled conveniently
 			{
@@ -276,6 +289,31 @@ void inlet_connection::watchdog_thread() {
 	}
 }
 
+void inlet_connection::schedule_watchdog_check() {
+	if (lost_ || shutdown_) return;
+	watchdog_timer_->expires_after(
+		timeout_sec(api_config::get_instance()->watchdog_check_interval()));
+	watchdog_timer_->async_wait([this](err_t err) {
+		if (err || lost_ || shutdown_) return;
+		try {
+			// the recovery blocks while resolving, so it mustn't hold up the shared IO thread
+			if (!recovering_ && watchdog_recovery_due()) {
+				if (recovery_thread_.joinable()) recovery_thread_.join();
+				recovering_ = true;
+				recovery_thread_ = std::thread([this]() {
+					loguru::set_thread_name(
+						(std::string("W_") += type_info().name().substr(0, 12)).c_str());
+					try_recover();
+					recovering_ = false;
+				});
+			}
+		} catch (std::exception &e) {
+			LOG_F(ERROR, "Unexpected hiccup in the watchdog: %s", e.what());
+		}
+		schedule_watchdog_check();
+	});
+}
+
 void inlet_connection::try_recover_from_error() {
 	if (!shutdown_) {
 		if (!recovery_enabled_) {
@@ -9,6 +9,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -41,7 +42,8 @@ namespace lsl {
  *
  * Since in some cases a client might not be able to detect a connection loss and so would stall
  * forever, the inlet_connection maintains a watchdog thread that periodically checks and recovers
- * the connection state.
+ * the connection state. If the shared IO threads are enabled, the checks are scheduled with a timer
+ * on one of them instead and only an actual recovery attempt gets a thread of its own.
  *
  * Internally the recovery works by using the resolver to find the desired stream on the network
  * again and updating the endpoint information if it has changed.
@@ -153,6 +155,12 @@ private:
 	/// A thread that periodically checks whether the connection should be recovered.
 	void watchdog_thread();
 
+	/// Whether the watchdog should attempt a recovery.
+	bool watchdog_recovery_due();
+
+	/// Schedule the next watchdog check on the shared io_context.
+	void schedule_watchdog_check();
+
 	/// A (potentially speculative) resolve-and-recover operation.
 	void try_recover();
 
@@ -178,6 +186,14 @@ private:
 	/// internal watchdog thread (to detect dead connections), re-resolves the current connection
 	/// speculatively
 	std::thread watchdog_thread_;
+	/// the shared io_context that runs the watchdog timer (if the shared IO threads are used)
+	io_context_p watchdog_io_;
+	/// timer for the next watchdog check on the shared io_context
+	std::unique_ptr<steady_timer> watchdog_timer_;
+	/// thread for the recovery attempt started by the watchdog timer
+	std::thread recovery_thread_;
+	/// whether the recovery attempt started by the watchdog timer is still running
+	std::atomic<bool> recovering_{false};
 
 	// things related to the shutdown condition
 	/// indicates to threads that we're shutting down
@@ -0,0 +1,66 @@
+#include "io_context_pool.h"
+#include "api_config.h"
+#include <asio/post.hpp>
+#include <exception>
+#include <future>
+#include <loguru.hpp>
+#include <memory>
+#include <string>
+
+namespace lsl {
+
+io_context_pool *io_context_pool::get_instance() {
+	static io_context_pool *pool = []() -> io_context_pool * {
+		const int num_threads = api_config::get_instance()->shared_io_threads();
+		if (num_threads <= 0) return nullptr;
+		static io_context_pool instance(static_cast<std::size_t>(num_threads));
+		return &instance;
+	}();
+	return pool;
+}
+
+io_context_pool::io_context_pool(std::size_t num_threads) {
+	for (std::size_t k = 0; k < num_threads; k++) {
+		auto io = std::make_shared<asio::io_context>(1);
+		contexts_.push_back(io);
+		guards_.push_back(asio::make_work_guard(*io));
+		threads_.emplace_back([io, name = "IO_shared_" + std::to_string(k)]() {
+			loguru::set_thread_name(name.c_str());
+			while (!io->stopped()) {
+				try {
+					io->run();
+					return;
+				} catch (std::exception &e) {
+					LOG_F(ERROR, "Error during io_context processing: %s", e.what());
+				}
+			}
+		});
+	}
+}
+
+io_context_pool::~io_context_pool() {
+	guards_.clear();
+	for (auto &io : contexts_) io->stop();
+	// the threads own their io_context and end on their own; joining them here could deadlock
+	// when the library is unloaded
+	for (auto &thread : threads_) thread.detach();
+}
+
+io_context_p io_context_pool::next() {
+	return contexts_[next_.fetch_add(1, std::memory_order_relaxed) % contexts_.size()];
+}
+
+void io_context_pool::run_sync(asio::io_context &io, const std::function<void()> &fn) {
+	// nothing can run concurrently if we're on the io_context's thread or it has been stopped
+	if (io.get_executor().running_in_this_thread() || io.stopped()) return fn();
+	std::promise<void> done;
+	asio::post(io, [&]() {
+		try {
+			fn();
+			done.set_value();
+		} catch (...) { done.set_exception(std::current_exception()); }
+	});
+	done.get_future().get();
+}
+
+} // namespace lsl
@@ -0,0 +1,65 @@
+#ifndef IO_CONTEXT_POOL_H
+#define IO_CONTEXT_POOL_H
+
+#include "forward.h"
+#include <asio/executor_work_guard.hpp>
+#include <asio/io_context.hpp>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace lsl {
+
+/**
+ * A process-wide set of io_contexts that are shared between stream outlets and inlets.
+ *
+ * Each io_context is run by a single thread, so the handlers of an object that is bound to one
+ * io_context never run concurrently, just like with a dedicated IO thread. The objects are
+ * distributed over the io_contexts in a round-robin fashion.
+ */
+class io_context_pool {
+public:
+	/// Get the shared pool, or nullptr if it's disabled (tuning.SharedIOThreads is 0)
+	static io_context_pool *get_instance();
+
+	/// Get the io_context that the next object should be bound to.
+	io_context_p next();
+
+	/**
+	 * Run a function on the thread of a shared io_context and wait for it.
+	 *
+	 * Objects bound to a shared io_context can't stop it to end their handler chains, so they
+	 * cancel their operations this way, without racing with handlers that are running.
+	 */
+	static void run_sync(asio::io_context &io, const std::function<void()> &fn);
+
+	/// Deleted copy constructor (noncopyable).
+	io_context_pool(const io_context_pool &rhs) = delete;
+
+	/// Deleted assignment operator (noncopyable).
+	io_context_pool &operator=(const io_context_pool &rhs) = delete;
+
+	/// Destructor, stops the io_contexts.
+	~io_context_pool();
+
+private:
+	/// Create the io_contexts and start a thread for each of them.
+	explicit io_context_pool(std::size_t num_threads);
+
+	using work_guard = asio::executor_work_guard<asio::io_context::executor_type>;
+
+	/// the io_contexts
+	std::vector<io_context_p> contexts_;
+	/// keeps the io_contexts running while they have no work
+	std::vector<work_guard> guards_;
+	/// the threads running the io_contexts
+	std::vector<std::thread> threads_;
+	/// index of the io_context to hand out next
+	std::atomic<std::size_t> next_{0};
+};
+
+} // namespace lsl
+
+#endif
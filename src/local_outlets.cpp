@@ -0,0 +1,48 @@
+#include "local_outlets.h"
+#include "sample.h"
+#include "send_buffer.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace lsl {
+
+namespace {
+struct local_outlet_directory {
+	std::mutex mut;
+	std::map<std::string, std::pair<std::weak_ptr<send_buffer>, std::weak_ptr<factory>>> outlets;
+};
+
+local_outlet_directory &directory() {
+	// never destroyed, so outlets with static storage duration can unregister safely
+	static auto *dir = new local_outlet_directory();
+	return *dir;
+}
+} // namespace
+
+void register_local_outlet(
+	const std::string &uid, const send_buffer_p &buffer, const factory_p &factory) {
+	auto &dir = directory();
+	std::lock_guard<std::mutex> lock(dir.mut);
+	dir.outlets[uid] = {buffer, factory};
+}
+
+void unregister_local_outlet(const std::string &uid) {
+	auto &dir = directory();
+	std::lock_guard<std::mutex> lock(dir.mut);
+	dir.outlets.erase(uid);
+}
+
+local_outlet find_local_outlet(const std::string &uid) {
+	auto &dir = directory();
+	std::lock_guard<std::mutex> lock(dir.mut);
+	auto it = dir.outlets.find(uid);
+	if (it == dir.outlets.end()) return {};
+	local_outlet outlet{it->second.first.lock(), it->second.second.lock()};
+	// only a complete outlet is of use, and a half destroyed one is about to unregister anyway
+	if (!outlet.buffer || !outlet.factory) return {};
+	return outlet;
+}
+
+} // namespace lsl
@@ -0,0 +1,37 @@
+#ifndef LOCAL_OUTLETS_H
+#define LOCAL_OUTLETS_H
+
+#include "forward.h"
+#include <string>
+
+namespace lsl {
+
+/**
+ * A process-wide directory of the send buffers of the outlets in this process, by stream UID.
+ *
+ * An inlet whose outlet lives in the same process registers its consumer_queue on the outlet's
+ * send_buffer directly, so the samples are handed over by reference instead of being serialized
+ * and sent through a socket.
+ */
+
+/// The parts of an outlet that inlets in the same process read from.
+struct local_outlet {
+	send_buffer_p buffer;
+	/// the factory that the buffered samples belong to, it has to outlive every queue holding them
+	factory_p factory;
+};
+
+/// Make an outlet's send buffer available to inlets in the same process.
+void register_local_outlet(
+	const std::string &uid, const send_buffer_p &buffer, const factory_p &factory);
+
+/// Remove an outlet from the directory (before it stops serving).
+void unregister_local_outlet(const std::string &uid);
+
+/// Get the send buffer and sample factory of an outlet in this process, or nullptrs if there is
+/// none with this UID.
+local_outlet find_local_outlet(const std::string &uid);
+
+} // namespace lsl
+
+#endif
@@ -19,7 +19,7 @@ LIBLSL_C_API lsl_inlet lsl_create_inlet_ex(lsl_streaminfo info, int32_t max_bufl
 	try {
 		int32_t buf_samples = info->calc_transport_buf_samples(max_buflen, flags);
 		return create_object_noexcept<stream_inlet_impl>(
-			*info, buf_samples, max_chunklen, recover != 0);
+			*info, buf_samples, max_chunklen, recover != 0, flags);
 	}
 	LSLCATCHANDSTORE(nullptr, std::invalid_argument, lsl_argument_error);
 	return nullptr;
@@ -146,24 +146,7 @@ LIBLSL_C_API double lsl_pull_sample_buf(lsl_inlet in, char **buffer, uint32_t *b
 	int32_t buffer_elements, double timeout, int32_t *ec) {
 	if (ec) *ec = lsl_no_error;
 	try {
-		// capture output in a temporary string buffer
-		std::vector<std::string> tmp;
-		double result = in->pull_sample(tmp, timeout);
-		if (buffer_elements < (int)tmp.size())
-			throw std::range_error(
-				"The provided buffer has fewer elements than the stream's number of channels.");
-		// allocate memory and copy over into buffer
-		for (std::size_t k = 0; k < tmp.size(); k++) {
-			buffer[k] = (char *)malloc(tmp[k].size());
-			if (buffer[k] == nullptr) {
-				for (std::size_t k2 = 0; k2 < k; k2++) free(buffer[k2]);
-				if (ec) *ec = lsl_internal_error;
-				return 0.0;
-			}
-			buffer_lengths[k] = (uint32_t)tmp[k].size();
-			memcpy(buffer[k], tmp[k].data(), tmp[k].size());
-		}
-		return result;
+		return in->pull_sample_buf(buffer, buffer_lengths, buffer_elements, timeout);
 	} LSL_STORE_EXCEPTION_IN(ec)
 	return 0.0;
 }
@@ -288,6 +271,11 @@ LIBLSL_C_API uint32_t lsl_inlet_flush(lsl_inlet in) {
 	return in->flush();
 }
 
+LIBLSL_C_API int32_t lsl_inlet_get_stats(lsl_inlet in, uint64_t *stats, int32_t num_stats) {
+	if (!stats || num_stats < 0) return lsl_argument_error;
+	return in->get_stats(stats, num_stats);
+}
+
 LIBLSL_C_API uint32_t lsl_was_clock_reset(lsl_inlet in) {
 	try {
 		return (uint32_t)in->was_clock_reset();
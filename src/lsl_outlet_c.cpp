@@ -419,6 +419,20 @@ LIBLSL_C_API int32_t lsl_wait_for_consumers(lsl_outlet out, double timeout) {
 	}
 }
 
+LIBLSL_C_API int32_t lsl_get_sample_pool_stats(
+	lsl_outlet out, uint32_t *allocated, uint32_t *in_use, uint32_t *peak) {
+	factory::pool_stats stats = out->sample_pool_stats();
+	if (allocated) *allocated = static_cast<uint32_t>(stats.allocated);
+	if (in_use) *in_use = static_cast<uint32_t>(stats.in_use);
+	if (peak) *peak = static_cast<uint32_t>(stats.peak);
+	return lsl_no_error;
+}
+
+LIBLSL_C_API int32_t lsl_outlet_get_stats(lsl_outlet out, uint64_t *stats, int32_t num_stats) {
+	if (!stats || num_stats < 0) return lsl_argument_error;
+	return out->get_stats(stats, num_stats);
+}
+
 LIBLSL_C_API lsl_streaminfo lsl_get_info(lsl_outlet out) {
 	return create_object_noexcept<stream_info_impl>(out->info());
 }
@@ -39,6 +39,47 @@ LIBLSL_C_API int32_t lsl_resolver_results(
 	LSL_RETURN_CAUGHT_EC;
 }
 
+LIBLSL_C_API int32_t lsl_resolver_changes(lsl_continuous_resolver res, uint64_t *generation,
+	lsl_streaminfo *buffer, int32_t *changes, uint32_t buffer_elements) {
+	if (!generation || (buffer_elements && (!buffer || !changes))) return lsl_argument_error;
+	try {
+		std::vector<result_update> tmp;
+		uint64_t current = res->changes_since(*generation, tmp, buffer_elements);
+		// the first changes can't be split: report the size they need instead
+		if (tmp.size() > buffer_elements) return static_cast<int32_t>(tmp.size());
+		uint32_t result = static_cast<uint32_t>(tmp.size());
+		for (uint32_t k = 0; k < result; k++) {
+			changes[k] = static_cast<int32_t>(tmp[k].kind);
+			buffer[k] = tmp[k].kind == result_change::reset ? nullptr
+															: new stream_info_impl(tmp[k].info);
+		}
+		*generation = current;
+		return static_cast<int32_t>(result);
+	}
+	LSL_RETURN_CAUGHT_EC;
+}
+
+LIBLSL_C_API int32_t lsl_resolver_wait_changes(
+	lsl_continuous_resolver res, uint64_t generation, double timeout) {
+	try {
+		return res->wait_for_changes(generation, timeout) ? 1 : 0;
+	}
+	LSL_RETURN_CAUGHT_EC;
+}
+
+LIBLSL_C_API int32_t lsl_resolver_set_callback(
+	lsl_continuous_resolver res, lsl_resolver_callback callback, void *userdata) {
+	try {
+		if (callback)
+			res->set_change_callback(
+				[res, callback, userdata](uint64_t generation) { callback(res, generation, userdata); });
+		else
+			res->set_change_callback(nullptr);
+		return lsl_no_error;
+	}
+	LSL_RETURN_CAUGHT_EC;
+}
+
 LIBLSL_C_API void lsl_destroy_continuous_resolver(lsl_continuous_resolver res) {
 	try {
 		delete res;
@@ -55,6 +55,8 @@ resolve_attempt_udp::resolve_attempt_udp(asio::io_context &io, const udp &protoc
 	os << "LSL:shortinfo\r\n";
 	os << query_ << "\r\n";
 	os << recv_socket_.local_endpoint().port() << " " << query_id_ << "\r\n";
+	// ask for replies that can be read without parsing XML (older outlets ignore this line)
+	os << "Binary-Shortinfo: 1\r\n";
 	query_msg_ = os.str();
 
 	DLOG_F(2, "Waiting for query results (port %d) for %s", recv_socket_.local_endpoint().port(),
@@ -116,30 +118,14 @@ void resolve_attempt_udp::handle_receive_outcome(err_t err, std::size_t len) {
 			if (returned_id == query_id_ && newlinepos != bufend) {
 				// parse the rest of the query into a stream_info
 				stream_info_impl info;
-				info.from_shortinfo_message(std::string(newlinepos, bufend));
-				std::string uid = info.uid();
-				{
-					// update the results
-					std::lock_guard<std::mutex> lock(resolver_.results_mut_);
-					auto it = resolver_.results_.find(uid);
-					if (it == resolver_.results_.end())
-						// insert new result, store iterator in it
-						it = resolver_.results_.emplace(uid, std::make_pair(info, lsl_clock()))
-								 .first;
-					else
-						it->second.second = lsl_clock(); // update only the receive time
-					auto &stored_info = it->second.first;
-					// ... also update the address associated with the result (but don't
-					// override the address of an earlier record for this stream since this
-					// would be the faster route)
-					if (remote_endpoint_.address().is_v4()) {
-						if (stored_info.v4address().empty())
-							stored_info.v4address(remote_endpoint_.address().to_string());
-					} else {
-						if (stored_info.v6address().empty())
-							stored_info.v6address(remote_endpoint_.address().to_string());
-					}
-				}
+				const char *msg = newlinepos + 1;
+				const auto msg_len = static_cast<std::size_t>(bufend - msg);
+				if (stream_info_impl::is_shortinfo_binary(msg, msg_len))
+					info.from_shortinfo_binary(msg, msg_len);
+				else
+					info.from_shortinfo_message(std::string(newlinepos, bufend));
+				if (resolver_.add_result(std::move(info), remote_endpoint_.address()))
+					resolver_.notify_changes();
 				// prepone the next cancellation check, i.e. when all needed streams are found,
 				// cancel immediately rather than when a wave timer is due half a second later
 				if (resolver_.check_cancellation_criteria())
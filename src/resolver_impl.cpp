@@ -6,6 +6,8 @@
 #include <asio/io_context.hpp>
 #include <asio/ip/basic_resolver.hpp>
 #include <asio/ip/udp.hpp>
+#include <algorithm>
+#include <chrono>
 #include <exception>
 #include <loguru.hpp>
 #include <memory>
@@ -18,6 +20,9 @@
 
 using namespace lsl;
 
+/// The number of removed results that are remembered for changes_since()
+const std::size_t max_removed_results = 1024;
+
 resolver_impl::resolver_impl()
 	: cfg_(api_config::get_instance()), cancelled_(false), expired_(false), forget_after_(FOREVER),
 	  fast_mode_(true), io_(std::make_shared<asio::io_context>()), resolve_timeout_expired_(*io_),
@@ -97,7 +102,7 @@ std::vector<stream_info_impl> resolver_impl::resolve_oneshot(
 	query_ = query;
 	minimum_ = minimum;
 	wait_until_ = lsl_clock() + minimum_time;
-	results_.clear();
+	clear_results();
 	forget_after_ = FOREVER;
 	fast_mode_ = true;
 	expired_ = false;
@@ -121,7 +126,7 @@ std::vector<stream_info_impl> resolver_impl::resolve_oneshot(
 		io_->run();
 		// collect output
 		std::vector<stream_info_impl> output;
-		for (auto &result : results_) output.push_back(result.second.first);
+		for (auto &result : results_) output.push_back(result.second.info);
 		return output;
 	}
 	return {};
@@ -137,7 +142,7 @@ void resolver_impl::resolve_continuous(const std::string &query, double forget_a
 	query_ = query;
 	minimum_ = 0;
 	wait_until_ = 0;
-	results_.clear();
+	clear_results();
 	forget_after_ = forget_after;
 	fast_mode_ = false;
 	expired_ = false;
@@ -153,23 +158,188 @@ std::vector<stream_info_impl> resolver_impl::results(uint32_t max_results) {
 		throw std::logic_error("results() called before starting a resolve operation");
 
 	std::vector<stream_info_impl> output;
+	bool pruned;
+	{
+		std::lock_guard<std::mutex> lock(results_mut_);
+		pruned = prune_results(lsl_clock());
+		for (const auto &result : results_) {
+			if (output.size() >= max_results) break;
+			output.push_back(result.second.info);
+		}
+	}
+	if (pruned) notify_changes();
+	return output;
+}
+
+uint64_t resolver_impl::changes_since(
+	uint64_t since, std::vector<result_update> &changes, std::size_t max_changes) {
+	if (status == resolver_status::empty)
+		throw std::logic_error("changes_since() called before starting a resolve operation");
+
+	changes.clear();
+	uint64_t generation;
+	bool pruned;
+	{
+		std::lock_guard<std::mutex> lock(results_mut_);
+		pruned = prune_results(lsl_clock());
+		generation = generation_;
+		// a consumer that missed some removals has to start over like one that doesn't know any
+		// results, which gets them all as added
+		const bool reset = since != 0 && since < removed_forgotten_;
+		if (reset) since = 0;
+		// streams that were found after `since` and already removed were never reported
+		for (const auto &removed : removed_)
+			if (removed.generation > since && removed.found <= since) changes.push_back(removed);
+		for (const auto &result : results_) {
+			const resolve_result &r = result.second;
+			if (r.generation > since)
+				changes.push_back(result_update{
+					r.found > since ? result_change::added : result_change::changed, r.generation,
+					r.info, r.found});
+		}
+		std::sort(changes.begin(), changes.end(),
+			[](const result_update &a, const result_update &b) {
+				return a.generation < b.generation;
+			});
+
+		// cut the changes where the consumer can continue, or else after the fewest changes
+		std::size_t max_updates = max_changes;
+		if (reset && max_updates) --max_updates;
+		if (changes.size() > max_updates) {
+			std::size_t n = max_updates;
+			while (n > 0 && !can_continue_from(since, changes[n - 1].generation)) --n;
+			if (n == 0)
+				for (n = max_updates + 1; n < changes.size(); ++n)
+					if (can_continue_from(since, changes[n - 1].generation)) break;
+			if (n < changes.size()) {
+				generation = changes[n - 1].generation;
+				changes.resize(n);
+			}
+		}
+		if (reset)
+			changes.insert(changes.begin(),
+				result_update{result_change::reset, generation_, stream_info_impl(), 0});
+	}
+	if (pruned) notify_changes();
+	return generation;
+}
+
+bool resolver_impl::wait_for_changes(uint64_t since, double timeout) {
+	std::unique_lock<std::mutex> lock(results_mut_);
+	return results_changed_.wait_for(lock, std::chrono::duration<double>(timeout),
+			   [&] { return generation_ > since || cancelled_; }) &&
+		   generation_ > since;
+}
+
+void resolver_impl::set_change_callback(std::function<void(uint64_t)> callback) {
+	std::lock_guard<std::mutex> lock(results_mut_);
+	change_callback_ = std::move(callback);
+}
+
+bool resolver_impl::add_result(stream_info_impl &&info, const asio::ip::address &addr) {
 	std::lock_guard<std::mutex> lock(results_mut_);
-	double expired_before = lsl_clock() - forget_after_;
+	const double now = lsl_clock();
+	std::string uid = info.uid();
+	auto it = results_.find(uid);
+	const bool is_new = it == results_.end();
+	if (is_new)
+		it = results_.emplace(std::move(uid), resolve_result{std::move(info), now, 0, 0}).first;
+	else
+		it->second.last_seen = now; // update only the receive time
+	auto &stored_info = it->second.info;
+	// ... also update the address associated with the result (but don't override the address of
+	// an earlier record for this stream since this would be the faster route)
+	bool changed = is_new;
+	if (addr.is_v4()) {
+		if (stored_info.v4address().empty()) {
+			stored_info.v4address(addr.to_string());
+			changed = true;
+		}
+	} else {
+		if (stored_info.v6address().empty()) {
+			stored_info.v6address(addr.to_string());
+			changed = true;
+		}
+	}
+	if (changed) it->second.generation = ++generation_;
+	if (is_new) it->second.found = it->second.generation;
+	return changed;
+}
 
+bool resolver_impl::prune_results(double now) {
+	const double expired_before = now - forget_after_;
+	bool pruned = false;
 	for (auto it = results_.begin(); it != results_.end();) {
-		if (it->second.second < expired_before)
+		if (it->second.last_seen < expired_before) {
+			removed_.push_back(result_update{result_change::removed, ++generation_,
+				std::move(it->second.info), it->second.found});
 			it = results_.erase(it);
-		else {
-			if (output.size() < max_results) output.push_back(it->second.first);
-			it++;
-		}
+			pruned = true;
+		} else
+			++it;
 	}
-	return output;
+	while (removed_.size() > max_removed_results) {
+		removed_forgotten_ = removed_.front().generation;
+		removed_.pop_front();
+	}
+	return pruned;
+}
+
+bool resolver_impl::can_continue_from(uint64_t since, uint64_t at) const {
+	// the removals before `at` that the consumer didn't get have to be known
+	if (at < removed_forgotten_) return false;
+	// a stream found in between that changed or was removed later wasn't returned yet
+	auto straddles = [since, at](uint64_t found, uint64_t generation) {
+		return found > since && found <= at && generation > at;
+	};
+	for (const auto &result : results_)
+		if (straddles(result.second.found, result.second.generation)) return false;
+	for (const auto &removed : removed_)
+		if (straddles(removed.found, removed.generation)) return false;
+	return true;
+}
+
+void resolver_impl::clear_results() {
+	std::lock_guard<std::mutex> lock(results_mut_);
+	results_.clear();
+	removed_.clear();
+	removed_forgotten_ = generation_;
+}
+
+void resolver_impl::notify_changes() {
+	results_changed_.notify_all();
+	// the callback runs on the resolver's thread, also when results() or changes_since() forgot
+	// some results, so it doesn't run within the application's calls
+	post(*io_, [this]() {
+		std::function<void(uint64_t)> callback;
+		uint64_t generation;
+		{
+			std::lock_guard<std::mutex> lock(results_mut_);
+			callback = change_callback_;
+			generation = generation_;
+		}
+		if (!callback) return;
+		try {
+			callback(generation);
+		} catch (std::exception &e) {
+			LOG_F(WARNING, "Error in a resolver's change callback: %s", e.what());
+		}
+	});
 }
 
 // === timer-driven async handlers ===
 
 void resolver_impl::next_resolve_wave() {
+	// in continuous mode, streams are also forgotten while nobody asks for the results so that
+	// waiting consumers learn about it
+	if (forget_after_ != FOREVER) {
+		bool pruned;
+		{
+			std::lock_guard<std::mutex> lock(results_mut_);
+			pruned = prune_results(lsl_clock());
+		}
+		if (pruned) notify_changes();
+	}
 	if (check_cancellation_criteria()) {
 		// stopping criteria satisfied: cancel the ongoing operations
 		cancel_ongoing_resolve();
@@ -234,7 +404,12 @@ void resolver_impl::udp_unicast_burst(err_t err) {
 // === cancellation and teardown ===
 
 void resolver_impl::cancel() {
-	cancelled_ = true;
+	{
+		// wake up consumers in wait_for_changes()
+		std::lock_guard<std::mutex> lock(results_mut_);
+		cancelled_ = true;
+	}
+	results_changed_.notify_all();
 	cancel_ongoing_resolve();
 }
 
@@ -9,6 +9,10 @@
 #include <asio/ip/udp.hpp>
 #include <asio/steady_timer.hpp>
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -25,8 +29,39 @@ class api_config;
 
 using steady_timer = asio::basic_waitable_timer<asio::chrono::steady_clock, asio::wait_traits<asio::chrono::steady_clock>, asio::io_context::executor_type>;
 
-/// A container for resolve results (map from stream instance UID onto (stream_info,receive-time)).
-using result_container = std::map<std::string, std::pair<stream_info_impl, double>>;
+/// A resolve result, i.e. a stream that answered a query.
+struct resolve_result {
+	stream_info_impl info;
+	/// the time when the stream last answered a query
+	double last_seen;
+	/// the generation in which the stream was found or last changed
+	uint64_t generation;
+	/// the generation in which the stream was found
+	uint64_t found;
+};
+
+/// A container for resolve results (map from stream instance UID onto the result).
+using result_container = std::map<std::string, resolve_result>;
+
+/// The kinds of changes reported by resolver_impl::changes_since(), see lsl_resolver_change_t.
+enum class result_change : int32_t {
+	/// The earlier changes are no longer known; forget all streams and apply the following changes
+	reset = 0,
+	added = 1,
+	changed = 2,
+	removed = 3
+};
+
+/// A change of the resolve results.
+struct result_update {
+	result_change kind;
+	/// the generation in which the change happened
+	uint64_t generation;
+	/// the stream as it is now (or was when it was removed); empty for result_change::reset
+	stream_info_impl info;
+	/// the generation in which the stream was found
+	uint64_t found;
+};
 
 /**
  * A stream resolver object.
@@ -118,6 +153,37 @@ public:
 	/// Get the current set of results (e.g., during continuous operation).
 	std::vector<stream_info_impl> results(uint32_t max_results = 4294967295);
 
+	/**
+	 * Get the changes of the results after a given generation.
+	 *
+	 * Every change (a stream is found, changes or is forgotten) increments the resolver's
+	 * generation, so a consumer can keep its own copy of the results up to date by applying the
+	 * changes in order instead of copying all results.
+	 * @param since The generation returned by the previous call, or 0 to get all current results
+	 * as added.
+	 * @param[out] changes Receives the changes, ordered by generation. If the removals after
+	 * `since` were already forgotten, the first change is a result_change::reset followed by all
+	 * current results.
+	 * @param max_changes If there are more changes, only the first ones are returned, up to a
+	 * generation the consumer can continue from. If even the shortest such part is longer, it is
+	 * returned anyway so the caller can report the needed size.
+	 * @return The generation to continue from, i.e., the current one if all changes were returned.
+	 */
+	uint64_t changes_since(uint64_t since, std::vector<result_update> &changes,
+		std::size_t max_changes = static_cast<std::size_t>(-1));
+
+	/**
+	 * Wait until the results change after the given generation.
+	 * @return Whether the results have changed before the timeout expired.
+	 */
+	bool wait_for_changes(uint64_t since, double timeout = FOREVER);
+
+	/**
+	 * Set a function that is called (on the resolver's thread) with the new generation whenever
+	 * the results change. Pass an empty function to remove it.
+	 */
+	void set_change_callback(std::function<void(uint64_t)> callback);
+
 	/**
 	 * Tear down any ongoing operations and render the resolver unusable.
 	 *
@@ -126,6 +192,12 @@ public:
 	 */
 	void cancel();
 
+	/**
+	 * Add a stream that answered our query from the given address, or update its entry.
+	 * @return Whether the results changed (the callers notify the consumers).
+	 */
+	bool add_result(stream_info_impl &&info, const asio::ip::address &addr);
+
 	enum class resolver_status {
 		empty, started_oneshot, running_continuous
 	};
@@ -148,6 +220,23 @@ private:
 	/// Cancel the currently ongoing resolve, if any.
 	void cancel_ongoing_resolve();
 
+	/// Forget all results, e.g. when starting a new query.
+	void clear_results();
+
+	/// Forget results that are older than forget_after_. Needs to be called with results_mut_ held.
+	/// @return Whether any result was removed.
+	bool prune_results(double now);
+
+	/**
+	 * Check if a consumer that knew the results at generation `since` can continue from
+	 * generation `at` after getting only the changes up to it, i.e., no stream found in between
+	 * changed later and no removals it needs were forgotten. Needs results_mut_ held.
+	 */
+	bool can_continue_from(uint64_t since, uint64_t at) const;
+
+	/// Wake up consumers waiting for changes and post a call of the change callback.
+	void notify_changes();
+
 
 	// constants (mostly config-deduced)
 	/// pointer to our configuration object
@@ -180,8 +269,18 @@ private:
 	bool fast_mode_;
 	/// results are stored here
 	result_container results_;
-	/// a mutex that protects the results map
+	/// the generation of the results, incremented on every change
+	uint64_t generation_{0};
+	/// the most recently removed results, ordered by generation
+	std::deque<result_update> removed_;
+	/// removals up to this generation were dropped from removed_
+	uint64_t removed_forgotten_{0};
+	/// a mutex that protects the results map, the generation and the removals
 	std::mutex results_mut_;
+	/// notified when the generation changes
+	std::condition_variable results_changed_;
+	/// called when the generation changes, protected by results_mut_
+	std::function<void(uint64_t)> change_callback_;
 
 	// io objects
 	/// our IO service
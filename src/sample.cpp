@@ -1,10 +1,12 @@
 #include <algorithm>
 #define BOOST_MATH_DISABLE_STD_FPCLASSIFY
 #include "sample.h"
+#include "api_config.h"
 #include "common.h"
 #include "portable_archive/portable_iarchive.hpp"
 #include "portable_archive/portable_oarchive.hpp"
 #include "util/cast.hpp"
+#include "util/simd.hpp"
 #include <boost/endian/conversion.hpp>
 
 using namespace lsl;
@@ -37,13 +39,133 @@ template <typename T> inline dataiter<const T> samplevals(const sample &s) noexc
 	return dataiter<const T>(iterhelper(s), s.num_channels());
 }
 
-/// Copy an array, converting between LSL types if needed
+/// Copy an array, converting between LSL types value by value
 template <typename T, typename U>
-inline void copyconvert_array(const T *src, U *dst, std::size_t n) noexcept {
+inline void copyconvert_scalar(const T *src, U *dst, std::size_t n) noexcept {
 	for (const T *end = src + n; src < end;)
 		*dst++ = static_cast<U>(*src++); // NOLINT(bugprone-signed-char-misuse)
 }
 
+/// Copy an array, converting between LSL types if needed
+template <typename T, typename U>
+inline void copyconvert_array(const T *src, U *dst, std::size_t n) noexcept {
+	copyconvert_scalar(src, dst, n);
+}
+
+// Vectorized conversions for the common numeric cases (e.g. int16 acquisition data pulled as
+// float). They produce the same results as static_cast, i.e. they use the current rounding mode.
+#if defined(LSL_SIMD_SSE2)
+/// sign-extend the lower / upper four int16 values to int32
+inline __m128i cvtepi16lo_epi32(__m128i v) noexcept {
+	return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+}
+inline __m128i cvtepi16hi_epi32(__m128i v) noexcept {
+	return _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+}
+
+inline void copyconvert_array(const int16_t *src, float *dst, std::size_t n) noexcept {
+	for (const int16_t *end = src + n - n % 8; src < end; src += 8, dst += 8) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+		_mm_storeu_ps(dst, _mm_cvtepi32_ps(cvtepi16lo_epi32(v)));
+		_mm_storeu_ps(dst + 4, _mm_cvtepi32_ps(cvtepi16hi_epi32(v)));
+	}
+	copyconvert_scalar(src, dst, n % 8);
+}
+
+inline void copyconvert_array(const int16_t *src, double *dst, std::size_t n) noexcept {
+	for (const int16_t *end = src + n - n % 8; src < end; src += 8, dst += 8) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src)),
+					  lo = cvtepi16lo_epi32(v), hi = cvtepi16hi_epi32(v);
+		_mm_storeu_pd(dst, _mm_cvtepi32_pd(lo));
+		_mm_storeu_pd(dst + 2, _mm_cvtepi32_pd(_mm_unpackhi_epi64(lo, lo)));
+		_mm_storeu_pd(dst + 4, _mm_cvtepi32_pd(hi));
+		_mm_storeu_pd(dst + 6, _mm_cvtepi32_pd(_mm_unpackhi_epi64(hi, hi)));
+	}
+	copyconvert_scalar(src, dst, n % 8);
+}
+
+inline void copyconvert_array(const int32_t *src, float *dst, std::size_t n) noexcept {
+	for (const int32_t *end = src + n - n % 4; src < end; src += 4, dst += 4) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+		_mm_storeu_ps(dst, _mm_cvtepi32_ps(v));
+	}
+	copyconvert_scalar(src, dst, n % 4);
+}
+
+inline void copyconvert_array(const int32_t *src, double *dst, std::size_t n) noexcept {
+	for (const int32_t *end = src + n - n % 4; src < end; src += 4, dst += 4) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+		_mm_storeu_pd(dst, _mm_cvtepi32_pd(v));
+		_mm_storeu_pd(dst + 2, _mm_cvtepi32_pd(_mm_unpackhi_epi64(v, v)));
+	}
+	copyconvert_scalar(src, dst, n % 4);
+}
+
+inline void copyconvert_array(const float *src, double *dst, std::size_t n) noexcept {
+	for (const float *end = src + n - n % 4; src < end; src += 4, dst += 4) {
+		const __m128 v = _mm_loadu_ps(src);
+		_mm_storeu_pd(dst, _mm_cvtps_pd(v));
+		_mm_storeu_pd(dst + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+	}
+	copyconvert_scalar(src, dst, n % 4);
+}
+
+inline void copyconvert_array(const double *src, float *dst, std::size_t n) noexcept {
+	for (const double *end = src + n - n % 4; src < end; src += 4, dst += 4)
+		_mm_storeu_ps(dst, _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(src)),
+							   _mm_cvtpd_ps(_mm_loadu_pd(src + 2))));
+	copyconvert_scalar(src, dst, n % 4);
+}
+#elif defined(LSL_SIMD_NEON)
+inline void copyconvert_array(const int16_t *src, float *dst, std::size_t n) noexcept {
+	for (const int16_t *end = src + n - n % 8; src < end; src += 8, dst += 8) {
+		const int16x8_t v = vld1q_s16(src);
+		vst1q_f32(dst, vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))));
+		vst1q_f32(dst + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))));
+	}
+	copyconvert_scalar(src, dst, n % 8);
+}
+
+inline void copyconvert_array(const int16_t *src, double *dst, std::size_t n) noexcept {
+	for (const int16_t *end = src + n - n % 4; src < end; src += 4, dst += 4) {
+		const int32x4_t v = vmovl_s16(vld1_s16(src));
+		vst1q_f64(dst, vcvtq_f64_s64(vmovl_s32(vget_low_s32(v))));
+		vst1q_f64(dst + 2, vcvtq_f64_s64(vmovl_s32(vget_high_s32(v))));
+	}
+	copyconvert_scalar(src, dst, n % 4);
+}
+
+inline void copyconvert_array(const int32_t *src, float *dst, std::size_t n) noexcept {
+	for (const int32_t *end = src + n - n % 4; src < end; src += 4, dst += 4)
+		vst1q_f32(dst, vcvtq_f32_s32(vld1q_s32(src)));
+	copyconvert_scalar(src, dst, n % 4);
+}
+
+inline void copyconvert_array(const int32_t *src, double *dst, std::size_t n) noexcept {
+	for (const int32_t *end = src + n - n % 2; src < end; src += 2, dst += 2)
+		vst1q_f64(dst, vcvtq_f64_s64(vmovl_s32(vld1_s32(src))));
+	copyconvert_scalar(src, dst, n % 2);
+}
+
+inline void copyconvert_array(const int64_t *src, double *dst, std::size_t n) noexcept {
+	for (const int64_t *end = src + n - n % 2; src < end; src += 2, dst += 2)
+		vst1q_f64(dst, vcvtq_f64_s64(vld1q_s64(src)));
+	copyconvert_scalar(src, dst, n % 2);
+}
+
+inline void copyconvert_array(const float *src, double *dst, std::size_t n) noexcept {
+	for (const float *end = src + n - n % 2; src < end; src += 2, dst += 2)
+		vst1q_f64(dst, vcvt_f64_f32(vld1_f32(src)));
+	copyconvert_scalar(src, dst, n % 2);
+}
+
+inline void copyconvert_array(const double *src, float *dst, std::size_t n) noexcept {
+	for (const double *end = src + n - n % 2; src < end; src += 2, dst += 2)
+		vst1_f32(dst, vcvt_f32_f64(vld1q_f64(src)));
+	copyconvert_scalar(src, dst, n % 2);
+}
+#endif
+
 /// Copy an array, special case: source and destination have the same type
 template <typename T> inline void copyconvert_array(const T *src, T *dst, std::size_t n) noexcept {
 	memcpy(dst, src, n * sizeof(T));
@@ -72,16 +194,6 @@ template <typename T, typename U> void lsl::sample::conv_into(U *dst) {
 	copyconvert_array(reinterpret_cast<const T *>(&data_), dst, num_channels_);
 }
 
-void sample::operator delete(void *x) noexcept {
-	if (x == nullptr) return;
-
-	lsl::factory *factory = reinterpret_cast<sample *>(x)->factory_;
-
-	// delete the underlying memory only if it wasn't allocated in the factory's storage area
-	if (x < factory->storage_ || x >= factory->storage_ + factory->storage_size_)
-		delete[] (char *)x;
-}
-
 /// ensure that a given value is a multiple of some base, round up if necessary
 constexpr uint32_t ensure_multiple(uint32_t v, unsigned base) {
 	return (v % base) ? v - (v % base) + base : v;
@@ -90,8 +202,7 @@ constexpr uint32_t ensure_multiple(uint32_t v, unsigned base) {
 // Sample functions
 
 lsl::sample::~sample() noexcept {
-	if (format_ == cft_string)
-		for (auto &val : samplevals<std::string>(*this)) val.~basic_string<char>();
+	if (format_ == cft_string) delete[] string_buf().bytes;
 }
 
 bool sample::operator==(const sample &rhs) const noexcept {
@@ -100,9 +211,64 @@ bool sample::operator==(const sample &rhs) const noexcept {
 		return false;
 	if (format_ != cft_string) return memcmp(&(rhs.data_), &data_, datasize()) == 0;
 
-	// For string values, each value has to be compared individually
-	auto thisvals = samplevals<const std::string>(*this);
-	return std::equal(thisvals.begin(), thisvals.end(), samplevals<std::string>(rhs).begin());
+	// string values are equal if they end at the same offsets and all bytes are the same
+	if (num_channels_ == 0) return true;
+	const std::size_t bytes = string_ends()[num_channels_ - 1];
+	return memcmp(string_ends(), rhs.string_ends(), num_channels_ * sizeof(std::size_t)) == 0 &&
+		   (bytes == 0 || memcmp(string_buf().bytes, rhs.string_buf().bytes, bytes) == 0);
+}
+
+/// buffers for string values larger than this are shrunk again if they're mostly unused
+const std::size_t max_idle_string_bytes = 64 << 10;
+
+char *sample::reserve_strings(std::size_t needed, std::size_t keep) {
+	string_buffer &buf = string_buf();
+	// samples are recycled, so an unusually large value shouldn't pin its memory forever
+	const bool oversized =
+		keep == 0 && buf.capacity > max_idle_string_bytes && needed < buf.capacity / 4;
+	if (needed > buf.capacity || oversized) {
+		const std::size_t capacity = keep ? std::max(needed, buf.capacity * 2) : needed;
+		char *bytes = new char[capacity];
+		if (keep) memcpy(bytes, buf.bytes, keep);
+		delete[] buf.bytes;
+		buf.bytes = bytes;
+		buf.capacity = capacity;
+	}
+	return buf.bytes;
+}
+
+void sample::assign_strings(const std::string *src) {
+	std::size_t *ends = string_ends(), end = 0;
+	for (uint32_t k = 0; k < num_channels_; k++) ends[k] = end += src[k].size();
+	char *bytes = reserve_strings(end, 0);
+	for (uint32_t k = 0; k < num_channels_; k++) {
+		if (!src[k].empty()) memcpy(bytes, src[k].data(), src[k].size());
+		bytes += src[k].size();
+	}
+}
+
+template <typename T> void sample::assign_strings(const T *src) {
+	std::vector<std::string> formatted(num_channels_);
+	copyconvert_array(src, formatted.data(), num_channels_);
+	assign_strings(formatted.data());
+}
+
+void sample::retrieve_strings(std::string *dst) const {
+	std::size_t len;
+	for (uint32_t k = 0; k < num_channels_; k++) {
+		const char *value = string_value(k, len);
+		dst[k].assign(value, len);
+	}
+}
+
+template <typename T> void sample::retrieve_strings(T *dst) const {
+	std::string value;
+	for (uint32_t k = 0; k < num_channels_; k++) {
+		std::size_t len;
+		const char *bytes = string_value(k, len);
+		value.assign(bytes, len);
+		dst[k] = lsl::from_string<T>(value);
+	}
 }
 
 template <class T> void lsl::sample::assign_typed(const T *src) {
@@ -115,7 +281,7 @@ template <class T> void lsl::sample::assign_typed(const T *src) {
 #ifndef BOOST_NO_INT64_T
 	case cft_int64: conv_from<int64_t>(src); break;
 #endif
-	case cft_string: conv_from<std::string>(src); break;
+	case cft_string: assign_strings(src); break;
 	default: throw std::invalid_argument("Unsupported channel format.");
 	}
 }
@@ -130,7 +296,7 @@ template <class T> void lsl::sample::retrieve_typed(T *dst) {
 #ifndef BOOST_NO_INT64_T
 	case cft_int64: conv_into<int64_t>(dst); break;
 #endif
-	case cft_string: conv_into<std::string>(dst); break;
+	case cft_string: retrieve_strings(dst); break;
 	default: throw std::invalid_argument("Unsupported channel format.");
 	}
 }
@@ -186,33 +352,50 @@ template <typename T> void save_value(std::streambuf &sb, T v, bool reverse_byte
 	save_raw(sb, &v, sizeof(T));
 }
 
+std::size_t sample::save_header(char *buf, bool reverse_byte_order) const {
+	if (timestamp_ == DEDUCED_TIMESTAMP) {
+		buf[0] = TAG_DEDUCED_TIMESTAMP;
+		return 1;
+	}
+	buf[0] = TAG_TRANSMITTED_TIMESTAMP;
+	double timestamp = timestamp_;
+	if (reverse_byte_order) endian_reverse_inplace(timestamp);
+	memcpy(buf + 1, &timestamp, sizeof(timestamp));
+	return 1 + sizeof(timestamp);
+}
+
+std::size_t sample::save_drop_notice(char *buf, uint32_t dropped, bool reverse_byte_order) {
+	buf[0] = TAG_DROPPED_SAMPLES;
+	if (reverse_byte_order) endian_reverse_inplace(dropped);
+	memcpy(buf + 1, &dropped, sizeof(dropped));
+	return 1 + sizeof(dropped);
+}
+
 void sample::save_streambuf(
 	std::streambuf &sb, int /*protocol_version*/, bool reverse_byte_order, void *scratchpad) const {
 	// write sample header
-	if (timestamp_ == DEDUCED_TIMESTAMP) {
-		save_byte(sb, TAG_DEDUCED_TIMESTAMP);
-	} else {
-		save_byte(sb, TAG_TRANSMITTED_TIMESTAMP);
-		save_value(sb, timestamp_, reverse_byte_order);
-	}
+	char header[max_header_bytes];
+	save_raw(sb, header, save_header(header, reverse_byte_order));
 	// write channel data
 	if (format_ == cft_string) {
-		for (const auto &str : samplevals<std::string>(*this)) {
+		for (uint32_t k = 0; k < num_channels_; k++) {
+			std::size_t len;
+			const char *str = string_value(k, len);
 			// write string length as variable-length integer
-			if (str.size() <= 0xFF) {
+			if (len <= 0xFF) {
 				save_byte(sb, static_cast<uint8_t>(sizeof(uint8_t)));
-				save_byte(sb, static_cast<uint8_t>(str.size()));
+				save_byte(sb, static_cast<uint8_t>(len));
 			} else {
-				if (str.size() <= 0xFFFFFFFF) {
+				if (len <= 0xFFFFFFFF) {
 					save_byte(sb, static_cast<uint8_t>(sizeof(uint32_t)));
-					save_value(sb, static_cast<uint32_t>(str.size()), reverse_byte_order);
+					save_value(sb, static_cast<uint32_t>(len), reverse_byte_order);
 				} else {
 					save_byte(sb, static_cast<uint8_t>(sizeof(uint64_t)));
-					save_value(sb, static_cast<std::size_t>(str.size()), reverse_byte_order);
+					save_value(sb, static_cast<std::size_t>(len), reverse_byte_order);
 				}
 			}
 			// write string contents
-			if (!str.empty()) save_raw(sb, str.data(), str.size());
+			if (len) save_raw(sb, str, len);
 		}
 	} else {
 		// write numeric data in binary
@@ -226,10 +409,17 @@ void sample::save_streambuf(
 	}
 }
 
-void sample::load_streambuf(
-	std::streambuf &sb, int /*unused*/, bool reverse_byte_order, bool suppress_subnormals) {
-	// read sample header
-	if (load_byte(sb) == TAG_DEDUCED_TIMESTAMP)
+void sample::load_streambuf(std::streambuf &sb, int /*unused*/, bool reverse_byte_order,
+	bool suppress_subnormals, uint32_t *dropped) {
+	// read sample header, which may be preceded by a notice about dropped samples
+	uint8_t tag = load_byte(sb);
+	uint32_t num_dropped = 0;
+	if (tag == TAG_DROPPED_SAMPLES) {
+		num_dropped = load_value<uint32_t>(sb, reverse_byte_order);
+		tag = load_byte(sb);
+	}
+	if (dropped) *dropped = num_dropped;
+	if (tag == TAG_DEDUCED_TIMESTAMP)
 		// deduce the timestamp
 		timestamp_ = DEDUCED_TIMESTAMP;
 	else
@@ -238,7 +428,8 @@ void sample::load_streambuf(
 
 	// read channel data
 	if (format_ == cft_string) {
-		for (auto &str : samplevals<std::string>(*this)) {
+		std::size_t *ends = string_ends(), end = 0;
+		for (uint32_t k = 0; k < num_channels_; k++) {
 			// read string length as variable-length integer
 			std::size_t len = 0;
 			auto lenbytes = load_byte(sb);
@@ -255,49 +446,150 @@ void sample::load_streambuf(
 #endif
 			default: throw std::runtime_error("Stream contents corrupted (invalid varlen int).");
 			}
-			// read string contents
-			str.resize(len);
-			if (len > 0) load_raw(sb, (void*) str.data(), len);
+			// read string contents, appended to the previous values
+			char *bytes = reserve_strings(end + len, end);
+			if (len > 0) load_raw(sb, bytes + end, len);
+			ends[k] = end += len;
 		}
 	} else {
 		// read numeric channel data
 		load_raw(sb, &data_, datasize());
 		if (reverse_byte_order && format_sizes[format_] > 1)
 			convert_endian(&data_, num_channels(), format_sizes[format_]);
-		if (suppress_subnormals && format_float[format_]) {
-			if (format_ == cft_float32) {
-				for (auto &val : samplevals<uint32_t>(*this))
-					if (val && ((val & UINT32_C(0x7fffffff)) <= UINT32_C(0x007fffff)))
-						val &= UINT32_C(0x80000000);
-			} else {
-#ifndef BOOST_NO_INT64_T
-				for (auto &val : samplevals<uint64_t>(*this))
-					if (val &&
-						((val & UINT64_C(0x7fffffffffffffff)) <= UINT64_C(0x000fffffffffffff)))
-						val &= UINT64_C(0x8000000000000000);
-#endif
-			}
-		}
+		if (suppress_subnormals && format_float[format_])
+			sample::suppress_subnormals(&data_, num_channels(), format_sizes[format_]);
 	}
 }
 
+/// Reverse the byte order of each value in a block of 16 bytes
+template <typename T> inline void endian_reverse_block(void *block) noexcept;
+
+#if defined(LSL_SIMD_SSE2)
+/// swap the two bytes in each 16 bit lane
+inline __m128i swap_bytes_epi16(__m128i v) noexcept {
+	return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+template <> inline void endian_reverse_block<uint16_t>(void *block) noexcept {
+	auto *p = reinterpret_cast<__m128i *>(block);
+	_mm_storeu_si128(p, swap_bytes_epi16(_mm_loadu_si128(p)));
+}
+
+template <> inline void endian_reverse_block<uint32_t>(void *block) noexcept {
+	auto *p = reinterpret_cast<__m128i *>(block);
+	// swap the 16 bit halves of each value, then the bytes in each half
+	__m128i v = _mm_shufflelo_epi16(_mm_loadu_si128(p), _MM_SHUFFLE(2, 3, 0, 1));
+	v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+	_mm_storeu_si128(p, swap_bytes_epi16(v));
+}
+
+template <> inline void endian_reverse_block<uint64_t>(void *block) noexcept {
+	auto *p = reinterpret_cast<__m128i *>(block);
+	// reverse the 16 bit words of each value, then the bytes in each word
+	__m128i v = _mm_shufflelo_epi16(_mm_loadu_si128(p), _MM_SHUFFLE(0, 1, 2, 3));
+	v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+	_mm_storeu_si128(p, swap_bytes_epi16(v));
+}
+#elif defined(LSL_SIMD_NEON)
+template <> inline void endian_reverse_block<uint16_t>(void *block) noexcept {
+	auto *p = reinterpret_cast<uint8_t *>(block);
+	vst1q_u8(p, vrev16q_u8(vld1q_u8(p)));
+}
+
+template <> inline void endian_reverse_block<uint32_t>(void *block) noexcept {
+	auto *p = reinterpret_cast<uint8_t *>(block);
+	vst1q_u8(p, vrev32q_u8(vld1q_u8(p)));
+}
+
+template <> inline void endian_reverse_block<uint64_t>(void *block) noexcept {
+	auto *p = reinterpret_cast<uint8_t *>(block);
+	vst1q_u8(p, vrev64q_u8(vld1q_u8(p)));
+}
+#endif
+
+/// Reverse the byte order of n values in place
+template <typename T> inline void endian_reverse_array(void *data, std::size_t n) noexcept {
+	T *vals = reinterpret_cast<T *>(data), *end = vals + n;
+#ifdef LSL_SIMD
+	for (const std::size_t per_block = simd_width / sizeof(T); vals + per_block <= end;
+		 vals += per_block)
+		endian_reverse_block<T>(vals);
+#endif
+	for (; vals != end; ++vals) endian_reverse_inplace(*vals);
+}
+
 void lsl::sample::convert_endian(void *data, uint32_t n, uint32_t width) {
-	void *dataptr = reinterpret_cast<void *>(data);
 	switch (width) {
 	case 1: break;
-	case sizeof(int16_t):
-		for (auto &val : dataiter<int16_t>(dataptr, n)) endian_reverse_inplace(val);
-		break;
-	case sizeof(int32_t):
-		for (auto &val : dataiter<int32_t>(dataptr, n)) endian_reverse_inplace(val);
-		break;
-	case sizeof(int64_t):
-		for (auto &val : dataiter<int64_t>(dataptr, n)) endian_reverse_inplace(val);
-		break;
+	case sizeof(int16_t): endian_reverse_array<uint16_t>(data, n); break;
+	case sizeof(int32_t): endian_reverse_array<uint32_t>(data, n); break;
+	case sizeof(int64_t): endian_reverse_array<uint64_t>(data, n); break;
 	default: throw std::runtime_error("Unsupported channel format for endian conversion.");
 	}
 }
 
+/// Set all subnormal values (given as their bit patterns) to zero, keeping their sign
+inline void suppress_subnormal_array(uint32_t *vals, std::size_t n) noexcept {
+	uint32_t *end = vals + n;
+#if defined(LSL_SIMD_SSE2)
+	// the magnitude is never negative, so the signed comparison is fine
+	const __m128i magnitude = _mm_set1_epi32(0x7fffffff), min_normal = _mm_set1_epi32(0x00800000);
+	for (; vals + 4 <= end; vals += 4) {
+		auto *p = reinterpret_cast<__m128i *>(vals);
+		const __m128i v = _mm_loadu_si128(p),
+					  subnormal = _mm_cmplt_epi32(_mm_and_si128(v, magnitude), min_normal);
+		_mm_storeu_si128(p, _mm_andnot_si128(_mm_and_si128(subnormal, magnitude), v));
+	}
+#elif defined(LSL_SIMD_NEON)
+	const uint32x4_t magnitude = vdupq_n_u32(0x7fffffff), min_normal = vdupq_n_u32(0x00800000);
+	for (; vals + 4 <= end; vals += 4) {
+		const uint32x4_t v = vld1q_u32(vals),
+						 subnormal = vcltq_u32(vandq_u32(v, magnitude), min_normal);
+		vst1q_u32(vals, vbicq_u32(v, vandq_u32(subnormal, magnitude)));
+	}
+#endif
+	for (; vals != end; ++vals)
+		if ((*vals & UINT32_C(0x7fffffff)) <= UINT32_C(0x007fffff)) *vals &= UINT32_C(0x80000000);
+}
+
+inline void suppress_subnormal_array(uint64_t *vals, std::size_t n) noexcept {
+	uint64_t *end = vals + n;
+#if defined(LSL_SIMD_SSE2)
+	// SSE2 has no 64 bit comparison, but a double is subnormal iff the magnitude of its upper
+	// 32 bits is below the smallest normal number's upper half
+	const __m128i magnitude = _mm_set_epi32(0x7fffffff, -1, 0x7fffffff, -1),
+				  min_normal = _mm_set1_epi32(0x00100000);
+	for (; vals + 2 <= end; vals += 2) {
+		auto *p = reinterpret_cast<__m128i *>(vals);
+		const __m128i v = _mm_loadu_si128(p),
+					  subnormal_hi = _mm_cmplt_epi32(_mm_and_si128(v, magnitude), min_normal),
+					  subnormal = _mm_shuffle_epi32(subnormal_hi, _MM_SHUFFLE(3, 3, 1, 1));
+		_mm_storeu_si128(p, _mm_andnot_si128(_mm_and_si128(subnormal, magnitude), v));
+	}
+#elif defined(LSL_SIMD_NEON)
+	const uint64x2_t magnitude = vdupq_n_u64(UINT64_C(0x7fffffffffffffff)),
+					 min_normal = vdupq_n_u64(UINT64_C(0x0010000000000000));
+	for (; vals + 2 <= end; vals += 2) {
+		const uint64x2_t v = vld1q_u64(vals),
+						 subnormal = vcltq_u64(vandq_u64(v, magnitude), min_normal);
+		vst1q_u64(vals, vbicq_u64(v, vandq_u64(subnormal, magnitude)));
+	}
+#endif
+	for (; vals != end; ++vals)
+		if ((*vals & UINT64_C(0x7fffffffffffffff)) <= UINT64_C(0x000fffffffffffff))
+			*vals &= UINT64_C(0x8000000000000000);
+}
+
+void lsl::sample::suppress_subnormals(void *data, uint32_t n, uint32_t width) {
+	switch (width) {
+	case sizeof(float): suppress_subnormal_array(reinterpret_cast<uint32_t *>(data), n); break;
+#ifndef BOOST_NO_INT64_T
+	case sizeof(double): suppress_subnormal_array(reinterpret_cast<uint64_t *>(data), n); break;
+#endif
+	default: throw std::runtime_error("Unsupported channel format for subnormal suppression.");
+	}
+}
+
 template <class Archive> void sample::serialize_channels(Archive &ar, const uint32_t /*unused*/) {
 	switch (format_) {
 	case cft_float32:
@@ -306,9 +598,7 @@ template <class Archive> void sample::serialize_channels(Archive &ar, const uint
 	case cft_double64:
 		for (auto &val : samplevals<double>(*this)) ar &val;
 		break;
-	case cft_string:
-		for (auto &val : samplevals<std::string>(*this)) ar &val;
-		break;
+	case cft_string: serialize_strings(ar); break;
 	case cft_int8:
 		for (auto &val : samplevals<int8_t>(*this)) ar &val;
 		break;
@@ -327,6 +617,22 @@ template <class Archive> void sample::serialize_channels(Archive &ar, const uint
 	}
 }
 
+void sample::serialize_strings(eos::portable_oarchive &ar) {
+	std::string value;
+	for (uint32_t k = 0; k < num_channels_; k++) {
+		std::size_t len;
+		const char *bytes = string_value(k, len);
+		value.assign(bytes, len);
+		ar &value;
+	}
+}
+
+void sample::serialize_strings(eos::portable_iarchive &ar) {
+	std::vector<std::string> values(num_channels_);
+	for (auto &value : values) ar &value;
+	assign_strings(values.data());
+}
+
 void lsl::sample::serialize(eos::portable_oarchive &ar, const uint32_t archive_version) const {
 	// write sample header
 	if (timestamp_ == DEDUCED_TIMESTAMP) {
@@ -373,9 +679,10 @@ sample &sample::assign_test_pattern(int offset) {
 		test_pattern(samplevals<double>(*this).begin(), num_channels_, offset + 16777217);
 		break;
 	case cft_string: {
-		std::string *data = samplevals<std::string>(*this).begin();
+		std::vector<std::string> data(num_channels_);
 		for (int32_t k = 0U; k < (int)num_channels_; k++)
 			data[k] = to_string((k + 10) * (k % 2 == 0 ? 1 : -1));
+		assign_strings(data.data());
 		break;
 	}
 	case cft_int32:
@@ -406,34 +713,82 @@ sample &sample::assign_test_pattern(int offset) {
 
 lsl::sample::sample(lsl_channel_format_t fmt, uint32_t num_channels, factory *fact)
 	: format_(fmt), num_channels_(num_channels), refcount_(0), next_(nullptr), factory_(fact) {
-	// construct std::strings in the data section via placement new
-	if (format_ == cft_string)
-		for (auto &val : samplevals<std::string>(*this)) new (&val) std::string();
+	// start with empty string values and no buffer
+	if (format_ == cft_string) {
+		auto *data = static_cast<char *>(iterhelper(*this));
+		new (data) string_buffer{nullptr, 0};
+		std::uninitialized_fill_n(
+			reinterpret_cast<std::size_t *>(data + sizeof(string_buffer)), num_channels_, 0);
+	}
 }
 
+/// upper limit for the size of an arena added when the pool runs out of samples
+const std::size_t max_arena_bytes = 16 << 20;
+
 factory::factory(lsl_channel_format_t fmt, uint32_t num_chans, uint32_t num_reserve)
+	: factory(fmt, num_chans, num_reserve,
+		  api_config::get_instance()->sample_pool_trim_interval()) {}
+
+factory::factory(
+	lsl_channel_format_t fmt, uint32_t num_chans, uint32_t num_reserve, double trim_interval)
 	: fmt_(fmt), num_chans_(num_chans),
-	  sample_size_(ensure_multiple(
-		  sizeof(sample) - sizeof(sample::data_) + format_sizes[fmt] * num_chans, 16)),
-	  storage_size_(sample_size_ * std::max(2U, num_reserve + 1)),
-	  storage_(new char[storage_size_]), head_(sentinel()), tail_(sentinel()) {
-	// pre-construct an array of samples in the storage area and chain into a freelist
-	// this is functionally identical to calling `reclaim_sample()` for each sample, but alters
-	// the head_/tail_ positions only once
-	sample *s = sample_by_index(0);
-	for (char *p = storage_, *e = p + storage_size_; p < e;) {
-		s = new (reinterpret_cast<sample *>(p)) sample(fmt, num_chans, this);
-		s->next_ = reinterpret_cast<sample *>(p += sample_size_);
-	}
-	s->next_ = nullptr;
-	head_.store(s);
+	  sample_size_(ensure_multiple(static_cast<uint32_t>(sizeof(sample) - sizeof(sample::data_) +
+												   sample::data_section_bytes(fmt, num_chans)),
+		  16)),
+	  trim_interval_(trim_interval), next_trim_(lsl_clock() + trim_interval_) {
+	// the first sample of the first arena is the sentinel, the others go into the freelist
+	const std::size_t num_samples = std::max(2U, num_reserve + 1);
+	construct_arena(num_samples);
+	head_ = tail_ = sentinel();
+	sample *first = sentinel()->next_;
+	sentinel()->next_ = nullptr;
+	push_freelist(first, sample_at(arenas_.front(), num_samples - 1));
+	allocated_ = num_samples - 1;
+}
+
+void factory::construct_arena(std::size_t num_samples) {
+	arenas_.push_back(
+		arena{std::unique_ptr<char[]>(new char[num_samples * sample_size_]), num_samples});
+	const arena &a = arenas_.back();
+	// construct the samples and chain them in order
+	for (std::size_t i = 0; i < num_samples; ++i) {
+		sample *s = new (sample_at(a, i)) sample(fmt_, num_chans_, this);
+		s->next_.store(i + 1 < num_samples ? sample_at(a, i + 1) : nullptr,
+			std::memory_order_relaxed);
+	}
+}
+
+void factory::grow(std::size_t num_samples) {
+	construct_arena(num_samples);
+	allocated_.store(allocated_.load(std::memory_order_relaxed) + num_samples,
+		std::memory_order_relaxed);
+	grows_.store(grows_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	push_freelist(sample_at(arenas_.back(), 0), sample_at(arenas_.back(), num_samples - 1));
 }
 
 sample_p factory::new_sample(double timestamp, bool pushthrough) {
 	sample *result;
-	// try to retrieve a free sample, adding fresh samples until it succeeds
-	while ((result = pop_freelist()) == nullptr)
-		reclaim_sample(new (new char[sample_size_]) sample(fmt_, num_chans_, this));
+	lock_freelist();
+	// try to retrieve a free sample, adding a new arena (doubling the capacity) if there's none
+	while ((result = pop_freelist()) == nullptr) {
+		const std::size_t allocated = allocated_.load(std::memory_order_relaxed);
+		grow(std::min(std::max<std::size_t>(allocated, 16),
+			std::max<std::size_t>(max_arena_bytes / sample_size_, 1)));
+		next_trim_ = lsl_clock() + trim_interval_;
+	}
+
+	// keep track of the peak usage, and check if arenas can be released
+	const uint64_t handed_out = handed_out_.load(std::memory_order_relaxed) + 1;
+	handed_out_.store(handed_out, std::memory_order_relaxed);
+	const auto in_use =
+		static_cast<std::size_t>(handed_out - reclaimed_.load(std::memory_order_relaxed));
+	if (in_use > recent_peak_) {
+		recent_peak_ = in_use;
+		if (in_use > peak_.load(std::memory_order_relaxed))
+			peak_.store(in_use, std::memory_order_relaxed);
+	}
+	if (trim_due()) trim_locked();
+	unlock_freelist();
 
 	result->timestamp_ = timestamp;
 	result->pushthrough = pushthrough;
@@ -456,7 +811,7 @@ sample *factory::pop_freelist() {
 	sample *head = head_.load(std::memory_order_acquire);
 	//
 	if (tail != head) return nullptr;
-	reclaim_sample(sentinel());
+	push_freelist(sentinel(), sentinel());
 	next = tail->next_.load(std::memory_order_acquire);
 	if (next) {
 		tail_ = next;
@@ -465,18 +820,89 @@ sample *factory::pop_freelist() {
 	return nullptr;
 }
 
+factory::pool_stats factory::stats() const {
+	const uint64_t reclaimed = reclaimed_.load(std::memory_order_relaxed);
+	const uint64_t handed_out = handed_out_.load(std::memory_order_relaxed);
+	// the counters are read separately, so a sample could be returned after it was handed out
+	return {allocated_.load(std::memory_order_relaxed),
+		static_cast<std::size_t>(handed_out > reclaimed ? handed_out - reclaimed : 0),
+		peak_.load(std::memory_order_relaxed), grows_.load(std::memory_order_relaxed)};
+}
+
+void factory::trim() {
+	lock_freelist();
+	trim_locked();
+	unlock_freelist();
+}
+
+void factory::trim_if_due() {
+	lock_freelist();
+	if (trim_due()) trim_locked();
+	unlock_freelist();
+}
+
+void factory::trim_locked() {
+	next_trim_ = lsl_clock() + trim_interval_;
+	// take all free samples off the freelist (samples that are being returned right now are
+	// missed, so their arenas are kept) and count them per arena
+	std::vector<sample *> free_samples;
+	while (sample *s = pop_freelist()) free_samples.push_back(s);
+	auto arena_of = [this](const sample *s) {
+		const char *p = reinterpret_cast<const char *>(s);
+		std::size_t i = 0;
+		while (p < arenas_[i].storage.get() ||
+			   p >= arenas_[i].storage.get() + arenas_[i].num_samples * sample_size_)
+			++i;
+		return i;
+	};
+	std::vector<std::size_t> num_free(arenas_.size(), 0);
+	for (sample *s : free_samples) ++num_free[arena_of(s)];
+
+	// release the newest idle arenas, as long as the remaining ones can hold the recent peak
+	std::size_t allocated = allocated_.load(std::memory_order_relaxed);
+	std::vector<bool> release(arenas_.size(), false);
+	for (std::size_t i = arenas_.size() - 1; i > 0; --i)
+		if (num_free[i] == arenas_[i].num_samples &&
+			allocated - arenas_[i].num_samples >= recent_peak_) {
+			release[i] = true;
+			allocated -= arenas_[i].num_samples;
+		}
+	recent_peak_ = static_cast<std::size_t>(
+		handed_out_.load(std::memory_order_relaxed) - reclaimed_.load(std::memory_order_relaxed));
+
+	// put the samples of the remaining arenas back into the freelist
+	sample *first = nullptr, *last = nullptr;
+	for (sample *s : free_samples) {
+		if (release[arena_of(s)]) {
+			s->~sample();
+			continue;
+		}
+		s->next_.store(first, std::memory_order_relaxed);
+		first = s;
+		if (!last) last = s;
+	}
+	if (first) push_freelist(first, last);
+	for (std::size_t i = arenas_.size() - 1; i > 0; --i)
+		if (release[i]) arenas_.erase(arenas_.begin() + static_cast<std::ptrdiff_t>(i));
+	allocated_.store(allocated, std::memory_order_relaxed);
+}
+
 factory::~factory() {
 	for (sample *cur = tail_, *next = cur->next_;; cur = next, next = next->next_) {
-		if (cur != sentinel()) delete cur;
+		if (cur != sentinel()) cur->~sample();
 		if (!next) break;
 	}
-	delete[] storage_;
 }
 
 void factory::reclaim_sample(sample *s) {
-	s->next_.store(nullptr, std::memory_order_release); // TODO: might be _relaxed?
-	sample *prev = head_.exchange(s, std::memory_order_acq_rel);
-	prev->next_.store(s, std::memory_order_release);
+	reclaimed_.fetch_add(1, std::memory_order_relaxed);
+	push_freelist(s, s);
+}
+
+void factory::push_freelist(sample *first, sample *last) {
+	last->next_.store(nullptr, std::memory_order_release); // TODO: might be _relaxed?
+	sample *prev = head_.exchange(last, std::memory_order_acq_rel);
+	prev->next_.store(first, std::memory_order_release);
 }
 
 // template instantiations
@@ -6,9 +6,13 @@
 #include <cstdint>
 #include <iosfwd>
 #include <limits>
+#include <memory>
+#include <new>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <type_traits>
+#include <vector>
 
 
 namespace lsl {
@@ -18,6 +22,9 @@ static_assert(sizeof(double) == 8, "Target arch has unexpected double size (!=8)
 // constants used in the network protocol
 const uint8_t TAG_DEDUCED_TIMESTAMP = 1;
 const uint8_t TAG_TRANSMITTED_TIMESTAMP = 2;
+/// precedes a sample header if the sender dropped samples before it (only if the client asked
+/// for Drop-Notifications), followed by the number of dropped samples as uint32
+const uint8_t TAG_DROPPED_SAMPLES = 3;
 
 /// channel format properties
 const uint8_t format_sizes[] = {0, sizeof(float), sizeof(double), sizeof(std::string),
@@ -31,9 +38,30 @@ const bool format_subnormal[] = {false,
 const bool format_integral[] = {false, false, false, false, true, true, true, true};
 const bool format_float[] = {false, true, true, false, false, false, false, false};
 
-/// A factory to create samples of a given format/size. Must outlive all of its created samples.
+/**
+ * A factory to create samples of a given format/size. Must outlive all of its created samples.
+ *
+ * The samples live in arenas. When all samples are in use, the factory adds an arena that is as
+ * large as all previous ones together (up to a limit), so a burst only costs a few allocations.
+ * Arenas other than the first one are released again once they are idle, i.e. when all of their
+ * samples have been returned and the pool didn't need them for `tuning.SamplePoolTrimInterval`.
+ * new_sample() checks this on every call; an owner that may stop requesting samples calls
+ * trim_if_due() periodically so the arenas are released even then.
+ */
 class factory {
 public:
+	/// Statistics about the samples managed by a factory, in samples.
+	struct pool_stats {
+		/// samples in all arenas
+		std::size_t allocated;
+		/// samples handed out and not returned yet
+		std::size_t in_use;
+		/// the maximum of in_use since the factory was created
+		std::size_t peak;
+		/// the number of times an arena had to be added since the factory was created
+		std::size_t grows;
+	};
+
 	/**
 	 * Create a new factory and optionally pre-allocate samples.
 	 * @param fmt Sample format
@@ -42,43 +70,106 @@ public:
 	 */
 	factory(lsl_channel_format_t fmt, uint32_t num_chans, uint32_t num_reserve);
 
+	/// Create a new factory that releases idle arenas after trim_interval seconds (0: never)
+	/// instead of the configured interval.
+	factory(lsl_channel_format_t fmt, uint32_t num_chans, uint32_t num_reserve,
+		double trim_interval);
+
 	/// Destroy the factory and delete all of its samples.
 	~factory();
 
 	/// Create a new sample with a given timestamp and pushthrough flag.
-	/// Only one thread may call this function for a given factory object.
+	/// Concurrent calls are serialized, but aren't meant to be the common case.
 	sample_p new_sample(double timestamp, bool pushthrough);
 
 	/// Reclaim a sample that's no longer used.
 	void reclaim_sample(sample *s);
 
+	/// Get the current pool statistics. Can be called from any thread.
+	pool_stats stats() const;
+
+	/**
+	 * Release the arenas that aren't needed to hold as many samples as were in use since the last
+	 * call. Can be called from any thread.
+	 */
+	void trim();
+
+	/// Call trim() if the pool has more than one arena and neither grew nor was trimmed for the
+	/// trim interval. Can be called from any thread.
+	void trim_if_due();
+
 private:
+	/// A block of memory holding num_samples samples.
+	struct arena {
+		std::unique_ptr<char[]> storage;
+		std::size_t num_samples;
+	};
+
 	/// Pop a sample from the freelist (multi-producer/single-consumer queue by Dmitry Vjukov)
 	sample *pop_freelist();
 
-	/// Return the address of a pre-allocated sample, #0 is the sentinel value
-	sample *sample_by_index(std::size_t idx) const {
-		return reinterpret_cast<sample *>(storage_ + idx * sample_size_);
+	/// Append a chain of samples (linked via next_) to the freelist.
+	void push_freelist(sample *first, sample *last);
+
+	/// Allocate an arena and construct its samples, each one linked to the next.
+	void construct_arena(std::size_t num_samples);
+
+	/// Add an arena with num_samples samples to the freelist.
+	void grow(std::size_t num_samples);
+
+	/// Wait until no other thread takes samples from the freelist or changes the arenas.
+	void lock_freelist() {
+		while (freelist_busy_.exchange(true, std::memory_order_acquire)) std::this_thread::yield();
+	}
+
+	/// Let other threads take samples from the freelist again.
+	void unlock_freelist() { freelist_busy_.store(false, std::memory_order_release); }
+
+	/// Release idle arenas like trim(), with the freelist already locked.
+	void trim_locked();
+
+	/// Whether trim_if_due() would trim now (freelist locked).
+	bool trim_due() const {
+		return arenas_.size() > 1 && trim_interval_ > 0 && lsl_clock() >= next_trim_;
+	}
+
+	/// Return the address of a sample in an arena
+	sample *sample_at(const arena &a, std::size_t idx) const {
+		return reinterpret_cast<sample *>(a.storage.get() + idx * sample_size_);
 	}
 
 	/// Return the address of the sentinel value
-	sample *sentinel() const { return sample_by_index(0); }
+	sample *sentinel() const { return sample_at(arenas_.front(), 0); }
 
-	friend class sample;
 	/// the channel format to construct samples with
 	const lsl_channel_format_t fmt_;
 	/// the number of channels to construct samples with
 	const uint32_t num_chans_;
 	/// size of a sample, in bytes
 	const uint32_t sample_size_;
-	/// size of the allocated storage, in bytes
-	const uint32_t storage_size_;
-	/// a slab of storage for pre-allocated samples
-	char *const storage_;
+	/// the arenas, the first one holds the sentinel and is never released
+	std::vector<arena> arenas_;
+	/// number of samples in all arenas, excluding the sentinel
+	std::atomic<std::size_t> allocated_{0};
+	/// number of arenas added by new_sample()
+	std::atomic<std::size_t> grows_{0};
+	/// number of samples handed out (only modified with the freelist locked)
+	std::atomic<uint64_t> handed_out_{0};
+	/// the largest number of samples in use, overall and since the last trim()
+	std::atomic<std::size_t> peak_{0};
+	std::size_t recent_peak_{0};
+	/// the minimum time between two trim() calls, in seconds (0: don't release arenas)
+	const double trim_interval_;
+	/// the time of the next trim(), postponed whenever the pool grows
+	double next_trim_;
 	/// head of the freelist
 	std::atomic<sample *> head_;
 	/// tail of the freelist
 	std::atomic<sample *> tail_;
+	/// number of samples returned to the freelist
+	std::atomic<uint64_t> reclaimed_{0};
+	/// set while a thread pops samples from the freelist or changes the arenas
+	std::atomic<bool> freelist_busy_{false};
 };
 
 /**
@@ -116,9 +207,6 @@ public:
 
 	double &timestamp() { return timestamp_; }
 
-	/// Delete a sample.
-	void operator delete(void *x) noexcept;
-
 	/// Test for equality with another sample.
 	bool operator==(const sample &rhs) const noexcept;
 	bool operator!=(const sample &rhs) const noexcept { return !(*this == rhs); }
@@ -129,6 +217,20 @@ public:
 
 	uint32_t num_channels() const { return num_channels_; }
 
+	/// The size of the channel data section for the given format, in bytes.
+	static std::size_t data_section_bytes(lsl_channel_format_t fmt, uint32_t num_channels) {
+		return fmt == cft_string ? sizeof(string_buffer) + num_channels * sizeof(std::size_t)
+								 : format_sizes[fmt] * static_cast<std::size_t>(num_channels);
+	}
+
+	/// Get a channel value of a string-formatted sample (not null-terminated) and its length.
+	const char *string_value(uint32_t channel, std::size_t &length) const {
+		const std::size_t *ends = string_ends();
+		const std::size_t begin = channel ? ends[channel - 1] : 0;
+		length = ends[channel] - begin;
+		return string_buf().bytes + begin;
+	}
+
 	// === type-safe accessors ===
 
 	/// Assign an array of numeric values (with type conversions).
@@ -147,17 +249,40 @@ public:
 
 	// === serialization functions ===
 
+	/// maximum size of a sample header as written by save_header()
+	static constexpr std::size_t max_header_bytes = 1 + sizeof(double);
+
+	/// Serialize the sample header (protocol 1.10) into buf, return the number of bytes written.
+	std::size_t save_header(char *buf, bool reverse_byte_order) const;
+
+	/// size of a notice about dropped samples as written by save_drop_notice()
+	static constexpr std::size_t drop_notice_bytes = 1 + sizeof(uint32_t);
+
+	/// Serialize a notice that `dropped` samples were dropped before the next one into buf,
+	/// return the number of bytes written.
+	static std::size_t save_drop_notice(char *buf, uint32_t dropped, bool reverse_byte_order);
+
+	/// Get a pointer to the binary channel data (not for string-formatted samples).
+	const void *raw_data() const { return &data_; }
+
 	/// Serialize a sample to a stream buffer (protocol 1.10).
 	void save_streambuf(std::streambuf &sb, int protocol_version, bool reverse_byte_order,
 		void *scratchpad = nullptr) const;
 
-	/// Deserialize a sample from a stream buffer (protocol 1.10).
+	/**
+	 * Deserialize a sample from a stream buffer (protocol 1.10).
+	 * @param dropped Optionally receives the number of samples the sender announced to have
+	 * dropped before this one (see save_drop_notice()).
+	 */
 	void load_streambuf(std::streambuf &sb, int protocol_version, bool reverse_byte_order,
-		bool suppress_subnormals);
+		bool suppress_subnormals, uint32_t *dropped = nullptr);
 
 	/// Convert the endianness of channel data in-place.
 	static void convert_endian(void *data, uint32_t n, uint32_t width);
 
+	/// Flush subnormal floating point channel data to (signed) zero in-place.
+	static void suppress_subnormals(void *data, uint32_t n, uint32_t width);
+
 	/// Serialize a sample into a portable archive (protocol 1.00).
 	void serialize(eos::portable_oarchive &ar, uint32_t archive_version) const;
 
@@ -194,6 +319,46 @@ private:
 
 	template <typename T, typename U> void conv_from(const U *src);
 	template <typename T, typename U> void conv_into(U *dst);
+
+	// === string storage ===
+
+	/**
+	 * The channel data of a string-formatted sample starts with a buffer holding all values back
+	 * to back, followed by the offset of the end of each value in the buffer.
+	 * The buffer is kept when the sample is recycled, so string samples usually don't allocate.
+	 */
+	struct string_buffer {
+		char *bytes;
+		std::size_t capacity;
+	};
+
+	// both are constructed in the data section by the constructor
+	string_buffer &string_buf() {
+		return *std::launder(static_cast<string_buffer *>(iterhelper(*this)));
+	}
+	const string_buffer &string_buf() const {
+		return *std::launder(static_cast<const string_buffer *>(iterhelper(*this)));
+	}
+	std::size_t *string_ends() {
+		return std::launder(reinterpret_cast<std::size_t *>(
+			static_cast<char *>(iterhelper(*this)) + sizeof(string_buffer)));
+	}
+	const std::size_t *string_ends() const { return const_cast<sample *>(this)->string_ends(); }
+
+	/// Make room for `needed` bytes of string values, keeping the first `keep` bytes.
+	char *reserve_strings(std::size_t needed, std::size_t keep);
+
+	/// Assign the values of a string-formatted sample.
+	void assign_strings(const std::string *src);
+	template <typename T> void assign_strings(const T *src);
+
+	/// Retrieve the values of a string-formatted sample.
+	void retrieve_strings(std::string *dst) const;
+	template <typename T> void retrieve_strings(T *dst) const;
+
+	/// Serialize (read/write) the values of a string-formatted sample.
+	void serialize_strings(eos::portable_oarchive &ar);
+	void serialize_strings(eos::portable_iarchive &ar);
 };
 
 } // namespace lsl
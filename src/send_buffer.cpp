@@ -4,12 +4,16 @@
 #include <chrono>
 #include <loguru.hpp>
 #include <memory>
+#include <thread>
+#include <utility>
 
 using namespace lsl;
 
-std::shared_ptr<consumer_queue> send_buffer::new_consumer(int max_buffered) {
+std::shared_ptr<consumer_queue> send_buffer::new_consumer(
+	int max_buffered, std::function<void()> on_push, overflow_policy policy) {
 	max_buffered = max_buffered ? std::min(max_buffered, max_capacity_) : max_capacity_;
-	return std::make_shared<consumer_queue>(max_buffered, shared_from_this());
+	return std::make_shared<consumer_queue>(
+		max_buffered, shared_from_this(), std::move(on_push), policy);
 }
 
 
@@ -18,8 +22,52 @@ std::shared_ptr<consumer_queue> send_buffer::new_consumer(int max_buffered) {
  * Will subsequently be seen by all consumers.
  */
 void send_buffer::push_sample(const sample_p &s) {
-	std::lock_guard<std::mutex> lock(consumers_mut_);
-	for (auto &consumer : consumers_) consumer->push_sample(s);
+	const int64_t now = latency_histogram::now();
+	std::lock_guard<std::mutex> lock(push_mut_);
+	for (consumer_queue *consumer : begin_push()) consumer->push_sample(s, now);
+	end_push();
+}
+
+/**
+ * Push a batch of samples onto the send buffer.
+ * Each consumer gets a single wakeup for the whole batch.
+ */
+void send_buffer::push_chunk(const sample_p *samples, std::size_t n) {
+	if (n == 0) return;
+	const int64_t now = latency_histogram::now();
+	std::lock_guard<std::mutex> lock(push_mut_);
+	for (consumer_queue *consumer : begin_push()) consumer->push_chunk(samples, n, now);
+	end_push();
+}
+
+send_buffer::~send_buffer() {
+	delete consumers_.load();
+	for (auto &retired : retired_) delete retired.first;
+}
+
+void send_buffer::replace_consumers(const consumer_set *consumers) {
+	const consumer_set *previous = consumers_.exchange(consumers, std::memory_order_seq_cst);
+	// pairs with begin_push(): the pushes that might still be using the previous set have
+	// started by now
+	retired_.emplace_back(previous, pushes_started_.load(std::memory_order_seq_cst));
+	delete_retired();
+}
+
+void send_buffer::delete_retired() {
+	// pushes take turns, so they finish in the order they started
+	const uint64_t finished = pushes_finished_.load(std::memory_order_acquire);
+	auto unused = std::partition(retired_.begin(), retired_.end(),
+		[finished](const std::pair<const consumer_set *, uint64_t> &retired) {
+			return retired.second > finished;
+		});
+	for (auto it = unused; it != retired_.end(); ++it) delete it->first;
+	retired_.erase(unused, retired_.end());
+}
+
+void send_buffer::wait_for_pushes() {
+	// pushes take turns, so they finish in the order they started
+	const uint64_t started = pushes_started_.load(std::memory_order_seq_cst);
+	while (pushes_finished_.load(std::memory_order_acquire) < started) std::this_thread::yield();
 }
 
 
@@ -27,10 +75,14 @@ void send_buffer::push_sample(const sample_p &s) {
 void send_buffer::register_consumer(consumer_queue *q) {
 	{
 		std::lock_guard<std::mutex> lock(consumers_mut_);
-		if (std::find(consumers_.begin(), consumers_.end(), q) != consumers_.end())
+		const consumer_set &current = *consumers_.load(std::memory_order_relaxed);
+		if (std::find(current.begin(), current.end(), q) != current.end())
 			LOG_F(WARNING, "Duplicate consumer queue in send buffer");
-		else
-			consumers_.push_back(q);
+		else {
+			auto *consumers = new consumer_set(current);
+			consumers->push_back(q);
+			replace_consumers(consumers);
+		}
 	}
 	some_registered_.notify_all();
 }
@@ -38,17 +90,22 @@ void send_buffer::register_consumer(consumer_queue *q) {
 /// Unregister a previously registered consumer.
 void send_buffer::unregister_consumer(consumer_queue *q) {
 	std::lock_guard<std::mutex> lock(consumers_mut_);
-	auto pos = std::find(consumers_.begin(), consumers_.end(), q);
+	const consumer_set &current = *consumers_.load(std::memory_order_relaxed);
+	auto pos = std::find(current.begin(), current.end(), q);
 	// If not found, log an error and return
-	if (pos == consumers_.end()) {
+	if (pos == current.end()) {
 		LOG_F(ERROR, "Trying to remove consumer queue not in send buffer");
 		return;
 	}
 
-	// Put the element to be removed at the end (if it isn't there already) and
-	// remove the last element
-	if (*pos != consumers_.back()) std::swap(*pos, consumers_.back());
-	consumers_.pop_back();
+	auto *consumers = new consumer_set(current.begin(), pos);
+	consumers->insert(consumers->end(), pos + 1, current.end());
+	replace_consumers(consumers);
+	// a push in progress might still be pushing into the consumer (which doesn't wait for room
+	// anymore), but the next one will get the new set
+	wait_for_pushes();
+	delete_retired();
+	retired_stats_.merge(q->stats());
 }
 
 /// Check whether there currently are consumers.
@@ -57,6 +114,13 @@ bool send_buffer::have_consumers() {
 	return some_registered();
 }
 
+void send_buffer::collect_stats(queue_stats &total) {
+	std::lock_guard<std::mutex> lock(consumers_mut_);
+	total.merge(retired_stats_);
+	for (const consumer_queue *consumer : *consumers_.load(std::memory_order_relaxed))
+		total.merge(consumer->stats());
+}
+
 /// Wait until some consumers are present.
 bool send_buffer::wait_for_consumers(double timeout) {
 	std::unique_lock<std::mutex> lock(consumers_mut_);
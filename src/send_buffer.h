@@ -2,10 +2,16 @@
 #define SEND_BUFFER_H
 
 #include "common.h"
+#include "consumer_queue.h"
 #include "forward.h"
+#include "stats.h"
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <utility>
 #include <vector>
 
 namespace lsl {
@@ -18,6 +24,11 @@ namespace lsl {
  * producer-consumer queues (each of which can have its own capacity preferences).
  * The ownership of the send_buffer is shared between the consumer_queues and the owner of the
  * send_buffer.
+ *
+ * The set of consumers is an immutable snapshot that's replaced (copy-on-write) when a consumer
+ * is added or removed, so pushing samples never waits for consumers coming and going. A replaced
+ * snapshot is deleted once the pushes that might still be using it are done, as told by counting
+ * the pushes. A consumer that unregisters waits for these pushes.
  */
 class send_buffer : public std::enable_shared_from_this<send_buffer> {
 	using consumer_set = std::vector<class consumer_queue *>;
@@ -30,6 +41,9 @@ public:
 	 */
 	send_buffer(int max_capacity) : max_capacity_(max_capacity) {}
 
+	/// Destructor. All consumers have unregistered at this point, since they keep us alive.
+	~send_buffer();
+
 	/**
 	 * Add a new consumer queue to the buffer.
 	 *
@@ -38,19 +52,29 @@ public:
 	 * @param max_buffered If non-zero, the queue size for this consumer will be constrained to be
 	 * no larger than this value. Note that the actual queue size will never exceed the max_capacity
 	 * of the send_buffer (so this is a global limit).
+	 * @param on_push Optional push notification callback, see consumer_queue::consumer_queue().
+	 * @param policy What the consumer's queue does if it's full.
 	 * @return Shared pointer to the newly created consumer.
 	 */
-	std::shared_ptr<consumer_queue> new_consumer(int max_buffered = 0);
+	std::shared_ptr<consumer_queue> new_consumer(int max_buffered = 0,
+		std::function<void()> on_push = nullptr,
+		overflow_policy policy = overflow_policy::drop_oldest);
 
 	/// Push a sample onto the send buffer that will subsequently be received by all consumers.
 	void push_sample(const sample_p &s);
 
+	/// Push a batch of samples onto the send buffer; each consumer is only notified once.
+	void push_chunk(const sample_p *samples, std::size_t n);
+
 	/// Wait until some consumers are present.
 	bool wait_for_consumers(double timeout = FOREVER);
 
 	/// Check whether any consumer is currently registered.
 	bool have_consumers();
 
+	/// Add up the statistics of all consumer queues, including the ones that are gone.
+	void collect_stats(queue_stats &total);
+
 private:
 	friend class consumer_queue;
 
@@ -59,17 +83,42 @@ private:
 	/// Unregister a previously registered consumer (called by the consumer_queue).
 	void unregister_consumer(consumer_queue *q);
 
-	/// wait_for_consumers is waiting for this
-	bool some_registered() const { return !consumers_.empty(); }
+	/// wait_for_consumers is waiting for this (called with consumers_mut_ held)
+	bool some_registered() const { return !consumers_.load(std::memory_order_relaxed)->empty(); }
+
+	/// Start a push (called with push_mut_ held), returns the current consumers.
+	const consumer_set &begin_push() {
+		// pairs with replace_consumers(): either it counts our push or we get the new consumers
+		pushes_started_.fetch_add(1, std::memory_order_seq_cst);
+		return *consumers_.load(std::memory_order_seq_cst);
+	}
+	/// Finish the push started by begin_push().
+	void end_push() { pushes_finished_.fetch_add(1, std::memory_order_release); }
+
+	/// Publish a new set of consumers and retire the old one (called with consumers_mut_ held).
+	void replace_consumers(const consumer_set *consumers);
+	/// Delete the retired sets that no push uses anymore (called with consumers_mut_ held).
+	void delete_retired();
+	/// Wait until the pushes that started before the last replace_consumers() are done.
+	void wait_for_pushes();
 
 	/// maximum capacity beyond which the oldest samples will be dropped
 	int max_capacity_;
-	/// a set of registered consumer queues
-	consumer_set consumers_;
-	/// mutex to protect the integrity of consumers_
+	/// the current set of registered consumer queues (never modified, only replaced atomically)
+	std::atomic<const consumer_set *> consumers_{new consumer_set()};
+	/// replaced sets and the number of pushes started by then (protected by consumers_mut_)
+	std::vector<std::pair<const consumer_set *, uint64_t>> retired_;
+	/// mutex to let pushes from different threads take turns, since the consumer queues accept
+	/// only one producer
+	std::mutex push_mut_;
+	/// number of pushes that have started and finished so far
+	std::atomic<uint64_t> pushes_started_{0}, pushes_finished_{0};
+	/// mutex to serialize replacements of consumers_
 	std::mutex consumers_mut_;
 	/// condition variable signaling that a consumer has registered
 	std::condition_variable some_registered_;
+	/// the statistics of the consumers that have unregistered (protected by consumers_mut_)
+	queue_stats retired_stats_;
 };
 } // namespace lsl
 
@@ -0,0 +1,228 @@
+#include "shm_ring.h"
+#include <cstdio>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lsl {
+
+/// the control block at the start of the shared memory segment
+struct shm_ring::header {
+	uint32_t magic;
+	uint32_t layout_version;
+	uint64_t slot_bytes;
+	uint64_t slots;
+	/// set by the consumer once it has attached
+	std::atomic<uint32_t> consumer_attached;
+	/// set by the consumer while it waits for a wakeup
+	std::atomic<uint32_t> consumer_waiting;
+	/// number of samples published by the producer
+	alignas(64) std::atomic<uint64_t> write_pos;
+	/// number of samples released by the consumer
+	alignas(64) std::atomic<uint64_t> read_pos;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+				  std::atomic<uint64_t>::is_always_lock_free,
+	"shared memory rings need address-free atomics");
+
+const uint32_t shm_magic = 0x4c534c52; // "LSLR"
+const uint32_t shm_layout_version = 1;
+/// upper bound for the memory used by a single ring
+const std::size_t max_ring_bytes = 16 << 20;
+
+static std::size_t slot_bytes_for(std::size_t sample_bytes) {
+	// keep the time stamps of all slots 8-byte aligned
+	return (shm_ring::data_offset + sample_bytes + 7) & ~static_cast<std::size_t>(7);
+}
+
+#ifdef _WIN32
+static std::string os_name(const std::string &name) { return "Local\\lsl_" + name; }
+#else
+static std::string os_name(const std::string &name) { return "/lsl_" + name; }
+#endif
+
+static void *create_mapping(const std::string &name, std::size_t bytes) {
+#ifdef _WIN32
+	HANDLE h = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+		static_cast<DWORD>(static_cast<uint64_t>(bytes) >> 32), static_cast<DWORD>(bytes),
+		os_name(name).c_str());
+	if (!h) return nullptr;
+	if (GetLastError() == ERROR_ALREADY_EXISTS) {
+		CloseHandle(h);
+		return nullptr;
+	}
+	// the view keeps the mapping (and its name) alive
+	void *mem = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+	CloseHandle(h);
+	return mem;
+#else
+	int fd = shm_open(os_name(name).c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0) return nullptr;
+	void *mem = ftruncate(fd, static_cast<off_t>(bytes)) == 0
+					? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+					: MAP_FAILED;
+	close(fd);
+	if (mem == MAP_FAILED) {
+		shm_unlink(os_name(name).c_str());
+		return nullptr;
+	}
+	return mem;
+#endif
+}
+
+static void *open_mapping(const std::string &name, std::size_t &bytes) {
+#ifdef _WIN32
+	HANDLE h = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, os_name(name).c_str());
+	if (!h) return nullptr;
+	void *mem = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	CloseHandle(h);
+	MEMORY_BASIC_INFORMATION info;
+	if (mem && VirtualQuery(mem, &info, sizeof(info))) bytes = info.RegionSize;
+	return mem;
+#else
+	int fd = shm_open(os_name(name).c_str(), O_RDWR, 0);
+	if (fd < 0) return nullptr;
+	struct stat st;
+	void *mem = MAP_FAILED;
+	if (fstat(fd, &st) == 0) {
+		bytes = static_cast<std::size_t>(st.st_size);
+		mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+	return mem == MAP_FAILED ? nullptr : mem;
+#endif
+}
+
+static void close_mapping(void *mem, std::size_t bytes) {
+#ifdef _WIN32
+	(void)bytes;
+	UnmapViewOfFile(mem);
+#else
+	munmap(mem, bytes);
+#endif
+}
+
+std::unique_ptr<shm_ring> shm_ring::create(std::size_t sample_bytes, std::size_t min_slots) {
+	const std::size_t slot_bytes = slot_bytes_for(sample_bytes);
+	// round the capacity up to a power of two (so positions can be masked), but within the limit
+	std::size_t slots = 2;
+	while (slots < min_slots && (slots * 2) * slot_bytes <= max_ring_bytes) slots *= 2;
+	const std::size_t bytes = sizeof(header) + slots * slot_bytes;
+
+	std::random_device rng;
+	for (int attempt = 0; attempt < 4; ++attempt) {
+		char name[17];
+		std::snprintf(name, sizeof(name), "%08x%08x", rng(), rng());
+		void *mem = create_mapping(name, bytes);
+		if (!mem) continue;
+		auto *hdr = new (mem) header();
+		hdr->magic = shm_magic;
+		hdr->layout_version = shm_layout_version;
+		hdr->slot_bytes = slot_bytes;
+		hdr->slots = slots;
+		return std::unique_ptr<shm_ring>(new shm_ring(name, mem, bytes, true));
+	}
+	throw std::runtime_error("Could not create a shared memory segment");
+}
+
+std::unique_ptr<shm_ring> shm_ring::attach(const std::string &name, std::size_t sample_bytes) {
+	if (name.empty() || name.find_first_not_of("0123456789abcdef") != std::string::npos)
+		throw std::runtime_error("Invalid shared memory segment name");
+	std::size_t bytes = 0;
+	void *mem = open_mapping(name, bytes);
+	if (!mem) throw std::runtime_error("Could not open the shared memory segment " + name);
+	if (bytes < sizeof(header)) {
+		close_mapping(mem, bytes);
+		throw std::runtime_error("The shared memory segment " + name + " is too small");
+	}
+	std::unique_ptr<shm_ring> ring(new shm_ring(name, mem, bytes, false));
+	const header &hdr = *ring->header_;
+	if (hdr.magic != shm_magic || hdr.layout_version != shm_layout_version ||
+		hdr.slot_bytes != slot_bytes_for(sample_bytes) || !hdr.slots ||
+		(hdr.slots & (hdr.slots - 1)) || bytes < sizeof(header) + hdr.slots * hdr.slot_bytes)
+		throw std::runtime_error(
+			"The shared memory segment " + name + " has an unexpected layout");
+	ring->header_->consumer_attached.store(1, std::memory_order_release);
+	return ring;
+}
+
+shm_ring::shm_ring(std::string name, void *mapping, std::size_t mapping_bytes, bool owner)
+	: name_(std::move(name)), mapping_(mapping), mapping_bytes_(mapping_bytes),
+	  name_linked_(owner), header_(static_cast<header *>(mapping)),
+	  slot_base_(static_cast<char *>(mapping) + sizeof(header)),
+	  slot_bytes_(header_->slot_bytes), slots_(header_->slots) {}
+
+shm_ring::~shm_ring() {
+#ifndef _WIN32
+	if (name_linked_) shm_unlink(os_name(name_).c_str());
+#endif
+	close_mapping(mapping_, mapping_bytes_);
+}
+
+char *shm_ring::reserve() {
+	if (write_pos_ - cached_pos_ >= slots_) {
+		cached_pos_ = header_->read_pos.load(std::memory_order_acquire);
+		if (write_pos_ - cached_pos_ >= slots_) return nullptr;
+	}
+	return slot_base_ + (write_pos_ & (slots_ - 1)) * slot_bytes_;
+}
+
+std::size_t shm_ring::writable() {
+	cached_pos_ = header_->read_pos.load(std::memory_order_acquire);
+	return slots_ - static_cast<std::size_t>(write_pos_ - cached_pos_);
+}
+
+bool shm_ring::publish() {
+	if (write_pos_ == published_pos_) return false;
+	published_pos_ = write_pos_;
+	header_->write_pos.store(write_pos_, std::memory_order_release);
+#ifndef _WIN32
+	// once the consumer has mapped the segment its name isn't needed anymore
+	if (name_linked_ && header_->consumer_attached.load(std::memory_order_acquire)) {
+		shm_unlink(os_name(name_).c_str());
+		name_linked_ = false;
+	}
+#endif
+	// pairs with the fence in prepare_wait(): either we see the waiting flag or the consumer sees
+	// the samples we just published
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	return header_->consumer_waiting.load(std::memory_order_relaxed) &&
+		   header_->consumer_waiting.exchange(0, std::memory_order_acq_rel);
+}
+
+const char *shm_ring::peek() {
+	if (read_pos_ == cached_pos_) {
+		cached_pos_ = header_->write_pos.load(std::memory_order_acquire);
+		if (read_pos_ == cached_pos_) return nullptr;
+	}
+	return slot_base_ + (read_pos_ & (slots_ - 1)) * slot_bytes_;
+}
+
+void shm_ring::pop() { header_->read_pos.store(++read_pos_, std::memory_order_release); }
+
+bool shm_ring::prepare_wait() {
+	header_->consumer_waiting.store(1, std::memory_order_relaxed);
+	// pairs with the fence in publish()
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (header_->write_pos.load(std::memory_order_acquire) == read_pos_) return true;
+	// samples arrived in the meantime; if the producer already took the flag, the wakeup byte it
+	// sends is consumed later as a spurious wakeup
+	header_->consumer_waiting.store(0, std::memory_order_relaxed);
+	return false;
+}
+
+} // namespace lsl
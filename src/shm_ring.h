@@ -0,0 +1,116 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace lsl {
+
+/**
+ * A single-producer single-consumer ring of fixed-size sample slots in shared memory.
+ *
+ * Used to transfer numeric samples between an outlet and an inlet in different processes on the
+ * same host without serializing them and sending them through the network stack.
+ * The producer (a tcp_server session) creates the ring and the consumer (a data_receiver) attaches
+ * to it by its name, which is exchanged during the streamfeed negotiation.
+ *
+ * Each slot holds the time stamp followed by the raw channel data.
+ * The ring itself has no means to block, so a consumer that runs out of samples announces this
+ * with prepare_wait() and then waits for a wakeup byte on the TCP connection, which the producer
+ * sends whenever publish() says that the consumer is waiting.
+ */
+class shm_ring {
+public:
+	/**
+	 * Create a new ring with a unique name.
+	 * @param sample_bytes The size of a sample's channel data in bytes.
+	 * @param min_slots The minimum number of samples the ring can hold.
+	 * @throws std::runtime_error if the shared memory segment couldn't be created.
+	 */
+	static std::unique_ptr<shm_ring> create(std::size_t sample_bytes, std::size_t min_slots);
+
+	/**
+	 * Attach to the ring created by another process.
+	 * @throws std::runtime_error if the ring doesn't exist or its layout doesn't match.
+	 */
+	static std::unique_ptr<shm_ring> attach(const std::string &name, std::size_t sample_bytes);
+
+	/// Unmap the ring (and remove its name if we created it).
+	~shm_ring();
+
+	shm_ring(const shm_ring &) = delete;
+	shm_ring &operator=(const shm_ring &) = delete;
+
+	/// The name under which other processes can attach to the ring.
+	const std::string &name() const { return name_; }
+
+	/// The number of sample slots.
+	std::size_t slots() const { return slots_; }
+
+	// === producer interface ===
+
+	/// Get the slot for the next sample, or nullptr if the ring is full.
+	char *reserve();
+
+	/// The number of samples that can be written before the ring is full.
+	std::size_t writable();
+
+	/// Commit the reserved slot after filling it; it's visible after the next publish().
+	void commit() { ++write_pos_; }
+
+	/// Make the committed samples visible, returns true if the consumer needs a wakeup.
+	/// Does nothing if no samples were committed since the last call.
+	bool publish();
+
+	// === consumer interface ===
+
+	/// Get the slot of the next sample, or nullptr if the ring is empty.
+	const char *peek();
+
+	/// Release the slot returned by peek().
+	void pop();
+
+	/**
+	 * Announce that the consumer is going to wait for a wakeup.
+	 * @return False if samples arrived in the meantime, i.e. the consumer shouldn't wait.
+	 */
+	bool prepare_wait();
+
+	// === slot layout ===
+
+	/// Offset of the time stamp within a slot.
+	static constexpr std::size_t timestamp_offset = 0;
+	/// Offset of the channel data within a slot.
+	static constexpr std::size_t data_offset = sizeof(double);
+
+private:
+	struct header;
+
+	shm_ring(std::string name, void *mapping, std::size_t mapping_bytes, bool owner);
+
+	/// the name of the shared memory segment
+	const std::string name_;
+	/// the mapped memory and its size
+	void *mapping_;
+	const std::size_t mapping_bytes_;
+	/// whether the segment's name still needs to be removed (by the producer that created it)
+	bool name_linked_;
+	/// the control block at the start of the mapping
+	header *header_;
+	/// the first slot
+	char *slot_base_;
+	std::size_t slot_bytes_, slots_;
+	/// local copies of our own position, the other side's is read from the header
+	uint64_t write_pos_{0}, read_pos_{0};
+	/// the write position at the last publish()
+	uint64_t published_pos_{0};
+	/// cached position of the other side, to avoid touching its cache line for every sample
+	uint64_t cached_pos_{0};
+};
+
+} // namespace lsl
+
+#endif
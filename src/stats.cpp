@@ -0,0 +1,51 @@
+#include "stats.h"
+#include "common.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace lsl;
+
+void latency_histogram::merge(const latency_histogram &other) noexcept {
+	for (int i = 0; i < num_buckets; ++i)
+		if (uint64_t n = other.buckets_[i].load(std::memory_order_relaxed))
+			buckets_[i].fetch_add(n, std::memory_order_relaxed);
+}
+
+uint64_t latency_histogram::count() const noexcept {
+	uint64_t n = 0;
+	for (const auto &bucket : buckets_) n += bucket.load(std::memory_order_relaxed);
+	return n;
+}
+
+uint64_t latency_histogram::percentile(double quantile) const noexcept {
+	// the buckets are read one by one, so take the total from the same reads
+	uint64_t counts[num_buckets], total = 0;
+	for (int i = 0; i < num_buckets; ++i)
+		total += counts[i] = buckets_[i].load(std::memory_order_relaxed);
+	if (!total) return 0;
+	const auto rank = std::max<uint64_t>(
+		1, static_cast<uint64_t>(std::ceil(std::min(std::max(quantile, 0.), 1.) * total)));
+	uint64_t seen = 0;
+	for (int i = 0; i < num_buckets; ++i)
+		if ((seen += counts[i]) >= rank) return bucket_upper_bound(i);
+	return bucket_upper_bound(num_buckets - 1);
+}
+
+uint64_t latency_histogram::bucket_upper_bound(int idx) noexcept {
+	if (idx < (1 << sub_bucket_bits)) return static_cast<uint64_t>(idx);
+	const int exponent = (idx >> sub_bucket_bits) + sub_bucket_bits - 1;
+	const uint64_t sub_bucket = idx & sub_bucket_mask;
+	const int shift = exponent - sub_bucket_bits;
+	const uint64_t lower = ((uint64_t(1) << sub_bucket_bits) + sub_bucket) << shift;
+	return lower + (uint64_t(1) << shift) - 1;
+}
+
+int32_t lsl::report_stats(uint64_t samples, const queue_stats &queues, std::size_t pool_grows,
+	uint64_t *stats, int32_t num_stats) {
+	const uint64_t values[lsl_stat_count] = {samples, queues.bytes.value(),
+		queues.dropped.value(), pool_grows, queues.dwell.count(), queues.dwell.percentile(.5),
+		queues.dwell.percentile(.9), queues.dwell.percentile(.99), queues.dwell.percentile(.999)};
+	const int32_t n = std::min<int32_t>(num_stats, lsl_stat_count);
+	std::copy(values, values + n, stats);
+	return n;
+}
@@ -0,0 +1,120 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace lsl {
+
+/**
+ * A statistics counter that's cheap enough for the sample hot path.
+ *
+ * Updates are relaxed atomic additions, so they don't order any other memory accesses. Counters
+ * are kept per queue or per thread, so they're practically never contended.
+ */
+class stat_counter {
+public:
+	void add(uint64_t n = 1) noexcept { value_.fetch_add(n, std::memory_order_relaxed); }
+	uint64_t value() const noexcept { return value_.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<uint64_t> value_{0};
+};
+
+/**
+ * A histogram of durations in nanoseconds.
+ *
+ * Like an HDR histogram, each power of two is divided into a fixed number of linear buckets
+ * (8, so any recorded value is known to within 12.5%) and recording is a single relaxed atomic
+ * increment. Durations beyond ~18 minutes are counted in the last bucket.
+ */
+class latency_histogram {
+public:
+	/// Record a duration.
+	void record(uint64_t ns) noexcept {
+		buckets_[bucket_index(ns)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/// Record the time elapsed since a point in time returned by now().
+	void record_since(int64_t start_ns, int64_t now_ns) noexcept {
+		record(now_ns > start_ns ? static_cast<uint64_t>(now_ns - start_ns) : 0);
+	}
+
+	/// Add the counts of another histogram to this one.
+	void merge(const latency_histogram &other) noexcept;
+
+	/// The number of recorded durations.
+	uint64_t count() const noexcept;
+
+	/**
+	 * Get the duration that `quantile` (0..1) of all recorded durations don't exceed, i.e. the
+	 * upper bound of the bucket it's in. Returns 0 if nothing has been recorded.
+	 */
+	uint64_t percentile(double quantile) const noexcept;
+
+	/// The clock for the durations, in nanoseconds.
+	static int64_t now() noexcept {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch())
+			.count();
+	}
+
+private:
+	/// the number of bits below the most significant one that determine the bucket
+	static constexpr int sub_bucket_bits = 3;
+	static constexpr int sub_bucket_mask = (1 << sub_bucket_bits) - 1;
+	/// the largest exponent (of two) with buckets of its own
+	static constexpr int max_exponent = 39;
+	static constexpr int num_buckets = (max_exponent - sub_bucket_bits + 2) << sub_bucket_bits;
+
+	static int bucket_index(uint64_t ns) noexcept {
+		if (ns < (1u << sub_bucket_bits)) return static_cast<int>(ns);
+		// find the most significant bit
+		int exponent = 0;
+		for (int shift = 32; shift; shift >>= 1)
+			if (ns >> (exponent + shift)) exponent += shift;
+		if (exponent > max_exponent) return num_buckets - 1;
+		// the bits below the most significant one select the linear bucket
+		const auto sub_bucket =
+			static_cast<int>(ns >> (exponent - sub_bucket_bits)) & sub_bucket_mask;
+		return ((exponent - sub_bucket_bits + 1) << sub_bucket_bits) + sub_bucket;
+	}
+
+	/// The largest value that falls into a bucket.
+	static uint64_t bucket_upper_bound(int idx) noexcept;
+
+	std::atomic<uint64_t> buckets_[num_buckets]{};
+};
+
+/// Statistics about a consumer_queue and the consumer that takes samples off it.
+struct queue_stats {
+	/// samples pushed into the queue
+	stat_counter pushed;
+	/// samples dropped because the queue was full
+	stat_counter dropped;
+	/// bytes the consumer has sent or received for the samples (if it's a network transfer)
+	stat_counter bytes;
+	/// time between pushing samples and popping them
+	latency_histogram dwell;
+
+	/// Add the statistics of another queue to these.
+	void merge(const queue_stats &other) noexcept {
+		pushed.add(other.pushed.value());
+		dropped.add(other.dropped.value());
+		bytes.add(other.bytes.value());
+		dwell.merge(other.dwell);
+	}
+};
+
+/**
+ * Write the statistics of an outlet or inlet as lsl_stat_t entries to an array.
+ * @return The number of entries written, i.e. the smaller of lsl_stat_count and num_stats.
+ */
+int32_t report_stats(uint64_t samples, const queue_stats &queues, std::size_t pool_grows,
+	uint64_t *stats, int32_t num_stats);
+
+} // namespace lsl
+
+#endif
@@ -1,11 +1,16 @@
 #include "stream_info_impl.h"
 #include "api_config.h"
+#include "compiled_query.h"
 #include "util/cast.hpp"
 #include "util/uuid.hpp"
 #include <algorithm>
+#include <boost/endian/conversion.hpp>
 #include <cstdlib>
+#include <cstring>
 #include <exception>
+#include <iterator>
 #include <loguru.hpp>
+#include <map>
 #include <sstream>
 #include <stdexcept>
 #include <vector>
@@ -25,10 +30,7 @@ inline const char *pugi_str(const std::string &value) { return value.c_str(); }
 
 stream_info_impl::stream_info_impl()
 	: channel_count_(0), nominal_srate_(0), channel_format_(cft_undefined), version_(0),
-	  v4data_port_(0), v4service_port_(0), v6data_port_(0), v6service_port_(0), created_at_(0) {
-	// initialize XML document
-	write_xml(doc_);
-}
+	  v4data_port_(0), v4service_port_(0), v6data_port_(0), v6service_port_(0), created_at_(0) {}
 
 stream_info_impl::stream_info_impl(const std::string &name, std::string type, int channel_count,
 	double nominal_srate, lsl_channel_format_t channel_format, std::string source_id)
@@ -45,41 +47,48 @@ stream_info_impl::stream_info_impl(const std::string &name, std::string type, in
 	if (channel_format < 0 || channel_format > 7)
 		throw std::invalid_argument("The stream info was created with an unknown channel format " +
 									to_string(static_cast<int>(channel_format)));
-	// initialize XML document
-	write_xml(doc_);
 }
 
-template <typename T> void append_text_node(xml_node &node, const char *name, const T &value) {
-	node.append_child(name).append_child(node_pcdata).text().set(value);
+/// The fields of the stream info in the XML document, in the order they are written
+const char *const info_fields[] = {"name", "type", "channel_count", "channel_format", "source_id",
+	"nominal_srate", "version", "created_at", "uid", "session_id", "hostname", "v4address",
+	"v4data_port", "v4service_port", "v6address", "v6data_port", "v6service_port"};
+
+/// Set the text of a child node, appending the child if it doesn't exist yet.
+template <typename T> void set_text_node(xml_node &node, const char *name, const T &value) {
+	xml_node child = node.child(name);
+	if (!child) child = node.append_child(name);
+	child.text().set(value);
 }
 
-template <> void append_text_node(xml_node &node, const char *name, const std::string &value) {
-	node.append_child(name).append_child(node_pcdata).set_value(pugi_str(value));
+template <> void set_text_node(xml_node &node, const char *name, const std::string &value) {
+	set_text_node(node, name, value.c_str());
 }
 
-void stream_info_impl::write_xml(xml_document &doc) {
+void stream_info_impl::write_xml(xml_document &doc) const {
 	const char *channel_format_strings[] = {
 		"undefined", "float32", "double64", "string", "int32", "int16", "int8", "int64"};
-	xml_node info = doc.append_child("info");
-	append_text_node(info, "name", name_);
-	append_text_node(info, "type", type_);
-	append_text_node(info, "channel_count", channel_count_);
-	append_text_node(info, "channel_format", channel_format_strings[channel_format_]);
-	append_text_node(info, "source_id", source_id_);
+	xml_node info = doc.child("info");
+	if (!info) info = doc.append_child("info");
+	set_text_node(info, "name", name_);
+	set_text_node(info, "type", type_);
+	set_text_node(info, "channel_count", channel_count_);
+	set_text_node(info, "channel_format", channel_format_strings[channel_format_]);
+	set_text_node(info, "source_id", source_id_);
 	// floating point fields: use locale independent to_string function
-	append_text_node(info, "nominal_srate", to_string(nominal_srate_));
-	append_text_node(info, "version", to_string(version_ / 100.));
-	append_text_node(info, "created_at", to_string(created_at_));
-	append_text_node(info, "uid", uid_);
-	append_text_node(info, "session_id", session_id_);
-	append_text_node(info, "hostname", hostname_);
-	append_text_node(info, "v4address", v4address_);
-	append_text_node(info, "v4data_port", v4data_port_);
-	append_text_node(info, "v4service_port", v4service_port_);
-	append_text_node(info, "v6address", v6address_);
-	append_text_node(info, "v6data_port", v6data_port_);
-	append_text_node(info, "v6service_port", v6service_port_);
-	info.append_child("desc");
+	set_text_node(info, "nominal_srate", to_string(nominal_srate_));
+	set_text_node(info, "version", to_string(version_ / 100.));
+	set_text_node(info, "created_at", to_string(created_at_));
+	set_text_node(info, "uid", uid_);
+	set_text_node(info, "session_id", session_id_);
+	set_text_node(info, "hostname", hostname_);
+	set_text_node(info, "v4address", v4address_);
+	set_text_node(info, "v4data_port", v4data_port_);
+	set_text_node(info, "v4service_port", v4service_port_);
+	set_text_node(info, "v6address", v6address_);
+	set_text_node(info, "v6data_port", v6data_port_);
+	set_text_node(info, "v6service_port", v6service_port_);
+	if (!info.child("desc")) info.append_child("desc");
 }
 
 template <typename T>
@@ -97,6 +106,8 @@ void get_bounded_child_val(xml_node &node, const char *child_name, T &target, in
 }
 
 void stream_info_impl::read_xml(xml_document &doc) {
+	// the cached query results were for the previous document
+	cached_.clear();
 	try {
 		xml_node info = doc.child("info");
 		// name
@@ -168,73 +179,379 @@ std::string stream_info_impl::to_shortinfo_message() {
 	return os.str();
 }
 
-void stream_info_impl::from_shortinfo_message(const std::string &m) {
-	// load the doc from the message string
-	doc_.load_buffer(m.c_str(), m.size());
-	// and assign all the struct fields, too...
-	read_xml(doc_);
-}
+void stream_info_impl::from_shortinfo_message(const std::string &m) { from_message(m); }
 
 std::string stream_info_impl::to_fullinfo_message() {
+	{
+		// a received document that wasn't changed since is returned as it was received
+		std::lock_guard<std::mutex> lock(doc_mut_);
+		std::string m;
+		if (doc_ && doc_synced_ && doc_->message(m, info_document::xml_message)) return m;
+	}
 	// write the doc to a stream
 	std::ostringstream os;
-	doc_.save(os);
+	document(false).save(os);
 	// and get the string
 	return os.str();
 }
 
-void stream_info_impl::from_fullinfo_message(const std::string &m) {
-	// load the doc from the message string
-	doc_.load_buffer(m.c_str(), m.size());
-	// and assign all the struct fields, too...
-	read_xml(doc_);
+void stream_info_impl::from_fullinfo_message(const std::string &m) { from_message(m); }
+
+/// Find the start of the <desc> element in a message, or std::string::npos
+static std::size_t find_desc(const std::string &m) {
+	for (std::size_t pos = m.find("<desc"); pos != std::string::npos; pos = m.find("<desc", pos + 1)) {
+		const char next = pos + 5 < m.size() ? m[pos + 5] : '\0';
+		if (next == '>' || next == '/' || next == ' ' || next == '\t' || next == '\r' ||
+			next == '\n')
+			return pos;
+	}
+	return std::string::npos;
 }
 
-bool stream_info_impl::matches_query(const std::string &query, bool nocache) {
-	return cached_.matches_query(doc_, query, nocache);
+void stream_info_impl::from_message(const std::string &m) {
+	auto doc = std::make_shared<info_document>(m);
+	{
+		std::lock_guard<std::mutex> lock(doc_mut_);
+		doc_ = doc;
+		doc_synced_ = true;
+	}
+	// the fields precede the <desc> element, so only the part before it is parsed now
+	const std::size_t desc_pos = find_desc(m);
+	if (desc_pos != std::string::npos) {
+		xml_document header;
+		std::string header_msg(m, 0, desc_pos);
+		header_msg += "</info>";
+		if (header.load_buffer(header_msg.data(), header_msg.size())) {
+			xml_node info = header.child("info");
+			if (std::all_of(std::begin(info_fields), std::end(info_fields),
+					[&info](const char *field) { return !info.child(field).empty(); })) {
+				read_xml(header);
+				return;
+			}
+		}
+	}
+	// the message has an unusual layout, so parse it right away
+	read_xml(doc->get());
 }
 
-bool query_cache::matches_query(const xml_document &doc, const std::string &query, bool nocache) {
-	if (query.empty()) return true;
-	std::lock_guard<std::mutex> lock(cache_mut_);
+// the binary short-info message starts with a magic and a format version, followed by the fixed
+// size fields and the strings (each prefixed by its length), all little endian
+const char shortinfo_binary_magic[4] = {'L', 'S', 'L', 'b'};
+const uint8_t shortinfo_binary_version = 1;
+
+template <typename T> static void put_binary(std::string &m, T value) {
+	lslboost::endian::native_to_little_inplace(value);
+	m.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+static void put_binary(std::string &m, double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	put_binary(m, bits);
+}
+
+static bool put_binary(std::string &m, const std::string &value) {
+	if (value.size() > UINT16_MAX) return false;
+	put_binary(m, static_cast<uint16_t>(value.size()));
+	m += value;
+	return true;
+}
+
+static void put_varint(std::string &m, uint64_t value) {
+	for (; value >= 0x80; value >>= 7) m += static_cast<char>((value & 0x7f) | 0x80);
+	m += static_cast<char>(value);
+}
+
+static void put_varstring(std::string &m, const char *value) {
+	const std::size_t len = strlen(value);
+	put_varint(m, len);
+	m.append(value, len);
+}
 
-	decltype(cache)::iterator it;
-	if (!nocache && (it = cache.find(query)) != cache.end()) {
-		// the sign bit encodes if the query matches or not
-		bool matches = it->second > 0;
-		// update the last-use time stamp
-		it->second = ++query_cache_age * (matches ? 1 : -1);
-		// return cached match
-		return matches;
+/// Reads the fields of a binary short-info or full-info message in order.
+class binary_reader {
+	const char *pos_, *end_;
+
+	void require(uint64_t n) const {
+		if (static_cast<uint64_t>(end_ - pos_) < n)
+			throw std::runtime_error("Received a truncated binary stream info message.");
 	}
 
-	// not found in cache
-	try {
-		// compute whether it matches
-		bool matched = pugi::xpath_query(query.c_str()).evaluate_boolean(doc.first_child());
-
-		auto max_cached = (std::size_t)api_config::get_instance()->max_cached_queries();
-		if (nocache || max_cached == 0) return matched;
-
-		cache.insert(std::make_pair(query, ++query_cache_age * (matched ? 1 : -1)));
-
-		// remove n/2 oldest results to make room for new entries
-		if (cache.size() > max_cached) {
-			// Find out the median cache entry age
-			std::vector<int> agevec;
-			agevec.reserve(cache.size());
-			for (auto &val : cache) agevec.push_back(std::abs(val.second));
-			auto middle = agevec.begin() + max_cached / 2;
-			std::nth_element(agevec.begin(), middle, agevec.end());
-			auto oldest_to_keep = *middle;
-
-			// Remove all elements older than the median age
-			for (auto it = cache.begin(); it != cache.end();)
-				if (abs(it->second) <= oldest_to_keep)
-					it = cache.erase(it);
-				else
-					++it;
+public:
+	binary_reader(const char *m, std::size_t len) : pos_(m), end_(m + len) {}
+
+	template <typename T> T get() {
+		T value;
+		require(sizeof(value));
+		memcpy(&value, pos_, sizeof(value));
+		pos_ += sizeof(value);
+		lslboost::endian::little_to_native_inplace(value);
+		return value;
+	}
+
+	double get_double() {
+		const auto bits = get<uint64_t>();
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	std::string get_string() {
+		const auto len = get<uint16_t>();
+		require(len);
+		std::string value(pos_, len);
+		pos_ += len;
+		return value;
+	}
+
+	uint64_t get_varint() {
+		uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			const auto byte = get<uint8_t>();
+			value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+			if (!(byte & 0x80)) return value;
+		}
+		throw std::runtime_error("Received an invalid number in a binary stream info message.");
+	}
+
+	std::string get_varstring() {
+		const uint64_t len = get_varint();
+		require(len);
+		std::string value(pos_, static_cast<std::size_t>(len));
+		pos_ += len;
+		return value;
+	}
+};
+
+// the binary full-info message starts with its own magic and format version, followed by the
+// same fields as the binary short-info message and the children of the <desc> element
+const char fullinfo_binary_magic[4] = {'L', 'S', 'L', 'f'};
+const uint8_t fullinfo_binary_version = 1;
+
+/// Tags of the nodes in the binary description. Element names are only sent with their first
+/// element, later elements refer to them as desc_tag_element + the index of the name.
+enum desc_tag : uint64_t {
+	desc_tag_end = 0,
+	desc_tag_new_element = 1,
+	desc_tag_pcdata = 2,
+	desc_tag_cdata = 3,
+	desc_tag_element = 4
+};
+
+/// Writes a description tree in the binary format.
+class desc_writer {
+	std::string &m_;
+	std::map<std::string, uint64_t> names_;
+
+public:
+	explicit desc_writer(std::string &m) : m_(m) {}
+
+	void write_children(const xml_node &node) {
+		for (xml_node child = node.first_child(); child; child = child.next_sibling()) {
+			switch (child.type()) {
+			case node_element: {
+				auto it = names_.find(child.name());
+				if (it == names_.end()) {
+					names_.emplace(child.name(), names_.size());
+					put_varint(m_, desc_tag_new_element);
+					put_varstring(m_, child.name());
+				} else
+					put_varint(m_, desc_tag_element + it->second);
+				uint64_t n_attributes = 0;
+				for (xml_attribute attr = child.first_attribute(); attr; attr = attr.next_attribute())
+					++n_attributes;
+				put_varint(m_, n_attributes);
+				for (xml_attribute attr = child.first_attribute(); attr; attr = attr.next_attribute()) {
+					put_varstring(m_, attr.name());
+					put_varstring(m_, attr.value());
+				}
+				write_children(child);
+				break;
+			}
+			case node_pcdata:
+			case node_cdata:
+				put_varint(m_, child.type() == node_pcdata ? desc_tag_pcdata : desc_tag_cdata);
+				put_varstring(m_, child.value());
+				break;
+			default:
+				// comments, processing instructions etc. carry no data
+				break;
+			}
+		}
+		put_varint(m_, desc_tag_end);
+	}
+};
+
+/// Reads a description tree in the binary format.
+class desc_reader {
+	binary_reader &reader_;
+	std::vector<std::string> names_;
+	/// descriptions from the network may not nest deeper than this
+	static const int max_depth = 1000;
+
+public:
+	explicit desc_reader(binary_reader &reader) : reader_(reader) {}
+
+	void read_children(xml_node node, int depth = 0) {
+		if (depth > max_depth)
+			throw std::runtime_error("Received a binary description that is nested too deeply.");
+		while (true) {
+			const uint64_t tag = reader_.get_varint();
+			if (tag == desc_tag_end) return;
+			if (tag == desc_tag_pcdata || tag == desc_tag_cdata) {
+				node.append_child(tag == desc_tag_pcdata ? node_pcdata : node_cdata)
+					.set_value(pugi_str(reader_.get_varstring()));
+				continue;
+			}
+			if (tag == desc_tag_new_element)
+				names_.push_back(reader_.get_varstring());
+			else if (tag - desc_tag_element >= names_.size())
+				throw std::runtime_error("Received an unknown element in a binary description.");
+			const std::string &name =
+				tag == desc_tag_new_element ? names_.back() : names_[tag - desc_tag_element];
+			xml_node child = node.append_child(name.c_str());
+			for (uint64_t n_attributes = reader_.get_varint(); n_attributes; --n_attributes) {
+				const std::string attr_name = reader_.get_varstring();
+				child.append_attribute(attr_name.c_str()).set_value(reader_.get_varstring().c_str());
+			}
+			read_children(child, depth + 1);
 		}
+	}
+};
+
+std::string stream_info_impl::to_shortinfo_binary() const {
+	std::string m(shortinfo_binary_magic, sizeof(shortinfo_binary_magic));
+	put_binary(m, shortinfo_binary_version);
+	if (!write_binary_fields(m)) return std::string();
+	return m;
+}
+
+bool stream_info_impl::write_binary_fields(std::string &m) const {
+	put_binary(m, static_cast<uint8_t>(channel_format_));
+	put_binary(m, channel_count_);
+	put_binary(m, nominal_srate_);
+	put_binary(m, static_cast<int32_t>(version_));
+	put_binary(m, created_at_);
+	put_binary(m, v4data_port_);
+	put_binary(m, v4service_port_);
+	put_binary(m, v6data_port_);
+	put_binary(m, v6service_port_);
+	for (const std::string *field : {&name_, &type_, &source_id_, &uid_, &session_id_,
+			 &hostname_, &v4address_, &v6address_})
+		if (!put_binary(m, *field)) return false;
+	return true;
+}
+
+std::string stream_info_impl::to_fullinfo_binary() {
+	{
+		// a received document that wasn't changed since is returned as it was received
+		std::lock_guard<std::mutex> lock(doc_mut_);
+		std::string m;
+		if (doc_ && doc_synced_ && doc_->message(m, info_document::binary_message)) return m;
+	}
+	std::string m(fullinfo_binary_magic, sizeof(fullinfo_binary_magic));
+	put_binary(m, fullinfo_binary_version);
+	if (!write_binary_fields(m)) return std::string();
+	desc_writer(m).write_children(document(false).child("info").child("desc"));
+	return m;
+}
+
+bool stream_info_impl::is_fullinfo_binary(const char *m, std::size_t len) {
+	return len > sizeof(fullinfo_binary_magic) &&
+		   memcmp(m, fullinfo_binary_magic, sizeof(fullinfo_binary_magic)) == 0 &&
+		   static_cast<uint8_t>(m[sizeof(fullinfo_binary_magic)]) == fullinfo_binary_version;
+}
+
+void stream_info_impl::from_fullinfo_binary(const char *m, std::size_t len) {
+	if (!is_fullinfo_binary(m, len))
+		throw std::runtime_error("Received an unknown binary full-info message.");
+	const std::size_t header_len = sizeof(fullinfo_binary_magic) + 1;
+	binary_reader reader(m + header_len, len - header_len);
+	read_binary_fields(reader);
+	{
+		// the description is read when the XML document is first needed
+		std::lock_guard<std::mutex> lock(doc_mut_);
+		doc_ = std::make_shared<info_document>(std::string(m, len), info_document::binary_message);
+		doc_synced_ = true;
+	}
+	cached_.clear();
+}
+
+void stream_info_impl::parse_fullinfo_binary(const std::string &m, xml_document &doc) {
+	const std::size_t header_len = sizeof(fullinfo_binary_magic) + 1;
+	binary_reader reader(m.data() + header_len, m.size() - header_len);
+	stream_info_impl fields;
+	fields.read_binary_fields(reader);
+	fields.write_xml(doc);
+	desc_reader(reader).read_children(doc.child("info").child("desc"));
+}
+
+bool stream_info_impl::is_shortinfo_binary(const char *m, std::size_t len) {
+	return len > sizeof(shortinfo_binary_magic) &&
+		   memcmp(m, shortinfo_binary_magic, sizeof(shortinfo_binary_magic)) == 0 &&
+		   static_cast<uint8_t>(m[sizeof(shortinfo_binary_magic)]) == shortinfo_binary_version;
+}
+
+void stream_info_impl::from_shortinfo_binary(const char *m, std::size_t len) {
+	if (!is_shortinfo_binary(m, len))
+		throw std::runtime_error("Received an unknown binary short-info message.");
+	const std::size_t header_len = sizeof(shortinfo_binary_magic) + 1;
+	binary_reader reader(m + header_len, len - header_len);
+	read_binary_fields(reader);
+	{
+		// the XML document is built from the fields when it's needed
+		std::lock_guard<std::mutex> lock(doc_mut_);
+		doc_.reset();
+		doc_synced_ = false;
+	}
+	cached_.clear();
+}
+
+void stream_info_impl::read_binary_fields(binary_reader &reader) {
+	const auto format = reader.get<uint8_t>();
+	if (format < cft_float32 || format > cft_int64)
+		throw std::runtime_error("Invalid channel format " + std::to_string(format));
+	channel_format_ = static_cast<lsl_channel_format_t>(format);
+	channel_count_ = reader.get<uint32_t>();
+	nominal_srate_ = reader.get_double();
+	version_ = reader.get<int32_t>();
+	created_at_ = reader.get_double();
+	v4data_port_ = reader.get<uint16_t>();
+	v4service_port_ = reader.get<uint16_t>();
+	v6data_port_ = reader.get<uint16_t>();
+	v6service_port_ = reader.get<uint16_t>();
+	for (std::string *field : {&name_, &type_, &source_id_, &uid_, &session_id_, &hostname_,
+			 &v4address_, &v6address_})
+		*field = reader.get_string();
+	// the same checks as for XML short-info messages
+	if (name_.empty())
+		throw std::runtime_error("Received a stream info with empty <name> field.");
+	if (!(nominal_srate_ >= 0)) throw std::runtime_error("nominal_srate must be >=0");
+	if (version_ <= 0)
+		throw std::runtime_error("The version of the given stream info is invalid.");
+	if (uid_.empty()) throw std::runtime_error("The UID of the given stream info is empty.");
+}
+
+bool stream_info_impl::matches_query(const std::string &query, bool nocache) {
+	return cached_.matches_query(*this, query, nocache);
+}
+
+query_cache::query_cache()
+	: results_(std::max(api_config::get_instance()->max_cached_queries(), 0)) {}
+
+bool query_cache::matches_query(
+	const stream_info_impl &info, const std::string &query, bool nocache) {
+	if (query.empty()) return true;
+	try {
+		const auto compiled = compiled_query::get(query);
+		if (!compiled->needs_xml()) return compiled->matches(info);
+
+		std::lock_guard<std::mutex> lock(cache_mut_);
+		if (!nocache)
+			if (const bool *matches = results_.find(query)) return *matches;
+		// not found in cache, so compute whether it matches
+		const bool matched = compiled->matches_xml(info.document(false).first_child());
+		if (!nocache) results_.insert(query, matched);
 		return matched;
 	} catch (std::exception &e) {
 		LOG_F(WARNING, "Query \"%s\" error: %s", query.c_str(), e.what());
@@ -242,14 +559,86 @@ bool query_cache::matches_query(const xml_document &doc, const std::string &quer
 	}
 }
 
+void query_cache::clear() {
+	std::lock_guard<std::mutex> lock(cache_mut_);
+	results_.clear();
+}
+
 int stream_info_impl::channel_bytes() const {
 	const int channel_format_sizes[] = {0, sizeof(float), sizeof(double), sizeof(std::string),
 		sizeof(int32_t), sizeof(int16_t), sizeof(int8_t), 8};
 	return channel_format_sizes[channel_format_];
 }
 
-xml_node stream_info_impl::desc() { return doc_.child("info").child("desc"); }
-xml_node stream_info_impl::desc() const { return doc_.child("info").child("desc"); }
+xml_node stream_info_impl::desc() { return document(true).child("info").child("desc"); }
+xml_node stream_info_impl::desc() const { return document(true).child("info").child("desc"); }
+
+// === XML document management ===
+
+xml_document &info_document::get() {
+	std::lock_guard<std::mutex> lock(mut_);
+	if (!parsed_) {
+		if (format_ == xml_message)
+			doc_.load_buffer(message_.data(), message_.size());
+		else {
+			try {
+				stream_info_impl::parse_fullinfo_binary(message_, doc_);
+			} catch (std::exception &e) {
+				// the fields were checked on receipt, so only the description can be incomplete
+				LOG_F(WARNING, "Error while reading a binary stream description: %s", e.what());
+			}
+		}
+		parsed_ = true;
+	}
+	return doc_;
+}
+
+std::shared_ptr<info_document> info_document::clone() {
+	std::lock_guard<std::mutex> lock(mut_);
+	if (!parsed_) return std::make_shared<info_document>(message_, format_);
+	return std::make_shared<info_document>(doc_);
+}
+
+bool info_document::message(std::string &out, message_format format) {
+	std::lock_guard<std::mutex> lock(mut_);
+	if (message_.empty() || format_ != format) return false;
+	out = message_;
+	return true;
+}
+
+void info_document::changed() {
+	std::lock_guard<std::mutex> lock(mut_);
+	// documents are only changed after parsing them
+	std::string().swap(message_);
+}
+
+xml_document &stream_info_impl::document(bool modify) const {
+	std::lock_guard<std::mutex> lock(doc_mut_);
+	if (!doc_) {
+		doc_ = std::make_shared<info_document>();
+		doc_synced_ = false;
+	}
+	// the stream infos sharing the document must not see our changes
+	if ((modify || !doc_synced_) && doc_.use_count() > 1) doc_ = doc_->clone();
+	xml_document &doc = doc_->get();
+	if (!doc_synced_) {
+		write_xml(doc);
+		doc_->changed();
+		doc_synced_ = true;
+	}
+	if (modify) doc_->expose();
+	return doc;
+}
+
+std::shared_ptr<info_document> stream_info_impl::shared_document() const {
+	if (doc_ && doc_->exposed()) return doc_->clone();
+	return doc_;
+}
+
+void stream_info_impl::field_changed() {
+	std::lock_guard<std::mutex> lock(doc_mut_);
+	doc_synced_ = false;
+}
 
 uint32_t lsl::stream_info_impl::calc_transport_buf_samples(
 	int32_t requested_len, lsl_transport_options_t flags) const {
@@ -271,17 +660,17 @@ uint32_t lsl::stream_info_impl::calc_transport_buf_samples(
 
 void stream_info_impl::version(int v) {
 	version_ = v;
-	doc_.child("info").child("version").first_child().set_value(pugi_str(to_string(version_ / 100.)));
+	field_changed();
 }
 
 void stream_info_impl::created_at(double v) {
 	created_at_ = v;
-	doc_.child("info").child("created_at").first_child().set_value(pugi_str(to_string(created_at_)));
+	field_changed();
 }
 
 void stream_info_impl::uid(const std::string &v) {
 	uid_ = v;
-	doc_.child("info").child("uid").first_child().set_value(pugi_str(uid_));
+	field_changed();
 }
 
 const std::string& stream_info_impl::reset_uid()
@@ -292,42 +681,42 @@ const std::string& stream_info_impl::reset_uid()
 
 void stream_info_impl::session_id(const std::string &v) {
 	session_id_ = v;
-	doc_.child("info").child("session_id").first_child().set_value(pugi_str(session_id_));
+	field_changed();
 }
 
 void stream_info_impl::hostname(const std::string &v) {
 	hostname_ = v;
-	doc_.child("info").child("hostname").first_child().set_value(pugi_str(hostname_));
+	field_changed();
 }
 
 void stream_info_impl::v4address(const std::string &v) {
 	v4address_ = v;
-	doc_.child("info").child("v4address").first_child().set_value(pugi_str(v4address_));
+	field_changed();
 }
 
 void stream_info_impl::v4data_port(uint16_t v) {
 	v4data_port_ = v;
-	doc_.child("info").child("v4data_port").first_child().text().set(v4data_port_);
+	field_changed();
 }
 
 void stream_info_impl::v4service_port(uint16_t v) {
 	v4service_port_ = v;
-	doc_.child("info").child("v4service_port").first_child().text().set(v4service_port_);
+	field_changed();
 }
 
 void stream_info_impl::v6address(const std::string &v) {
 	v6address_ = v;
-	doc_.child("info").child("v6address").first_child().set_value(pugi_str(v6address_));
+	field_changed();
 }
 
 void stream_info_impl::v6data_port(uint16_t v) {
 	v6data_port_ = v;
-	doc_.child("info").child("v6data_port").first_child().text().set(v6data_port_);
+	field_changed();
 }
 
 void stream_info_impl::v6service_port(uint16_t v) {
 	v6service_port_ = v;
-	doc_.child("info").child("v6service_port").first_child().text().set(v6service_port_);
+	field_changed();
 }
 
 stream_info_impl &stream_info_impl::operator=(stream_info_impl const &rhs) {
@@ -349,7 +738,19 @@ stream_info_impl &stream_info_impl::operator=(stream_info_impl const &rhs) {
 	created_at_ = rhs.created_at_;
 	session_id_ = rhs.session_id_;
 	hostname_ = rhs.hostname_;
-	doc_.reset(rhs.doc_);
+	std::shared_ptr<info_document> doc;
+	bool synced;
+	{
+		std::lock_guard<std::mutex> lock(rhs.doc_mut_);
+		doc = rhs.shared_document();
+		synced = rhs.doc_synced_;
+	}
+	{
+		std::lock_guard<std::mutex> lock(doc_mut_);
+		doc_ = std::move(doc);
+		doc_synced_ = synced;
+	}
+	cached_.clear();
 	return *this;
 }
 
@@ -361,7 +762,9 @@ stream_info_impl::stream_info_impl(const stream_info_impl &rhs)
 	  v6address_(rhs.v6address_), v6data_port_(rhs.v6data_port_),
 	  v6service_port_(rhs.v6service_port_), uid_(rhs.uid_), created_at_(rhs.created_at_),
 	  session_id_(rhs.session_id_), hostname_(rhs.hostname_) {
-	doc_.reset(rhs.doc_);
+	std::lock_guard<std::mutex> lock(rhs.doc_mut_);
+	doc_ = rhs.shared_document();
+	doc_synced_ = rhs.doc_synced_;
 }
 
 } // namespace lsl
@@ -2,22 +2,91 @@
 #define STREAM_INFO_IMPL_H
 
 #include "common.h"
+#include "util/lru_cache.hpp"
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <pugixml.hpp>
 #include <string>
-#include <unordered_map>
+#include <utility>
 
 namespace lsl {
 
-/// LRU cache for queries
+class binary_reader;
+class stream_info_impl;
+
+/**
+ * Matches queries against a stream info.
+ *
+ * Queries are compiled once per process (see compiled_query). Most are evaluated against the
+ * stream info's fields, and the results of those that need the XML document are kept in an LRU
+ * cache.
+ */
 class query_cache {
-	std::unordered_map<std::string, int> cache;
-	int query_cache_age{0};
+	lru_cache<bool> results_;
 	std::mutex cache_mut_;
 
 public:
-	bool matches_query(const pugi::xml_document &doc, const std::string &query, bool nocache);
+	query_cache();
+
+	bool matches_query(const stream_info_impl &info, const std::string &query, bool nocache);
+
+	/// Forget the cached results, e.g. because the stream info was replaced.
+	void clear();
+};
+
+/**
+ * The XML document of a stream info, shared by its copies.
+ *
+ * A document received as a message is only parsed on first access. Copies of a stream info share
+ * the document until one of them changes it, or until a mutable node of it was handed out (the
+ * holder may change the document at any time then).
+ */
+class info_document {
+public:
+	/// The formats of the messages a document can be parsed from.
+	enum message_format { xml_message, binary_message };
+
+	/// An empty document.
+	info_document() = default;
+
+	/// A document that is parsed from a message on first access.
+	explicit info_document(std::string message, message_format format = xml_message)
+		: message_(std::move(message)), format_(format), parsed_(false) {}
+
+	/// A copy of another document.
+	explicit info_document(const pugi::xml_document &doc) { doc_.reset(doc); }
+
+	/// Get the document, parsing it first if needed.
+	pugi::xml_document &get();
+
+	/// Make an unshared copy (that is still parsed lazily if this one wasn't parsed yet).
+	std::shared_ptr<info_document> clone();
+
+	/// Get the message the document was parsed from, if it has the given format and the document
+	/// wasn't changed since.
+	bool message(std::string &out, message_format format);
+
+	/// Note that the document was changed, so the message no longer reflects it.
+	void changed();
+
+	/// Note that a mutable node was handed out, so copies need their own document.
+	void expose() {
+		changed();
+		exposed_ = true;
+	}
+	bool exposed() const { return exposed_; }
+
+private:
+	std::mutex mut_;
+	/// the message the document is parsed from, cleared once the document was changed
+	std::string message_;
+	message_format format_{xml_message};
+	bool parsed_{true};
+	std::atomic<bool> exposed_{false};
+	pugi::xml_document doc_;
 };
 
 /**
@@ -51,10 +120,10 @@ public:
 	stream_info_impl(const std::string &name, std::string type, int channel_count,
 		double nominal_srate, lsl_channel_format_t channel_format, std::string source_id);
 
-	/// Copy constructor. Needs special handling because xml_document is non-copyable.
+	/// Copy constructor. The copy shares the XML document until one of them changes it.
 	stream_info_impl(const stream_info_impl &rhs);
 
-	/// Assignment operator. Needs extra handling because xml_document is non-copyable.
+	/// Assignment operator. Shares the XML document like the copy constructor.
 	stream_info_impl &operator=(const stream_info_impl &rhs);
 
 	// === Protocol Support Operations ===
@@ -72,10 +141,29 @@ public:
 	 * Initialize a stream_info from a short-info message.
 	 *
 	 * This functions resets all fields of the stream_info accoridng to the message. The .desc()
-	 * field will be empty.
+	 * field will be empty. Like for full-info messages, the XML document is parsed on first access.
 	 */
 	void from_shortinfo_message(const std::string &m);
 
+	/**
+	 * Get the binary short-info message according to this stream_info.
+	 *
+	 * It holds the same fields as the short-info message, but can be read without parsing XML.
+	 * @return The message, or an empty string if a field is too long to be encoded.
+	 */
+	std::string to_shortinfo_binary() const;
+
+	/// Check whether a message is a binary short-info message that can be read by this library.
+	static bool is_shortinfo_binary(const char *m, std::size_t len);
+
+	/**
+	 * Initialize a stream_info from a binary short-info message.
+	 *
+	 * Like from_shortinfo_message(), this resets all fields and the .desc() field will be empty.
+	 * @throws std::runtime_error if the message is malformed (the fields are undefined then).
+	 */
+	void from_shortinfo_binary(const char *m, std::size_t len);
+
 	/**
 	 * Get the full-info message for this stream_info.
 	 *
@@ -86,10 +174,33 @@ public:
 	/**
 	 * Initialize a stream_info from a full-info message.
 	 *
-	 * This functions resets all fields of the stream_info accoridng to the message.
+	 * This functions resets all fields of the stream_info accoridng to the message. Only the
+	 * fields before the .desc() element are parsed right away, the whole document is parsed when
+	 * it's first needed.
 	 */
 	void from_fullinfo_message(const std::string &m);
 
+	/**
+	 * Get the binary full-info message for this stream_info.
+	 *
+	 * It holds the same fields as the binary short-info message, followed by the .desc() tree in a
+	 * compact encoding that can be read without parsing XML. Comments and processing instructions
+	 * in the description are not included.
+	 * @return The message, or an empty string if a field is too long to be encoded.
+	 */
+	std::string to_fullinfo_binary();
+
+	/// Check whether a message is a binary full-info message that can be read by this library.
+	static bool is_fullinfo_binary(const char *m, std::size_t len);
+
+	/**
+	 * Initialize a stream_info from a binary full-info message.
+	 *
+	 * The fields are read right away, the .desc() tree when the XML document is first needed.
+	 * @throws std::runtime_error if the fields are malformed (they are undefined then).
+	 */
+	void from_fullinfo_binary(const char *m, std::size_t len);
+
 	/**
 	 * Test whether this stream info matches the given query string.
 	 *
@@ -217,7 +328,12 @@ public:
 	uint16_t v6service_port() const { return v6service_port_; }
 	void v6service_port(uint16_t v);
 
-	/// Get the (editable) XML description of a stream.
+	/**
+	 * Get the (editable) XML description of a stream.
+	 *
+	 * Since the caller may change it, copies of this stream info made afterwards get their own
+	 * XML document.
+	 */
 	pugi::xml_node desc();
 	pugi::xml_node desc() const;
 
@@ -225,13 +341,42 @@ public:
 	uint32_t calc_transport_buf_samples(int32_t requested_len, lsl_transport_options_t flags) const;
 
 protected:
-	/// Create and assign the XML DOM structure based on the class fields.
-	void write_xml(pugi::xml_document &doc);
+	/// Create the XML DOM structure or update its fields based on the class fields.
+	void write_xml(pugi::xml_document &doc) const;
 
 	/// Read the class fields from an XML DOM structure.
 	void read_xml(pugi::xml_document &doc);
 
 private:
+	friend class info_document;
+	friend class query_cache;
+
+	/// Append the fields of a binary short-info or full-info message.
+	/// @return false if a field is too long to be encoded.
+	bool write_binary_fields(std::string &m) const;
+
+	/// Read the fields of a binary short-info or full-info message.
+	void read_binary_fields(binary_reader &reader);
+
+	/// Build the XML document from a binary full-info message.
+	static void parse_fullinfo_binary(const std::string &m, pugi::xml_document &doc);
+
+	/// Reset the fields and the XML document from a short-info or full-info message.
+	void from_message(const std::string &m);
+
+	/**
+	 * Get the XML document, building or parsing it first if needed.
+	 * @param modify Make the document unique to this stream info first, because the caller may
+	 * change it.
+	 */
+	pugi::xml_document &document(bool modify) const;
+
+	/// The document for a copy of this stream info. Needs to be called with doc_mut_ held.
+	std::shared_ptr<info_document> shared_document() const;
+
+	/// Note that a field changed, so it needs to be written to the XML document.
+	void field_changed();
+
 	// data information
 	std::string name_;
 	std::string type_;
@@ -251,8 +396,12 @@ private:
 	double created_at_;
 	std::string session_id_;
 	std::string hostname_;
-	// XML representation
-	pugi::xml_document doc_;
+	// XML representation, nullptr until first needed
+	mutable std::shared_ptr<info_document> doc_;
+	// whether the fields in the XML document are up to date
+	mutable bool doc_synced_{false};
+	// protects doc_ and doc_synced_
+	mutable std::mutex doc_mut_;
 	// cached query results
 	query_cache cached_;
 };
@@ -7,7 +7,9 @@
 #include "inlet_connection.h"
 #include "time_postprocessor.h"
 #include "time_receiver.h"
+#include <algorithm>
 #include <loguru.hpp>
+#include <vector>
 
 namespace lsl {
 
@@ -36,11 +38,16 @@ public:
 	 * In all other cases (recover is false or the stream is not recoverable) a lsl::lost_error
 	 * is thrown where indicated if the stream's source is lost (e.g. due to an app or computer
 	 * crash).
+	 * @param flags Bitwise-OR'd flags from lsl_transport_options_t; only transp_busy_poll,
+	 * transp_drop_newest, transp_block_when_full and transp_compress are relevant here since
+	 * max_buflen is already in samples.
 	 */
 	stream_inlet_impl(const stream_info_impl &info, int32_t max_buflen = 360,
-		int32_t max_chunklen = 0, bool recover = true)
+		int32_t max_chunklen = 0, bool recover = true,
+		lsl_transport_options_t flags = transp_default)
 		: conn_(info, recover), info_receiver_(conn_), time_receiver_(conn_),
-		  data_receiver_(conn_, max_buflen, max_chunklen),
+		  data_receiver_(conn_, max_buflen, max_chunklen, (flags & transp_busy_poll) != 0,
+			  overflow_policy_for(flags), (flags & transp_compress) != 0),
 		  postprocessor_([this]() { return time_receiver_.time_correction(5); },
 			  [this]() { return conn_.current_srate(); },
 			  [this]() { return time_receiver_.was_reset(); }) {
@@ -113,25 +120,25 @@ public:
 	 * machine are not synchronized to high enough precision.
 	 */
 	double pull_sample(float *buffer, int32_t buffer_elements, double timeout = FOREVER) {
-		return postprocess(data_receiver_.pull_sample_typed(buffer, buffer_elements, timeout));
+		return pull_typed(buffer, buffer_elements, timeout);
 	}
 	double pull_sample(double *buffer, int32_t buffer_elements, double timeout = FOREVER) {
-		return postprocess(data_receiver_.pull_sample_typed(buffer, buffer_elements, timeout));
+		return pull_typed(buffer, buffer_elements, timeout);
 	}
 	double pull_sample(int64_t *buffer, int32_t buffer_elements, double timeout = FOREVER) {
-		return postprocess(data_receiver_.pull_sample_typed(buffer, buffer_elements, timeout));
+		return pull_typed(buffer, buffer_elements, timeout);
 	}
 	double pull_sample(int32_t *buffer, int32_t buffer_elements, double timeout = FOREVER) {
-		return postprocess(data_receiver_.pull_sample_typed(buffer, buffer_elements, timeout));
+		return pull_typed(buffer, buffer_elements, timeout);
 	}
 	double pull_sample(int16_t *buffer, int32_t buffer_elements, double timeout = FOREVER) {
-		return postprocess(data_receiver_.pull_sample_typed(buffer, buffer_elements, timeout));
+		return pull_typed(buffer, buffer_elements, timeout);
 	}
 	double pull_sample(char *buffer, int32_t buffer_elements, double timeout = FOREVER) {
-		return postprocess(data_receiver_.pull_sample_typed(buffer, buffer_elements, timeout));
+		return pull_typed(buffer, buffer_elements, timeout);
 	}
 	double pull_sample(std::string *buffer, int32_t buffer_elements, double timeout = FOREVER) {
-		return postprocess(data_receiver_.pull_sample_typed(buffer, buffer_elements, timeout));
+		return pull_typed(buffer, buffer_elements, timeout);
 	}
 
 	template <typename T>
@@ -141,7 +148,7 @@ public:
 		if (!ec) ec = &dummy;
 		*ec = lsl_no_error;
 		try {
-			return postprocess(data_receiver_.pull_sample_typed(buffer, buffer_elements, timeout));
+			return pull_typed(buffer, buffer_elements, timeout);
 		} catch (timeout_error &) { *ec = lsl_timeout_error; } catch (lost_error &) {
 			*ec = lsl_lost_error;
 		} catch (std::invalid_argument &) { *ec = lsl_argument_error; } catch (std::range_error &) {
@@ -169,7 +176,28 @@ public:
 	 * machine are not synchronized to high enough precision.
 	 */
 	double pull_numeric_raw(void *sample, int32_t buffer_bytes, double timeout = FOREVER) {
-		return postprocess(data_receiver_.pull_sample_untyped(sample, buffer_bytes, timeout));
+		uint32_t dropped = 0;
+		const double stamp =
+			data_receiver_.pull_sample_untyped(sample, buffer_bytes, timeout, &dropped);
+		return postprocess(stamp, dropped);
+	}
+
+	/**
+	 * Pull a sample from the inlet and copy each value into a newly allocated buffer.
+	 *
+	 * The buffers are allocated with malloc() and have to be freed by the caller; they are set to
+	 * nullptr if no sample was available.
+	 * @param buffer An array of at least channel_count() pointers to receive the buffers.
+	 * @param buffer_lengths An array of at least channel_count() elements to receive the lengths.
+	 * @param buffer_elements The number of elements in both arrays.
+	 * @return The capture time of the sample, or 0.0 if no new sample was available.
+	 */
+	double pull_sample_buf(char **buffer, uint32_t *buffer_lengths, int32_t buffer_elements,
+		double timeout = FOREVER) {
+		uint32_t dropped = 0;
+		const double stamp = data_receiver_.pull_sample_buf(buffer, buffer_lengths,
+			static_cast<uint32_t>(std::max(0, buffer_elements)), timeout, &dropped);
+		return postprocess(stamp, dropped);
 	}
 
 	/**
@@ -201,14 +229,25 @@ public:
 		if (timestamp_buffer && max_samples != timestamp_buffer_elements)
 			throw std::runtime_error(
 				"The timestamp buffer must hold the same number of samples as the data buffer.");
-		double end_time = timeout ? lsl_clock() + timeout : 0.0;
-		for (samples_written = 0; samples_written < max_samples; samples_written++) {
-			if (double ts = pull_sample(&data_buffer[samples_written * num_chans], (int) num_chans,
-					timeout ? end_time - lsl_clock() : 0.0)) {
-				if (timestamp_buffer) timestamp_buffer[samples_written] = ts;
-			} else
-				break;
+		// the time stamps are needed for post-processing even if the caller isn't interested
+		std::vector<double> scratch_timestamps;
+		if (!timestamp_buffer) {
+			scratch_timestamps.resize(max_samples);
+			timestamp_buffer = scratch_timestamps.data();
+		}
+		std::vector<sample_gap> gaps;
+		samples_written = data_receiver_.pull_chunk_typed(
+			data_buffer, timestamp_buffer, static_cast<uint32_t>(max_samples), timeout, &gaps);
+		// the dejitterer needs to know where samples are missing
+		std::size_t processed = 0;
+		for (const sample_gap &gap : gaps) {
+			postprocessor_.process_timestamps(
+				timestamp_buffer + processed, gap.position - processed);
+			postprocessor_.skip_samples(gap.dropped);
+			processed = gap.position;
 		}
+		postprocessor_.process_timestamps(
+			timestamp_buffer + processed, samples_written - processed);
 		return static_cast<uint32_t>(samples_written * num_chans);
 	}
 
@@ -304,6 +343,11 @@ public:
 	 */
 	std::size_t samples_available() { return data_receiver_.samples_available(); }
 
+	/// Get the inlet's transfer statistics, see data_receiver::get_stats().
+	int32_t get_stats(uint64_t *stats, int32_t num_stats) {
+		return data_receiver_.get_stats(stats, num_stats);
+	}
+
 	/// Flush the queue, return the number of dropped samples
 	uint32_t flush() {
 		int nskipped = data_receiver_.flush();
@@ -323,9 +367,26 @@ public:
 	void smoothing_halftime(float value) { postprocessor_.smoothing_halftime(value); }
 
 private:
-	/// post-process a time stamp
-	double postprocess(double stamp) {
-		return stamp ? postprocessor_.process_timestamp(stamp) : stamp;
+	/// post-process a time stamp, given the number of samples dropped before it
+	double postprocess(double stamp, uint32_t dropped) {
+		if (!stamp) return stamp;
+		if (dropped) postprocessor_.skip_samples(dropped);
+		return postprocessor_.process_timestamp(stamp);
+	}
+
+	/// pull a sample with data_receiver::pull_sample_typed() and post-process its time stamp
+	template <class T> double pull_typed(T *buffer, int32_t buffer_elements, double timeout) {
+		uint32_t dropped = 0;
+		const double stamp =
+			data_receiver_.pull_sample_typed(buffer, buffer_elements, timeout, &dropped);
+		return postprocess(stamp, dropped);
+	}
+
+	/// what the inlet's queues do if the application doesn't pull samples fast enough
+	static overflow_policy overflow_policy_for(lsl_transport_options_t flags) {
+		if (flags & transp_block_when_full) return overflow_policy::block;
+		if (flags & transp_drop_newest) return overflow_policy::drop_newest;
+		return overflow_policy::drop_oldest;
 	}
 
 	/// the inlet connection
@@ -1,7 +1,10 @@
 #include "stream_outlet_impl.h"
 #include "api_config.h"
+#include "io_context_pool.h"
+#include "local_outlets.h"
 #include "sample.h"
 #include "send_buffer.h"
+#include "socket_utils.h"
 #include "stream_info_impl.h"
 #include "tcp_server.h"
 #include "udp_server.h"
@@ -11,6 +14,20 @@
 
 namespace lsl {
 
+/// Let the factory release its idle arenas every `interval` seconds until the timer is cancelled
+/// or the factory is gone, even if no samples are pushed anymore.
+static void schedule_trim(const std::shared_ptr<asio::steady_timer> &timer,
+	const std::weak_ptr<factory> &fac, double interval) {
+	timer->expires_after(timeout_sec(interval));
+	timer->async_wait([timer, fac, interval](const asio::error_code &err) {
+		if (err == asio::error::operation_aborted) return;
+		if (factory_p sample_factory = fac.lock()) {
+			sample_factory->trim_if_due();
+			schedule_trim(timer, fac, interval);
+		}
+	});
+}
+
 stream_outlet_impl::stream_outlet_impl(const stream_info_impl &info, int32_t chunk_size,
 	int32_t requested_bufsize, lsl_transport_options_t flags)
 	: sample_factory_(std::make_shared<factory>(info.channel_format(), info.channel_count(),
@@ -21,12 +38,19 @@ stream_outlet_impl::stream_outlet_impl(const stream_info_impl &info, int32_t chu
 				  : api_config::get_instance()->outlet_buffer_reserve_samples()))),
 	  chunk_size_(info.calc_transport_buf_samples(requested_bufsize, flags)),
 	  info_(std::make_shared<stream_info_impl>(info)),
-	  send_buffer_(std::make_shared<send_buffer>(chunk_size_)),
-	  io_ctx_data_(std::make_shared<asio::io_context>(1)),
-	  io_ctx_service_(std::make_shared<asio::io_context>(1)) {
+	  send_buffer_(std::make_shared<send_buffer>(chunk_size_)) {
 	ensure_lsl_initialized();
 	const api_config *cfg = api_config::get_instance();
 
+	// use the shared IO threads if configured, otherwise create our own io_contexts
+	if (io_context_pool *pool = io_context_pool::get_instance()) {
+		io_ctx_data_ = pool->next();
+		io_ctx_service_ = pool->next();
+	} else {
+		io_ctx_data_ = std::make_shared<asio::io_context>(1);
+		io_ctx_service_ = std::make_shared<asio::io_context>(1);
+	}
+
 	// instantiate IPv4 and/or IPv6 stacks (depending on settings)
 	if (cfg->allow_ipv4()) try {
 			instantiate_stack(udp::v4());
@@ -52,7 +76,17 @@ stream_outlet_impl::stream_outlet_impl(const stream_info_impl &info, int32_t chu
 	for (auto &udp_server : udp_servers_) udp_server->begin_serving();
 	for (auto &responder : responders_) responder->begin_serving();
 
-	// and start the IO threads to handle them
+	// let inlets in this process read from the send buffer directly
+	register_local_outlet(info_->uid(), send_buffer_, sample_factory_);
+
+	// release the sample arenas of a burst even if nothing is pushed afterwards
+	if (cfg->sample_pool_trim_interval() > 0) {
+		trim_timer_ = std::make_shared<asio::steady_timer>(*io_ctx_service_);
+		schedule_trim(trim_timer_, sample_factory_, cfg->sample_pool_trim_interval());
+	}
+
+	// and start the IO threads to handle them (unless the shared ones do)
+	if (io_context_pool::get_instance()) return;
 	const std::string name{"IO_" + this->info().name().substr(0, 11)};
 	for (const auto &io : {io_ctx_data_, io_ctx_service_})
 		io_threads_.emplace_back(std::make_shared<std::thread>([io, name]() {
@@ -94,10 +128,16 @@ void stream_outlet_impl::instantiate_stack(udp udp_protocol) {
 
 stream_outlet_impl::~stream_outlet_impl() {
 	try {
+		// local inlets see the end of the stream via the sentinel pushed by end_serving()
+		unregister_local_outlet(info_->uid());
 		// cancel all request chains
 		tcp_server_->end_serving();
 		for (auto &udp_server : udp_servers_) udp_server->end_serving();
 		for (auto &responder : responders_) responder->end_serving();
+		if (trim_timer_) asio::post(*io_ctx_service_, [timer = trim_timer_]() { timer->cancel(); });
+
+		// the shared io_contexts keep running; the pending handlers own the data they refer to
+		if (io_threads_.empty()) return;
 
 		// In theory, an io context should end quickly, but in practice it
 		// might take a while. So we
@@ -150,6 +190,7 @@ void stream_outlet_impl::push_numeric_raw(const void *data, double timestamp, bo
 		sample_factory_->new_sample(timestamp == 0.0 ? lsl_clock() : timestamp, pushthrough));
 	smp->assign_untyped(data);
 	send_buffer_->push_sample(smp);
+	samples_pushed_.add();
 }
 
 bool stream_outlet_impl::have_consumers() { return send_buffer_->have_consumers(); }
@@ -158,6 +199,13 @@ bool stream_outlet_impl::wait_for_consumers(double timeout) {
 	return send_buffer_->wait_for_consumers(timeout);
 }
 
+int32_t stream_outlet_impl::get_stats(uint64_t *stats, int32_t num_stats) {
+	queue_stats queues;
+	send_buffer_->collect_stats(queues);
+	return report_stats(
+		samples_pushed_.value(), queues, sample_factory_->stats().grows, stats, num_stats);
+}
+
 template <class T>
 void stream_outlet_impl::enqueue(const T *data, double timestamp, bool pushthrough) {
 	if (lsl::api_config::get_instance()->force_default_timestamps()) timestamp = 0.0;
@@ -165,6 +213,27 @@ void stream_outlet_impl::enqueue(const T *data, double timestamp, bool pushthrou
 		sample_factory_->new_sample(timestamp == 0.0 ? lsl_clock() : timestamp, pushthrough));
 	smp->assign_typed(data);
 	send_buffer_->push_sample(smp);
+	samples_pushed_.add();
+}
+
+template <class T>
+void stream_outlet_impl::enqueue_chunk(const T *data, std::size_t num_samples,
+	const double *timestamps, double timestamp, bool pushthrough) {
+	const bool force_default_timestamps =
+		lsl::api_config::get_instance()->force_default_timestamps();
+	const std::size_t num_chans = info_->channel_count();
+	std::vector<sample_p> samples;
+	samples.reserve(num_samples);
+	for (std::size_t k = 0; k < num_samples; k++, data += num_chans) {
+		double ts = timestamps ? timestamps[k] : (k == 0 ? timestamp : DEDUCED_TIMESTAMP);
+		if (force_default_timestamps || ts == 0.0) ts = lsl_clock();
+		samples.push_back(sample_factory_->new_sample(ts, pushthrough && k == num_samples - 1));
+		samples.back()->assign_typed(data);
+	}
+	// hand the whole batch to the send buffer, i.e. lock the consumer set and wake up each
+	// consumer only once
+	send_buffer_->push_chunk(samples.data(), samples.size());
+	samples_pushed_.add(num_samples);
 }
 
 template void stream_outlet_impl::enqueue<char>(const char *data, double, bool);
@@ -175,4 +244,19 @@ template void stream_outlet_impl::enqueue<float>(const float *data, double, bool
 template void stream_outlet_impl::enqueue<double>(const double *data, double, bool);
 template void stream_outlet_impl::enqueue<std::string>(const std::string *data, double, bool);
 
+template void stream_outlet_impl::enqueue_chunk<char>(
+	const char *, std::size_t, const double *, double, bool);
+template void stream_outlet_impl::enqueue_chunk<int16_t>(
+	const int16_t *, std::size_t, const double *, double, bool);
+template void stream_outlet_impl::enqueue_chunk<int32_t>(
+	const int32_t *, std::size_t, const double *, double, bool);
+template void stream_outlet_impl::enqueue_chunk<int64_t>(
+	const int64_t *, std::size_t, const double *, double, bool);
+template void stream_outlet_impl::enqueue_chunk<float>(
+	const float *, std::size_t, const double *, double, bool);
+template void stream_outlet_impl::enqueue_chunk<double>(
+	const double *, std::size_t, const double *, double, bool);
+template void stream_outlet_impl::enqueue_chunk<std::string>(
+	const std::string *, std::size_t, const double *, double, bool);
+
 } // namespace lsl
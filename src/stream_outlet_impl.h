@@ -3,7 +3,10 @@
 
 #include "common.h"
 #include "forward.h"
+#include "sample.h"
+#include "stats.h"
 #include "stream_info_impl.h"
+#include <asio/steady_timer.hpp>
 #include <cstdint>
 #include <loguru.hpp>
 #include <memory>
@@ -200,9 +203,7 @@ public:
 		if (!data_buffer) throw std::runtime_error("The data buffer pointer must not be NULL.");
 		if (!timestamp_buffer)
 			throw std::runtime_error("The timestamp buffer pointer must not be NULL.");
-		for (std::size_t k = 0; k < num_samples; k++)
-			enqueue(&data_buffer[k * num_chans], timestamp_buffer[k],
-				pushthrough && k == num_samples - 1);
+		enqueue_chunk(data_buffer, num_samples, timestamp_buffer, 0.0, pushthrough);
 	}
 
 	template <class T>
@@ -254,10 +255,7 @@ public:
 			if (timestamp == 0.0) timestamp = lsl_clock();
 			if (info().nominal_srate() != IRREGULAR_RATE)
 				timestamp = timestamp - (num_samples - 1) / info().nominal_srate();
-			push_sample(buffer, timestamp, pushthrough && (num_samples == 1));
-			for (std::size_t k = 1; k < num_samples; k++)
-				push_sample(&buffer[k * num_chans], DEDUCED_TIMESTAMP,
-					pushthrough && (k == num_samples - 1));
+			enqueue_chunk(buffer, num_samples, nullptr, timestamp, pushthrough);
 		}
 	}
 
@@ -294,6 +292,16 @@ public:
 	/// Wait until some consumer shows up.
 	bool wait_for_consumers(double timeout = FOREVER);
 
+	/// Get statistics about the samples allocated for this outlet.
+	factory::pool_stats sample_pool_stats() const { return sample_factory_->stats(); }
+
+	/**
+	 * Get the outlet's transfer statistics.
+	 * @param stats An array that receives up to num_stats entries, indexed by lsl_stat_t.
+	 * @return The number of entries written.
+	 */
+	int32_t get_stats(uint64_t *stats, int32_t num_stats);
+
 private:
 	/// Instantiate a new server stack.
 	void instantiate_stack(udp udp_protocol);
@@ -301,6 +309,18 @@ private:
 	/// Allocate and enqueue a new sample into the send buffer.
 	template <class T> void enqueue(const T *data, double timestamp, bool pushthrough);
 
+	/**
+	 * Allocate a chunk of samples and enqueue them into the send buffer as one batch.
+	 *
+	 * @param data Multiplexed channel data for `num_samples` samples.
+	 * @param timestamps One timestamp per sample or nullptr, in which case the first sample gets
+	 * `timestamp` and the time stamps of all subsequent samples are deduced.
+	 * @param pushthrough Whether to push the last sample of the chunk through to the receivers.
+	 */
+	template <class T>
+	void enqueue_chunk(const T *data, std::size_t num_samples, const double *timestamps,
+		double timestamp, bool pushthrough);
+
 	/**
 	 * Check whether some given number of channels matches the stream's channel_count.
 	 * Throws an error if not.
@@ -313,6 +333,8 @@ private:
 
 	/// a factory for samples of appropriate type
 	factory_p sample_factory_;
+	/// the number of samples pushed
+	stat_counter samples_pushed_;
 	/// the preferred chunk size
 	int32_t chunk_size_;
 	/// stream_info shared between the various server instances
@@ -321,6 +343,8 @@ private:
 	send_buffer_p send_buffer_;
 	/// the IO service objects
 	io_context_p io_ctx_data_, io_ctx_service_;
+	/// releases idle sample arenas when no samples are pushed; runs on io_ctx_service_
+	std::shared_ptr<asio::steady_timer> trim_timer_;
 
 	/// the threaded TCP data server
 	tcp_server_p tcp_server_;
@@ -329,7 +353,8 @@ private:
 	/// UDP multicast responders for service discovery (time features disabled);
 	/// also using only the allowed IP stacks
 	std::vector<udp_server_p> responders_;
-	/// threads that handle the I/O operations (two per stack: one for UDP and one for TCP)
+	/// threads that handle the I/O operations (one for UDP and one for TCP), empty if the shared
+	/// IO threads are used
 	std::vector<thread_p> io_threads_;
 };
 
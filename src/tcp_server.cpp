@@ -1,21 +1,29 @@
 #include "tcp_server.h"
+#include "info_reply.h"
 #include "api_config.h"
 #include "consumer_queue.h"
+#include "feed_compression.h"
 #include "sample.h"
 #include "send_buffer.h"
+#include "shm_ring.h"
 #include "socket_utils.h"
 #include "stream_info_impl.h"
 #include "util/cast.hpp"
 #include "util/endian.hpp"
 #include "util/strfuns.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <asio/io_context.hpp>
 #include <asio/ip/host_name.hpp>
 #include <asio/ip/tcp.hpp>
 #include <asio/read_until.hpp>
+#include <asio/steady_timer.hpp>
 #include <asio/streambuf.hpp>
 #include <asio/write.hpp>
 #include <condition_variable>
 #include <cstdint>
+#include <cstring>
 #include <exception>
 #include <istream>
 #include <loguru.hpp>
@@ -38,6 +46,13 @@
 using std::size_t;
 
 namespace lsl {
+/// maximum number of samples that a session takes off its queue at once
+const int max_transfer_batch = 64;
+/// minimum sample size (in bytes) for which the channel data is sent without copying it first
+const std::size_t min_zero_copy_bytes = 512;
+/// how long to wait before retrying when a client's shared memory ring is full
+const auto shm_retry_interval = std::chrono::milliseconds(1);
+
 /**
  * Active session with a TCP client.
  *
@@ -54,6 +69,9 @@ namespace lsl {
  * a std::weak_ptr to the tcp_server that's upgraded to a std::shared_ptr as needed
  * - There is a per-session transfer thread (client_session::transfer_samples_thread()) that owns
  * the respective `client_session` which goes out of scope once the server is being shut down.
+ * - With the AsyncTransfer option, samples are sent from the IO thread instead
+ * (client_session::transfer_samples_async()). The session's consumer_queue then owns the session
+ * via its push notification callback until the transfer ends and the session releases the queue.
  * - The TCP server and client session also have shared ownership of the io_context (since in
  * some cases some transfer threads can outlive the stream outlet, and so the io_context is still
  * kept around until all sockets have been properly released).
@@ -65,7 +83,8 @@ class client_session : public std::enable_shared_from_this<client_session> {
 public:
 	/// Instantiate a new session & its socket.
 	client_session(const tcp_server_p &serv, tcp_socket &&sock)
-		: io_(serv->io_), serv_(serv), sock_(std::move(sock)), requeststream_(&requestbuf_) {}
+		: io_(serv->io_), serv_(serv), factory_(serv->factory_), sock_(std::move(sock)),
+		  requeststream_(&requestbuf_), shm_retry_(*io_) {}
 
 	/// Destructor.
 	~client_session();
@@ -96,16 +115,51 @@ private:
 
 	/// Transfers samples from the server's send buffer into the async send queues of IO threads
 	void transfer_samples_thread(std::shared_ptr<client_session> /*keepalive*/,
-		std::shared_ptr<consumer_queue> &&queue, int max_samples_per_chunk);
+		std::shared_ptr<consumer_queue> &&queue_arg, int max_samples_per_chunk);
+
+	/// Transfers samples from the server's send buffer from the IO thread until the queue is empty
+	void transfer_samples_async();
 
 	/// Handler that gets called when a sample transfer has been completed.
 	void handle_chunk_transfer_outcome(err_t err, std::size_t len);
 
+	/// Send the current chunk from the transfer thread and wait for completion.
+	bool send_chunk_blocking();
+
+	/// Handler that gets called when an asynchronous sample transfer has been completed.
+	void handle_async_chunk_outcome(err_t err, std::size_t len);
+
+	/**
+	 * Serialize a sample into the current chunk, returns true if the chunk should be sent.
+	 * Samples that were dropped before it (see dropped_before_) are announced to the client if
+	 * it asked for drop notices.
+	 */
+	bool add_to_chunk(sample_p &&samp);
+
+	/// Start writing the current chunk to the socket.
+	template <typename Handler> void write_chunk(Handler &&handler);
+
+	/// Release the data of a chunk that has been written.
+	void chunk_written(std::size_t len);
+
+	/// Whether the client is connected from this host (e.g., through the loopback interface).
+	bool peer_is_local();
+
+	/// Number of samples to take off the queue, publish the shared memory ring before that.
+	/// Sets wakeup_due to whether a wakeup byte has to be sent to the client first.
+	std::size_t next_batch_size(bool &wakeup_due);
+
+	/// Build the list of buffers for the samples collected in zero-copy mode.
+	const std::vector<asio::const_buffer> &gather_chunk();
+
 	/// shared pointer to IO service; ensures that the IO is still around by the time the serv_ and
 	/// sock_ need to be destroyed
 	io_context_p io_;
 	/// the server that is associated with this connection
 	std::weak_ptr<tcp_server> serv_;
+	/// the factory that owns the samples held by this session, which can outlive the server (and
+	/// the outlet) when it runs on the shared IO threads
+	factory_p factory_;
 	/// connection socket
 	tcp_socket sock_;
 
@@ -128,6 +182,59 @@ private:
 	int chunk_granularity_{0};
 	/// maximum number of samples buffered
 	int max_buffered_{0};
+	/// maximum number of samples per chunk
+	int max_samples_per_chunk_{0};
+	/// what the queue does if the client doesn't keep up
+	overflow_policy overflow_policy_{overflow_policy::drop_oldest};
+	/// whether the client wants to be told about samples that were dropped
+	bool drop_notices_{false};
+	/// number of samples dropped before the next one that's serialized
+	uint32_t dropped_before_{0};
+	/// number of samples in the chunk that is currently being assembled
+	int samples_in_current_chunk_{0};
+
+	// data used by the asynchronous transfer
+	/// the queue the samples are taken from
+	std::shared_ptr<consumer_queue> queue_;
+	/// the samples most recently taken off the queue
+	std::vector<sample_p> batch_;
+	/// the number of samples dropped before each one in batch_
+	std::vector<uint32_t> batch_dropped_;
+	/// the range of samples in batch_ that have not been serialized yet
+	std::size_t batch_pos_{0}, batch_end_{0};
+	/// the statistics of the queue, which is alive whenever a chunk is written
+	queue_stats *stats_{nullptr};
+
+	// data used if the samples are transferred through shared memory
+	/// the ring the samples are written to; the socket only carries wakeup bytes
+	std::unique_ptr<shm_ring> shm_;
+	/// set once the client has closed the connection
+	std::atomic<bool> peer_closed_{false};
+	/// receive buffer to detect the closed connection
+	char peer_buf_[16];
+	/// schedules the next attempt when the ring is full (asynchronous transfer)
+	asio::steady_timer shm_retry_;
+
+	// data used by the transfer thread if the samples are written straight from their memory
+	/// a serialized sample header
+	struct sample_header {
+		char bytes[sample::drop_notice_bytes + sample::max_header_bytes];
+		std::size_t len;
+	};
+	/// whether the channel data is written without copying it into feedbuf_ first
+	bool zero_copy_{false};
+
+	// data used if the client asked for a compressed feed
+	/// compresses the chunks serialized into feedbuf_
+	std::unique_ptr<chunk_encoder> encoder_;
+	/// the compressed chunk that is currently being written
+	std::string compressed_chunk_;
+	/// the samples of the current chunk, held until their data has been written
+	std::vector<sample_p> chunk_samples_;
+	/// the headers of the samples in the current chunk
+	std::vector<sample_header> chunk_headers_;
+	/// the buffers (headers and channel data) that make up the current chunk
+	std::vector<asio::const_buffer> chunk_buffers_;
 
 	// data exchanged between the transfer completion handler and the transfer thread
 	/// whether the current transfer has finished (possibly with an error)
@@ -185,6 +292,12 @@ void tcp_server::begin_serving() {
 	// pre-generate the info's messages
 	shortinfo_msg_ = info_->to_shortinfo_message();
 	fullinfo_msg_ = info_->to_fullinfo_message();
+	// the binary full-info reply is only built once and sent when the client's info is outdated
+	const std::string binary = info_->to_fullinfo_binary();
+	const bool xml = binary.empty();
+	fullinfo_hash_ = fullinfo_hash(xml ? fullinfo_msg_ : binary);
+	fullinfo_reply_ = fullinfo_reply::make(xml ? fullinfo_msg_ : binary, fullinfo_hash_, xml);
+	fullinfo_unchanged_reply_ = fullinfo_reply::make_unchanged(fullinfo_hash_);
 	// start accepting connections
 	if (acceptor_v4_) accept_next_connection(acceptor_v4_);
 	if (acceptor_v6_) accept_next_connection(acceptor_v6_);
@@ -200,7 +313,8 @@ void tcp_server::end_serving() {
 	// issue closure of all active client session sockets; cancels the related outstanding IO jobs
 	close_inflight_sessions();
 	// also notify any transfer threads that are blocked waiting for a sample by pushing an empty
-	// sample pointer (the threads check for !samp and skip it, see transfer_samples_thread)
+	// sample pointer (the threads check for !samp and skip it, see transfer_samples_thread, while
+	// asynchronous transfers end, see transfer_samples_async)
 	send_buffer_->push_sample(sample_p());
 }
 
@@ -321,6 +435,20 @@ void client_session::handle_read_command_outcome(err_t read_err) {
 				async_write(sock_, asio::buffer(serv->fullinfo_msg_),
 					[shared_this = shared_from_this(), serv](
 						err_t /*unused*/, std::size_t /*unused*/) {});
+		} else if (method.compare(0, 13, "LSL:fullinfo/") == 0) {
+			// fullinfo request with version and the hash of the info the client already has
+			std::vector<std::string> parts = splitandtrim(method, ' ', false);
+			auto serv = serv_.lock();
+			if (!serv) return;
+			const std::string *reply = &serv->fullinfo_msg_;
+			if (std::stoi(parts[0].substr(13)) >= 2) {
+				const bool unchanged =
+					parts.size() > 1 && std::stoull(parts[1], nullptr, 16) == serv->fullinfo_hash_;
+				reply = unchanged ? &serv->fullinfo_unchanged_reply_ : &serv->fullinfo_reply_;
+			}
+			async_write(sock_, asio::buffer(*reply),
+				[shared_this = shared_from_this(), serv](
+					err_t /*unused*/, std::size_t /*unused*/) {});
 		} else if (method == "LSL:streamfeed")
 			// streamfeed request (1.00): read feed parameters
 			async_read_until(sock_, requestbuf_, "\r\n",
@@ -408,6 +536,9 @@ void client_session::handle_read_feedparams(
 			int client_value_size = info->channel_bytes(); // assume that the client has a standard
 														   // size for the relevant data type
 			lsl_channel_format_t format = info->channel_format();
+			bool client_shared_memory = false; // the client can read from a shared memory ring
+			bool client_drop_notices = false; // the client wants to know about dropped samples
+			bool client_compression = false; // the client can read LZ4 compressed chunks
 
 			// read feed parameters
 			char buf[16384] = {0};
@@ -435,6 +566,15 @@ void client_session::handle_read_feedparams(
 					if (type == "max-buffer-length") max_buffered_ = std::stoi(rest);
 					if (type == "max-chunk-length") chunk_granularity_ = std::stoi(rest);
 					if (type == "protocol-version") client_protocol_version = std::stoi(rest);
+					if (type == "shared-memory") client_shared_memory = from_string<bool>(rest);
+					// dropping new samples isn't supported here, since the last sample of a
+					// chunk (that's most likely to be dropped) decides when the chunk is sent
+					if (type == "overflow-policy" && rest == "block")
+						overflow_policy_ = overflow_policy::block;
+					if (type == "drop-notices") client_drop_notices = from_string<bool>(rest);
+					if (type == "compression")
+						for (const auto &codec : splitandtrim(rest, ',', false))
+							client_compression |= codec == "lz4";
 				} else {
 					DLOG_F(WARNING, "%p Request line '%s' contained no key-value pair", this,
 						hdrline.c_str());
@@ -475,6 +615,21 @@ void client_session::handle_read_feedparams(
 				// determine if subnormal suppression needs to be enabled
 				client_suppress_subnormals =
 					(format_subnormal[format] && !client_supports_subnormals);
+
+				// transfer numeric samples through shared memory if the client runs on this host
+				if (client_shared_memory && format != cft_string && !reverse_byte_order_ &&
+					!client_suppress_subnormals && max_buffered_ > 0 && peer_is_local()) try {
+						shm_ = shm_ring::create(info->sample_bytes(), max_buffered_);
+					} catch (std::exception &e) {
+						LOG_F(WARNING, "%p Falling back to TCP transfer: %s", this, e.what());
+					}
+
+				// samples in the shared memory ring don't have a header to put the notice in
+				drop_notices_ = client_drop_notices && !shm_;
+
+				// compress the chunks if the client asked for it (and doesn't use shared memory)
+				if (client_compression && !shm_)
+					encoder_ = std::make_unique<chunk_encoder>(format, info->channel_count());
 			}
 
 			// send the response
@@ -484,6 +639,9 @@ void client_session::handle_read_feedparams(
 			response_stream << "Byte-Order: " << use_byte_order << "\r\n";
 			response_stream << "Suppress-Subnormals: " << client_suppress_subnormals << "\r\n";
 			response_stream << "Data-Protocol-Version: " << data_protocol_version_ << "\r\n";
+			if (shm_) response_stream << "Shared-Memory: " << shm_->name() << "\r\n";
+			if (drop_notices_) response_stream << "Drop-Notices: 1\r\n";
+			if (encoder_) response_stream << "Compression: lz4\r\n";
 			response_stream << "\r\n" << std::flush;
 		} else {
 			// read feed parameters
@@ -499,6 +657,11 @@ void client_session::handle_read_feedparams(
 		} else {
 			// allocate scratchpad memory for endian conversion, etc.
 			scratch_ = new char[format_sizes[info->channel_format()] * info->channel_count()];
+			// large numeric samples that don't need an endian conversion are written straight
+			// from the samples' memory
+			zero_copy_ = !shm_ && !encoder_ && info->channel_format() != cft_string &&
+						 !reverse_byte_order_ &&
+						 info->sample_bytes() >= static_cast<int>(min_zero_copy_bytes);
 		}
 
 		// send test pattern samples
@@ -538,19 +701,41 @@ void client_session::handle_send_feedheader_outcome(err_t err, std::size_t n) {
 		// convenient for unit tests
 		if (max_buffered_ <= 0) return;
 
-		// determine transfer parameters
-		auto queue = serv->send_buffer_->new_consumer(max_buffered_);
-
 		// determine the maximum chunk size
-		int max_samples_per_chunk = std::numeric_limits<int>::max();
+		max_samples_per_chunk_ = std::numeric_limits<int>::max();
 		if (chunk_granularity_)
-			max_samples_per_chunk = chunk_granularity_;
+			max_samples_per_chunk_ = chunk_granularity_;
 		else if (serv->chunk_size_)
-			max_samples_per_chunk = serv->chunk_size_;
+			max_samples_per_chunk_ = serv->chunk_size_;
+
+		// the client doesn't send anything in shared memory mode, so a completed read means that
+		// it has closed the connection
+		if (shm_)
+			sock_.async_read_some(asio::buffer(peer_buf_),
+				[shared_this = shared_from_this()](
+					err_t /*unused*/, std::size_t /*unused*/) { shared_this->peer_closed_ = true; });
+
+		if (api_config::get_instance()->async_transfer()) {
+			// let the queue schedule the transfer on our IO thread whenever new samples arrive
+			batch_.resize(std::min(max_samples_per_chunk_, max_transfer_batch));
+			batch_dropped_.resize(batch_.size());
+			queue_ = serv->send_buffer_->new_consumer(
+				max_buffered_,
+				[shared_this = shared_from_this()]() {
+					post(*shared_this->io_,
+						[shared_this]() { shared_this->transfer_samples_async(); });
+				},
+				overflow_policy_);
+			stats_ = &queue_->stats();
+			transfer_samples_async();
+			return;
+		}
 
 		// spawn a sample transfer thread.
+		auto queue = serv->send_buffer_->new_consumer(max_buffered_, nullptr, overflow_policy_);
+		stats_ = &queue->stats();
 		std::thread(&client_session::transfer_samples_thread, this, shared_from_this(),
-			std::move(queue), max_samples_per_chunk)
+			std::move(queue), max_samples_per_chunk_)
 			.detach();
 	} catch (std::exception &e) {
 		LOG_F(WARNING, "Unexpected error while handling the feedheader send outcome: %s", e.what());
@@ -558,44 +743,175 @@ void client_session::handle_send_feedheader_outcome(err_t err, std::size_t n) {
 }
 
 void client_session::transfer_samples_thread(std::shared_ptr<client_session> /* keepalive */,
-	std::shared_ptr<consumer_queue> &&queue, int max_samples_per_chunk) {
-	int samples_in_current_chunk = 0;
-	while (!serv_.expired()) {
-		try {
-			// get next sample from the sample queue (blocking)
-			sample_p samp(queue->pop_sample());
-
-			// ignore blank samples (they are basically wakeup notifiers from someone's
-			// end_serving())
-			if (!samp) continue;
-			// serialize the sample into the stream
-			if (data_protocol_version_ >= 110)
-				samp->save_streambuf(
-					feedbuf_, data_protocol_version_, reverse_byte_order_, scratch_);
-			else
-				*outarch_ << *samp;
-			// if the sample is marked as force-push or the configured chunk size is reached
-			if (samp->pushthrough || ++samples_in_current_chunk >= max_samples_per_chunk) {
+	std::shared_ptr<consumer_queue> &&queue_arg, int max_samples_per_chunk) {
+	// the queued samples are released on return, before the keepalive releases their factory
+	const std::shared_ptr<consumer_queue> queue(std::move(queue_arg));
+	// samples are taken off the queue in batches so that a backlog (e.g., after a network stall)
+	// can be drained without synchronizing on every single sample
+	std::vector<sample_p> batch(std::min(max_samples_per_chunk, max_transfer_batch));
+	std::vector<uint32_t> dropped(batch.size());
+	while (!serv_.expired() && !peer_closed_) {
+		bool wakeup_due = false;
+		const std::size_t max_samples = std::min(batch.size(), next_batch_size(wakeup_due));
+		if (wakeup_due) {
+			feedbuf_.sputc(1);
+			if (!send_chunk_blocking()) return;
+		}
+		if (!max_samples) {
+			// the client's shared memory ring is full, give it some time to catch up
+			std::this_thread::sleep_for(shm_retry_interval);
+			continue;
+		}
+		// get the next samples from the sample queue (blocking)
+		const std::size_t num_samples =
+			queue->pop_chunk(batch.data(), max_samples, FOREVER, dropped.data());
+		for (std::size_t k = 0; k < num_samples; k++) {
+			try {
+				sample_p samp(std::move(batch[k]));
+				dropped_before_ += dropped[k];
+
+				// ignore blank samples (they are basically wakeup notifiers from someone's
+				// end_serving())
+				if (!samp) continue;
+				// if the sample is marked as force-push or the configured chunk size is reached
 				// send off the chunk that we aggregated so far
-				std::unique_lock<std::mutex> lock(completion_mut_);
-				transfer_completed_ = false;
-				async_write(sock_, feedbuf_.data(),
-					[shared_this = shared_from_this()](err_t err, std::size_t len) {
-						shared_this->handle_chunk_transfer_outcome(err, len);
-					});
-				// wait for the completion condition
-				completion_cond_.wait(lock, [this]() { return transfer_completed_; });
-				// handle transfer outcome
-				if (!transfer_error_) {
-					feedbuf_.consume(transfer_amount_);
-				} else
-					break;
-				samples_in_current_chunk = 0;
+				if (add_to_chunk(std::move(samp)) && !send_chunk_blocking()) return;
+			} catch (std::exception &e) {
+				LOG_F(WARNING, "Unexpected glitch in transfer_samples_thread: %s", e.what());
+			}
+		}
+	}
+}
+
+bool client_session::send_chunk_blocking() {
+	std::unique_lock<std::mutex> lock(completion_mut_);
+	transfer_completed_ = false;
+	write_chunk([shared_this = shared_from_this()](err_t err, std::size_t len) {
+		shared_this->handle_chunk_transfer_outcome(err, len);
+	});
+	// wait for the completion condition
+	completion_cond_.wait(lock, [this]() { return transfer_completed_; });
+	// handle transfer outcome
+	if (transfer_error_) return false;
+	chunk_written(transfer_amount_);
+	return true;
+}
+
+void client_session::transfer_samples_async() {
+	if (!queue_) return;
+	while (!serv_.expired() && !peer_closed_) {
+		if (batch_pos_ == batch_end_) {
+			bool wakeup_due = false;
+			const std::size_t max_samples = std::min(batch_.size(), next_batch_size(wakeup_due));
+			if (wakeup_due) {
+				// the transfer resumes in the completion handler
+				feedbuf_.sputc(1);
+				write_chunk([shared_this = shared_from_this()](err_t err, std::size_t len) {
+					shared_this->handle_async_chunk_outcome(err, len);
+				});
+				return;
+			}
+			if (!max_samples) {
+				// the client's shared memory ring is full, give it some time to catch up
+				shm_retry_.expires_after(shm_retry_interval);
+				shm_retry_.async_wait([shared_this = shared_from_this()](err_t err) {
+					if (!err) shared_this->transfer_samples_async();
+				});
+				return;
+			}
+			batch_pos_ = 0;
+			batch_end_ =
+				queue_->pop_chunk(batch_.data(), max_samples, 0.0, batch_dropped_.data());
+			// wait for the queue's notification unless samples arrived in the meantime
+			if (!batch_end_ && queue_->arm_push_notification()) return;
+			continue;
+		}
+		try {
+			dropped_before_ += batch_dropped_[batch_pos_];
+			sample_p samp(std::move(batch_[batch_pos_++]));
+
+			// a blank sample is the wakeup notifier from end_serving(), so the transfer ends
+			if (!samp) break;
+			if (add_to_chunk(std::move(samp))) {
+				// send off the chunk; the transfer resumes in the completion handler
+				write_chunk([shared_this = shared_from_this()](err_t err, std::size_t len) {
+					shared_this->handle_async_chunk_outcome(err, len);
+				});
+				return;
 			}
 		} catch (std::exception &e) {
-			LOG_F(WARNING, "Unexpected glitch in transfer_samples_thread: %s", e.what());
+			LOG_F(WARNING, "Unexpected glitch in transfer_samples_async: %s", e.what());
+		}
+	}
+	// release the queue and with it the reference that its callback holds on us
+	queue_.reset();
+}
+
+bool client_session::add_to_chunk(sample_p &&samp) {
+	if (shm_) {
+		// there's always a free slot since the batch size is limited by next_batch_size()
+		char *slot = shm_->reserve();
+		std::memcpy(slot + shm_ring::timestamp_offset, &samp->timestamp(), sizeof(double));
+		std::memcpy(slot + shm_ring::data_offset, samp->raw_data(), samp->datasize());
+		shm_->commit();
+		return false;
+	}
+	const bool pushthrough = samp->pushthrough;
+	const uint32_t dropped = drop_notices_ ? dropped_before_ : 0;
+	dropped_before_ = 0;
+	// serialize the sample into the stream
+	if (zero_copy_) {
+		// only the header is serialized, the sample is kept for its channel data
+		chunk_headers_.emplace_back();
+		sample_header &header = chunk_headers_.back();
+		header.len =
+			dropped ? sample::save_drop_notice(header.bytes, dropped, reverse_byte_order_) : 0;
+		header.len += samp->save_header(header.bytes + header.len, reverse_byte_order_);
+		chunk_samples_.push_back(std::move(samp));
+	} else if (data_protocol_version_ >= 110) {
+		if (dropped) {
+			char notice[sample::drop_notice_bytes];
+			feedbuf_.sputn(
+				notice, sample::save_drop_notice(notice, dropped, reverse_byte_order_));
 		}
+		samp->save_streambuf(feedbuf_, data_protocol_version_, reverse_byte_order_, scratch_);
 	}
+	else
+		*outarch_ << *samp;
+	return pushthrough || ++samples_in_current_chunk_ >= max_samples_per_chunk_;
+}
+
+template <typename Handler> void client_session::write_chunk(Handler &&handler) {
+	samples_in_current_chunk_ = 0;
+	if (zero_copy_)
+		async_write(sock_, gather_chunk(), std::forward<Handler>(handler));
+	else if (encoder_) {
+		// the samples are consumed right away, the compressed chunk is kept until it's written
+		const auto chunk = feedbuf_.data();
+		compressed_chunk_.clear();
+		encoder_->encode(static_cast<const char *>(chunk.data()), chunk.size(), compressed_chunk_);
+		feedbuf_.consume(chunk.size());
+		async_write(sock_, asio::buffer(compressed_chunk_), std::forward<Handler>(handler));
+	} else
+		async_write(sock_, feedbuf_.data(), std::forward<Handler>(handler));
+}
+
+void client_session::chunk_written(std::size_t len) {
+	stats_->bytes.add(len);
+	if (zero_copy_) {
+		chunk_samples_.clear();
+		chunk_headers_.clear();
+	} else if (!encoder_)
+		feedbuf_.consume(len);
+}
+
+const std::vector<asio::const_buffer> &client_session::gather_chunk() {
+	chunk_buffers_.clear();
+	for (std::size_t k = 0; k < chunk_samples_.size(); k++) {
+		chunk_buffers_.emplace_back(chunk_headers_[k].bytes, chunk_headers_[k].len);
+		chunk_buffers_.emplace_back(chunk_samples_[k]->raw_data(), chunk_samples_[k]->datasize());
+	}
+	return chunk_buffers_;
 }
 
 void client_session::handle_chunk_transfer_outcome(err_t err, std::size_t len) {
@@ -615,4 +931,28 @@ void client_session::handle_chunk_transfer_outcome(err_t err, std::size_t len) {
 			e.what());
 	}
 }
+
+bool client_session::peer_is_local() {
+	asio::error_code ec;
+	const auto remote = sock_.remote_endpoint(ec);
+	if (ec) return false;
+	const auto local = sock_.local_endpoint(ec);
+	return !ec && (remote.address().is_loopback() || remote.address() == local.address());
+}
+
+std::size_t client_session::next_batch_size(bool &wakeup_due) {
+	if (!shm_) return max_transfer_batch;
+	// the samples written in the last round become visible to the client now
+	wakeup_due = shm_->publish();
+	return shm_->writable();
+}
+
+void client_session::handle_async_chunk_outcome(err_t err, std::size_t len) {
+	if (err) {
+		queue_.reset();
+		return;
+	}
+	chunk_written(len);
+	transfer_samples_async();
+}
 } // namespace lsl
@@ -28,6 +28,8 @@ using tcp_acceptor_p = std::unique_ptr<tcp_acceptor>;
  * with the shortinfo, two samples filled with a test pattern, followed by samples until the server
  * outlet goes out of existence.
  *  - `LSL:fullinfo`: A request for the stream_info served by this server.
+ *  - `LSL:fullinfo/2 [hash]`: The same, answered with a binary fullinfo_reply that only contains
+ * the (compressed) stream_info if its hash differs from the one the client already has.
  *  - `LSL:shortinfo`: A request for the stream_info served by this server if matching the provided
  * query string. The short version of the stream_info (empty `<desc>` element) is returned.
  */
@@ -102,6 +104,9 @@ private:
 	// some cached data
 	std::string shortinfo_msg_; // pre-computed short-info server response
 	std::string fullinfo_msg_;	// pre-computed full-info server response
+	uint64_t fullinfo_hash_{0};	// hash of the full-info message, see fullinfo_hash()
+	std::string fullinfo_reply_; // pre-computed binary full-info server response
+	std::string fullinfo_unchanged_reply_; // pre-computed response for clients with a current info
 };
 } // namespace lsl
 
@@ -1,5 +1,6 @@
 #include "time_postprocessor.h"
 #include "api_config.h"
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <utility>
@@ -51,30 +52,75 @@ double time_postprocessor::process_timestamp(double value) {
 	return process_internal(value);
 }
 
+void time_postprocessor::process_timestamps(double *values, std::size_t n) {
+	if (options_ == proc_none || !n) return;
+	std::unique_lock<std::mutex> lock(processing_mut_, std::defer_lock);
+	if (options_ & proc_threadsafe) lock.lock();
+	process_internal(values, n);
+}
+
 void time_postprocessor::skip_samples(uint32_t skipped_samples) {
-	if (options_ & proc_dejitter && dejitter.smoothing_applicable())
-		dejitter.samples_since_t0_ += skipped_samples;
+	if (!(options_ & proc_dejitter) || !skipped_samples) return;
+	// e.g., flush() on one thread while another one pulls
+	std::unique_lock<std::mutex> lock(processing_mut_, std::defer_lock);
+	if (options_ & proc_threadsafe) lock.lock();
+	if (dejitter.smoothing_applicable()) dejitter.skip_samples(skipped_samples);
 }
 
-double time_postprocessor::process_internal(double value) {
+void time_postprocessor::update_clocksync(std::size_t n) {
+	// update last correction value if needed (we do this every 50 samples and at most twice per
+	// second)
+	samples_since_last_clocksync = static_cast<uint8_t>(
+		std::min<std::size_t>(samples_since_last_clocksync + n, samples_between_clocksyncs + 1));
+	if (samples_since_last_clocksync > samples_between_clocksyncs &&
+		lsl_clock() > next_query_time_) {
+		last_offset_ = query_correction_();
+		samples_since_last_clocksync = 0;
+		if (query_reset_()) {
+			// reset state to unitialized
+			last_offset_ = query_correction_();
+			last_value_ = std::numeric_limits<double>::lowest();
+			// reset the dejitterer to an uninitialized state so it's
+			// initialized on the next use
+			dejitter = postproc_dejitterer();
+		}
+		next_query_time_ = lsl_clock() + 0.5;
+	}
+}
+
+void time_postprocessor::process_internal(double *values, std::size_t n) {
+	double *const end = values + n;
 	// --- clock synchronization ---
 	if (options_ & proc_clocksync) {
-		// update last correction value if needed (we do this every 50 samples and at most twice per
-		// second)
-		if (++samples_since_last_clocksync > samples_between_clocksyncs &&
-			lsl_clock() > next_query_time_) {
-			last_offset_ = query_correction_();
-			samples_since_last_clocksync = 0;
-			if (query_reset_()) {
-				// reset state to unitialized
-				last_offset_ = query_correction_();
-				last_value_ = std::numeric_limits<double>::lowest();
-				// reset the dejitterer to an uninitialized state so it's
-				// initialized on the next use
-				dejitter = postproc_dejitterer();
-			}
-			next_query_time_ = lsl_clock() + 0.5;
+		update_clocksync(n);
+		const double offset = last_offset_;
+		for (double *v = values; v != end; ++v) *v += offset;
+	}
+
+	// --- jitter removal ---
+	if (options_ & proc_dejitter) {
+		// initialize the smoothing state if not yet done so
+		if (!dejitter.is_initialized())
+			dejitter = postproc_dejitterer(*values, query_srate_(), halftime_);
+		dejitter.dejitter(values, n);
+	}
+
+	// --- force monotonic timestamps ---
+	if (options_ & proc_monotonize) {
+		double last_value = last_value_;
+		for (double *v = values; v != end; ++v) {
+			if (*v < last_value) *v = last_value;
+			else
+				last_value = *v;
 		}
+		last_value_ = last_value;
+	}
+}
+
+double time_postprocessor::process_internal(double value) {
+	// --- clock synchronization ---
+	if (options_ & proc_clocksync) {
+		update_clocksync(1);
 		// perform clock synchronization; this is done by adding the last-measured clock offset
 		// value (typically this is used to map the value from the sender's clock to our local
 		// clock)
@@ -130,6 +176,31 @@ double postproc_dejitterer::dejitter(double t) noexcept {
 	return w0_ + u1 * w1_ + t0_;			 // t = float(w.T * u) + t0
 }
 
+void postproc_dejitterer::dejitter(double *values, std::size_t n) noexcept {
+	if (!smoothing_applicable()) return;
+
+	// keep the filter state in local variables so it can stay in registers for the whole array
+	const double il_ = 1 / lam_, t0 = t0_;
+	double w0 = w0_, w1 = w1_, P00 = P00_, P01 = P01_, P11 = P11_;
+	double u1 = samples_since_t0_;
+	for (double *end = values + n; values != end; ++values, u1 += 1) {
+		const double t = *values - t0, pi0 = P00 + u1 * P01, pi1 = P01 + u1 * P11,
+					 al = t - (w0 + u1 * w1), g_inv = 1 / (lam_ + pi0 + pi1 * u1);
+		P00 = il_ * (P00 - pi0 * pi0 * g_inv);
+		P01 = il_ * (P01 - pi0 * pi1 * g_inv);
+		P11 = il_ * (P11 - pi1 * pi1 * g_inv);
+		w0 += al * (P00 + P01 * u1);
+		w1 += al * (P01 + P11 * u1);
+		*values = w0 + u1 * w1 + t0;
+	}
+	samples_since_t0_ += static_cast<uint_fast32_t>(n);
+	w0_ = w0;
+	w1_ = w1;
+	P00_ = P00;
+	P01_ = P01;
+	P11_ = P11;
+}
+
 void postproc_dejitterer::skip_samples(uint_fast32_t skipped_samples) noexcept {
 	samples_since_t0_ += skipped_samples;
 }
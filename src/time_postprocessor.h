@@ -2,6 +2,7 @@
 #define TIME_POSTPROCESSOR_H
 
 #include "common.h"
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <mutex>
@@ -31,6 +32,9 @@ struct postproc_dejitterer {
 	/// dejitter a timestamp and update RLS parameters
 	double dejitter(double t) noexcept;
 
+	/// dejitter an array of timestamps in place and update RLS parameters
+	void dejitter(double *values, std::size_t n) noexcept;
+
 	/// adjust RLS parameters to account for samples not seen
 	void skip_samples(uint_fast32_t skipped_samples) noexcept;
 	bool is_initialized() const noexcept { return t0_ != 0; }
@@ -59,6 +63,15 @@ public:
 	/// Post-process the given time stamp and return the new time-stamp.
 	double process_timestamp(double value);
 
+	/**
+	 * Post-process the given array of time stamps in place.
+	 *
+	 * Equivalent to calling process_timestamp() for each value, except that the time-correction
+	 * offset is updated at most once for the whole array and each processing step is applied to
+	 * all values before the next one.
+	 */
+	void process_timestamps(double *values, std::size_t n);
+
 	/// Override the half-time (forget factor) of the time-stamp smoothing.
 	void smoothing_halftime(float value) { halftime_ = value; }
 
@@ -69,6 +82,12 @@ private:
 	/// Internal function to process a time stamp.
 	double process_internal(double value);
 
+	/// Internal function to process an array of time stamps.
+	void process_internal(double *values, std::size_t n);
+
+	/// Query the time-correction offset if it's due after another n samples.
+	void update_clocksync(std::size_t n);
+
 	/// number of samples seen since last clocksync
 	uint8_t samples_since_last_clocksync;
 
@@ -1,8 +1,10 @@
 #include "time_receiver.h"
 #include "api_config.h"
 #include "inlet_connection.h"
+#include "io_context_pool.h"
 #include "socket_utils.h"
 #include <asio/io_context.hpp>
+#include <asio/post.hpp>
 #include <chrono>
 #include <exception>
 #include <limits>
@@ -20,16 +22,19 @@ time_receiver::time_receiver(inlet_connection &conn)
 	: conn_(conn), was_reset_(false), timeoffset_(std::numeric_limits<double>::max()),
 	  remote_time_(std::numeric_limits<double>::max()),
 	  uncertainty_(std::numeric_limits<double>::max()), cfg_(api_config::get_instance()),
-	  time_sock_(time_io_), outlet_addr_(conn_.get_udp_endpoint()), next_estimate_(time_io_),
-	  aggregate_results_(time_io_), next_packet_(time_io_) {
+	  time_io_(io_context_pool::get_instance() ? io_context_pool::get_instance()->next()
+											   : std::make_shared<asio::io_context>(1)),
+	  shared_io_(io_context_pool::get_instance() != nullptr), alive_(std::make_shared<bool>()),
+	  time_sock_(*time_io_), outlet_addr_(conn_.get_udp_endpoint()), next_estimate_(*time_io_),
+	  aggregate_results_(*time_io_), next_packet_(*time_io_) {
 	conn_.register_onlost(this, &timeoffset_upd_);
 	conn_.register_onrecover(this, [this]() {
 		reset_timeoffset_on_recovery();
-		outlet_addr_ = conn_.get_udp_endpoint();
-		DLOG_F(INFO, "Set new time service address: %s", outlet_addr_.address().to_string().c_str());
-		// handle outlet switching between IPv4 and IPv6
-		time_sock_.close();
-		time_sock_.open(outlet_addr_.protocol());
+		// the shared IO thread might be using the socket right now, so it switches it itself
+		if (shared_io_)
+			asio::post(*time_io_, guarded([this]() { switch_outlet_address(); }));
+		else
+			switch_outlet_address();
 	});
 	time_sock_.open(outlet_addr_.protocol());
 }
@@ -38,7 +43,20 @@ time_receiver::~time_receiver() {
 	try {
 		conn_.unregister_onrecover(this);
 		conn_.unregister_onlost(this);
-		time_io_.stop();
+		if (shared_io_) {
+			// cancel our operations; their handlers are skipped once alive_ is gone
+			io_context_pool::run_sync(*time_io_, [this]() {
+				alive_.reset();
+				asio::error_code ec;
+				time_sock_.close(ec);
+				next_estimate_.cancel();
+				aggregate_results_.cancel();
+				next_packet_.cancel();
+			});
+			if (started_) conn_.release_watchdog();
+			return;
+		}
+		time_io_->stop();
 		if (time_thread_.joinable()) time_thread_.join();
 	} catch (std::exception &e) {
 		LOG_F(ERROR, "Unexpected error during destruction of a time_receiver: %s", e.what());
@@ -59,8 +77,15 @@ double time_receiver::time_correction(double *remote_time, double *uncertainty,
 		return (timeoffset_ != std::numeric_limits<double>::max()) || conn_.lost();
 	};
 	if (!timeoffset_available()) {
-		// start thread if not yet running
-		if (!time_thread_.joinable()) time_thread_ = std::thread(&time_receiver::time_thread, this);
+		// start thread (or the estimation on the shared io_context) if not yet running
+		if (shared_io_) {
+			if (!started_) {
+				started_ = true;
+				conn_.acquire_watchdog();
+				asio::post(*time_io_, guarded([this]() { start_time_estimation(); }));
+			}
+		} else if (!time_thread_.joinable())
+			time_thread_ = std::thread(&time_receiver::time_thread, this);
 		// wait until the timeoffset becomes available (or we time out)
 		if (timeout >= FOREVER)
 			timeoffset_upd_.wait(lock, timeoffset_available);
@@ -95,7 +120,7 @@ void time_receiver::time_thread() {
 		// start the IO object (will keep running until cancelled)
 		while (true) {
 			try {
-				time_io_.run();
+				time_io_->run();
 				break;
 			} catch (std::exception &e) {
 				LOG_F(WARNING, "Hiccup during time_thread io_context processing: %s", e.what());
@@ -120,12 +145,13 @@ void time_receiver::start_time_estimation() {
 	// schedule the aggregation of results (by the time when all replies should have been received)
 	aggregate_results_.expires_after(timeout_sec(
 		cfg_->time_probe_max_rtt() + cfg_->time_probe_interval() * cfg_->time_probe_count()));
-	aggregate_results_.async_wait([this](err_t err) { result_aggregation_scheduled(err); });
+	aggregate_results_.async_wait(
+		guarded([this](err_t err) { result_aggregation_scheduled(err); }));
 	// schedule the next estimation step
 	next_estimate_.expires_after(timeout_sec(cfg_->time_update_interval()));
-	next_estimate_.async_wait([this](err_t err) {
+	next_estimate_.async_wait(guarded([this](err_t err) {
 		if (err != asio::error::operation_aborted) start_time_estimation();
-	});
+	}));
 }
 
 void time_receiver::send_next_packet(int packet_num) {
@@ -145,15 +171,15 @@ void time_receiver::send_next_packet(int packet_num) {
 	// schedule next packet
 	if (packet_num < cfg_->time_probe_count()) {
 		next_packet_.expires_after(timeout_sec(cfg_->time_probe_interval()));
-		next_packet_.async_wait([this, packet_num](err_t err) {
+		next_packet_.async_wait(guarded([this, packet_num](err_t err) {
 			if (!err) send_next_packet(packet_num + 1);
-		});
+		}));
 	}
 }
 
 void time_receiver::receive_next_packet() {
 	time_sock_.async_receive_from(asio::buffer(recv_buffer_), remote_endpoint_,
-		[this](err_t err, std::size_t len) { handle_receive_outcome(err, len); });
+		guarded([this](err_t err, std::size_t len) { handle_receive_outcome(err, len); }));
 }
 
 void time_receiver::handle_receive_outcome(err_t err, std::size_t len) {
@@ -209,6 +235,14 @@ void time_receiver::result_aggregation_scheduled(err_t err) {
 	}
 }
 
+void time_receiver::switch_outlet_address() {
+	outlet_addr_ = conn_.get_udp_endpoint();
+	DLOG_F(INFO, "Set new time service address: %s", outlet_addr_.address().to_string().c_str());
+	// handle outlet switching between IPv4 and IPv6
+	time_sock_.close();
+	time_sock_.open(outlet_addr_.protocol());
+}
+
 void time_receiver::reset_timeoffset_on_recovery() {
 	std::lock_guard<std::mutex> lock(timeoffset_mut_);
 	if (timeoffset_ != NOT_ASSIGNED)
@@ -1,11 +1,13 @@
 #ifndef TIME_RECEIVER_H
 #define TIME_RECEIVER_H
 
+#include "forward.h"
 #include "socket_utils.h"
 #include <asio/io_context.hpp>
 #include <asio/ip/udp.hpp>
 #include <asio/steady_timer.hpp>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
@@ -30,6 +32,7 @@ using estimate_list = std::vector<std::pair<double, double>>;
  * continues to do its job (so the next public-function call may succeed within the timeout).
  * The background thread terminates only if the time_receiver is destroyed or the underlying
  * connection is lost or shut down.
+ * If the shared IO threads are enabled, the communication runs on one of them instead.
  */
 class time_receiver {
 public:
@@ -81,10 +84,21 @@ private:
 	/// Handlers that gets called once the time estimation results shall be aggregated.
 	void result_aggregation_scheduled(err_t err);
 
+	/// Wrap a handler so it does nothing once the time_receiver is being destroyed.
+	template <typename Handler> auto guarded(Handler &&handler) {
+		return [alive = std::weak_ptr<void>(alive_), handler = std::forward<Handler>(handler)](
+				   auto &&...args) {
+			if (!alive.expired()) handler(std::forward<decltype(args)>(args)...);
+		};
+	}
+
 	/// Ensures that the time-offset is reset when the underlying connection is recovered (e.g.,
 	/// switches to another host)
 	void reset_timeoffset_on_recovery();
 
+	/// Send the time probes to the recovered outlet's address (on the time_io_ thread if shared)
+	void switch_outlet_address();
+
 	/// the underlying connection
 	inlet_connection &conn_;
 
@@ -108,8 +122,14 @@ private:
 	// data used internally by the background thread
 	/// the configuration object
 	const api_config *cfg_;
-	/// an IO service for async time operations
-	asio::io_context time_io_;
+	/// an IO service for async time operations, either our own or a shared one
+	io_context_p time_io_;
+	/// whether time_io_ is shared with other objects (and run by another thread)
+	bool shared_io_;
+	/// whether the time estimation on the shared io_context has been started
+	bool started_{false};
+	/// expires when the time_receiver is being destroyed, see guarded()
+	std::shared_ptr<void> alive_;
 	/// a buffer to hold inbound packet contents
 	char recv_buffer_[1024]{0};
 	/// the socket through which the time thread communicates
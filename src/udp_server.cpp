@@ -94,6 +94,7 @@ udp_server::udp_server(stream_info_impl_p info, asio::io_context &io, ip::addres
 void udp_server::begin_serving() {
 	// pre-calculate the shortinfo message (now that everyone should have initialized their part).
 	shortinfo_msg_ = info_->to_shortinfo_message();
+	shortinfo_binary_ = info_->to_shortinfo_binary();
 	// start asking for a packet
 	request_next_packet();
 }
@@ -129,6 +130,11 @@ void udp_server::process_shortinfo_request(std::istream& request_stream)
 	request_stream >> return_port;
 	std::string query_id;
 	request_stream >> query_id;
+	// newer resolvers announce the binary short-info format they understand on the next line
+	std::string key;
+	int binary_version = 0;
+	if (request_stream >> key && key == "Binary-Shortinfo:") request_stream >> binary_version;
+	const bool binary = binary_version >= 1 && !shortinfo_binary_.empty();
 	DLOG_F(2, "%p shortinfo req from %s for %s", (void *)this,
 		remote_endpoint_.address().to_string().c_str(), query.c_str());
 	// check query
@@ -136,8 +142,8 @@ void udp_server::process_shortinfo_request(std::istream& request_stream)
 		LOG_F(3, "%p query matches, replying to port %d", (void *)this, return_port);
 		// query matches: send back reply
 		udp::endpoint return_endpoint(remote_endpoint_.address(), return_port);
-		string_p replymsg(
-			std::make_shared<std::string>((query_id += "\r\n") += shortinfo_msg_));
+		string_p replymsg(std::make_shared<std::string>(
+			(query_id += "\r\n") += binary ? shortinfo_binary_ : shortinfo_msg_));
 		socket_->async_send_to(asio::buffer(*replymsg), return_endpoint,
 			[shared_this = shared_from_this(), replymsg](err_t err_, std::size_t /*unused*/) {
 				if (err_ != asio::error::operation_aborted && err_ != asio::error::shut_down)
@@ -84,6 +84,9 @@ private:
 	udp::endpoint remote_endpoint_;
 	/// pre-computed server response
 	std::string shortinfo_msg_;
+	/// pre-computed server response for clients that understand binary short-info messages
+	/// (empty if the stream info can't be encoded that way)
+	std::string shortinfo_binary_;
 };
 } // namespace lsl
 
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace lsl {
+
+/**
+ * A map from strings to values with a fixed capacity that evicts the least recently used entry
+ * when it's full. Lookups, insertions and evictions take constant time. Not thread-safe.
+ */
+template <typename T> class lru_cache {
+public:
+	/// Create a cache for up to capacity entries (0 disables the cache).
+	explicit lru_cache(std::size_t capacity) : capacity_(capacity) {}
+
+	lru_cache(const lru_cache &) = delete;
+	lru_cache &operator=(const lru_cache &) = delete;
+
+	/// Look up a value and mark it as the most recently used one, nullptr if it's not cached.
+	T *find(std::string_view key) {
+		auto it = index_.find(key);
+		if (it == index_.end()) return nullptr;
+		entries_.splice(entries_.begin(), entries_, it->second);
+		return &it->second->second;
+	}
+
+	/// Insert or replace a value, evicting the least recently used one if the cache is full.
+	void insert(const std::string &key, T value) {
+		if (capacity_ == 0) return;
+		if (T *cached = find(key)) {
+			*cached = std::move(value);
+			return;
+		}
+		if (entries_.size() >= capacity_) {
+			index_.erase(entries_.back().first);
+			entries_.pop_back();
+		}
+		entries_.emplace_front(key, std::move(value));
+		// the list nodes are stable, so the index can refer to the keys stored in them
+		index_.emplace(entries_.front().first, entries_.begin());
+	}
+
+	/// Remove all entries.
+	void clear() {
+		index_.clear();
+		entries_.clear();
+	}
+
+	std::size_t size() const { return entries_.size(); }
+
+private:
+	using entry_list = std::list<std::pair<std::string, T>>;
+
+	const std::size_t capacity_;
+	/// the entries, most recently used first
+	entry_list entries_;
+	std::unordered_map<std::string_view, typename entry_list::iterator> index_;
+};
+
+} // namespace lsl
@@ -0,0 +1,141 @@
+#include "lz4.hpp"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace lsl {
+
+// the block format's constants: matches are at least 4 bytes long, the last 5 bytes are always
+// literals and the last match has to start at least 12 bytes before the end
+const std::size_t min_match = 4, last_literals = 5, match_find_limit = 12;
+const std::size_t max_offset = 65535;
+const int hash_bits = 12;
+
+static inline uint32_t read32(const uint8_t *p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint32_t hash_sequence(uint32_t seq) {
+	return (seq * 2654435761U) >> (32 - hash_bits);
+}
+
+/// Write a length that didn't fit into its 4 bit token field.
+static inline uint8_t *write_length(uint8_t *op, std::size_t len) {
+	for (; len >= 255; len -= 255) *op++ = 255;
+	*op++ = static_cast<uint8_t>(len);
+	return op;
+}
+
+static inline uint8_t *write_literals(
+	uint8_t *op, uint8_t &token, const uint8_t *literals, std::size_t len) {
+	if (len >= 15) {
+		token = 15 << 4;
+		op = write_length(op, len - 15);
+	} else
+		token = static_cast<uint8_t>(len << 4);
+	if (len) memcpy(op, literals, len);
+	return op + len;
+}
+
+std::size_t lz4_compress(const char *src, std::size_t len, char *dst) {
+	const auto *const begin = reinterpret_cast<const uint8_t *>(src);
+	const uint8_t *const end = begin + len;
+	const uint8_t *ip = begin, *anchor = begin;
+	auto *op = reinterpret_cast<uint8_t *>(dst);
+
+	if (len > match_find_limit) {
+		// positions of the last sequence with each hash, relative to begin
+		uint32_t table[1 << hash_bits] = {0};
+		const uint8_t *const match_limit = end - last_literals;
+		const uint8_t *const find_limit = end - match_find_limit;
+		while (ip <= find_limit) {
+			const uint32_t seq = read32(ip);
+			const uint32_t h = hash_sequence(seq);
+			const uint8_t *ref = begin + table[h];
+			table[h] = static_cast<uint32_t>(ip - begin);
+			if (ref >= ip || static_cast<std::size_t>(ip - ref) > max_offset || read32(ref) != seq) {
+				++ip;
+				continue;
+			}
+			// extend the match as far as allowed
+			const uint8_t *const match_start = ip;
+			const auto offset = static_cast<uint16_t>(ip - ref);
+			ip += min_match;
+			ref += min_match;
+			while (ip < match_limit && *ip == *ref) ++ip, ++ref;
+
+			uint8_t *token = op++;
+			op = write_literals(op, *token, anchor, match_start - anchor);
+			*op++ = static_cast<uint8_t>(offset & 0xff);
+			*op++ = static_cast<uint8_t>(offset >> 8);
+			const std::size_t match_len = ip - match_start - min_match;
+			if (match_len >= 15) {
+				*token |= 15;
+				op = write_length(op, match_len - 15);
+			} else
+				*token |= static_cast<uint8_t>(match_len);
+			anchor = ip;
+		}
+	}
+	// the last sequence only holds literals
+	uint8_t *token = op++;
+	op = write_literals(op, *token, anchor, end - anchor);
+	return op - reinterpret_cast<uint8_t *>(dst);
+}
+
+/// Read a length that didn't fit into its 4 bit token field.
+static inline std::size_t read_length(const uint8_t *&ip, const uint8_t *end) {
+	std::size_t len = 0;
+	uint8_t b;
+	do {
+		if (ip == end) throw std::runtime_error("Truncated LZ4 block");
+		b = *ip++;
+		len += b;
+	} while (b == 255);
+	return len;
+}
+
+std::size_t lz4_decompress(const char *src, std::size_t len, char *dst, std::size_t capacity) {
+	const auto *ip = reinterpret_cast<const uint8_t *>(src);
+	const uint8_t *const iend = ip + len;
+	auto *const obegin = reinterpret_cast<uint8_t *>(dst);
+	uint8_t *op = obegin;
+	uint8_t *const oend = obegin + capacity;
+	while (true) {
+		if (ip == iend) throw std::runtime_error("Truncated LZ4 block");
+		const uint8_t token = *ip++;
+		std::size_t literals = token >> 4;
+		if (literals == 15) literals += read_length(ip, iend);
+		if (literals > static_cast<std::size_t>(iend - ip) ||
+			literals > static_cast<std::size_t>(oend - op))
+			throw std::runtime_error("LZ4 literals exceed the block");
+		if (literals) memcpy(op, ip, literals);
+		ip += literals;
+		op += literals;
+		// the last sequence ends after its literals
+		if (ip == iend) break;
+
+		if (iend - ip < 2) throw std::runtime_error("Truncated LZ4 block");
+		const std::size_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > static_cast<std::size_t>(op - obegin))
+			throw std::runtime_error("Invalid LZ4 match offset");
+		std::size_t match_len = token & 15;
+		if (match_len == 15) match_len += read_length(ip, iend);
+		match_len += min_match;
+		if (match_len > static_cast<std::size_t>(oend - op))
+			throw std::runtime_error("LZ4 match exceeds the output buffer");
+		const uint8_t *ref = op - offset;
+		if (offset >= match_len)
+			memcpy(op, ref, match_len);
+		else
+			// overlapping matches repeat the last `offset` bytes
+			for (std::size_t i = 0; i < match_len; ++i) op[i] = ref[i];
+		op += match_len;
+	}
+	return op - obegin;
+}
+
+} // namespace lsl
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+namespace lsl {
+
+/**
+ * A fast compressor for the LZ4 block format.
+ *
+ * Only the block format (no frames, checksums or dictionaries) is implemented, so the output can
+ * be decompressed with `LZ4_decompress_safe()` and vice versa. The compressor is greedy and uses
+ * a small hash table on the stack, so it's meant for metadata and sample chunks rather than for
+ * the best ratio.
+ */
+
+/// The maximum size of the compressed data for an input of `len` bytes.
+inline std::size_t lz4_compress_bound(std::size_t len) { return len + len / 255 + 16; }
+
+/**
+ * Compress a block.
+ * @param dst A buffer of at least lz4_compress_bound(len) bytes.
+ * @return The size of the compressed data.
+ */
+std::size_t lz4_compress(const char *src, std::size_t len, char *dst);
+
+/**
+ * Decompress a block.
+ *
+ * The input may come from the network, so all offsets and lengths are checked.
+ * @return The size of the decompressed data.
+ * @throws std::runtime_error if the data is malformed or doesn't fit into `capacity` bytes.
+ */
+std::size_t lz4_decompress(const char *src, std::size_t len, char *dst, std::size_t capacity);
+
+} // namespace lsl
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+// Detection of the vector instruction sets that are part of the baseline of the target
+// architecture, i.e. SSE2 on x86-64 and NEON on AArch64. Kernels using them don't need runtime
+// dispatch; on all other targets they fall back to their scalar implementation.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LSL_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define LSL_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(LSL_SIMD_SSE2) || defined(LSL_SIMD_NEON)
+#define LSL_SIMD
+#endif
+
+namespace lsl {
+/// width of a vector register in bytes, or 1 if no vector instructions are used
+#ifdef LSL_SIMD
+constexpr std::size_t simd_width = 16;
+#else
+constexpr std::size_t simd_width = 1;
+#endif
+} // namespace lsl
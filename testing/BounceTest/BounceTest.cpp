@@ -1,4 +1,5 @@
 #include <stdint.h>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include "../../include/lsl_cpp.h"
@@ -6,9 +7,11 @@
 #include <numeric>
 #include <cmath>
 #include <iomanip>
+#include <vector>
 
 
-/* Test the latency between sending a sample and receiving it*/
+/* Test the latency between sending a sample and receiving it
+ * Usage: BounceTest [--busy-poll] */
 
 int main(int argc, char *argv[]) {
 /*	if (argc != 2)
@@ -37,7 +40,9 @@ int main(int argc, char *argv[]) {
 	lsl::stream_info si = found_stream_info[0];
 	std::cout << "Found " << si.name() << '@' << si.hostname() << std::endl;
 
-	lsl::stream_inlet inlet(found_stream_info[0]);
+	const bool busy_poll = argc > 1 && std::string(argv[1]) == "--busy-poll";
+	lsl::stream_inlet inlet(found_stream_info[0], 360, 0, true,
+		busy_poll ? transp_busy_poll : transp_default);
 
 	// push a single sample first
 	int dummy=0;
@@ -69,6 +74,10 @@ int main(int argc, char *argv[]) {
 	          << ", System Boost: " << LSL_USE_SYSTEM_BOOST << std::endl;*/
 	std::cout << "Bounced " << numBounces << " samples, latency M="
 	          << (meanLatency*1000) << "ms, SD=" << (sdLatency*1000) << "ms" << std::endl;
+	std::vector<double> sorted(latencies + 1, latencies + numBounces);
+	std::sort(sorted.begin(), sorted.end());
+	std::cout << "Latency p50=" << (sorted[sorted.size() / 2] * 1000) << "ms, p99="
+	          << (sorted[sorted.size() * 99 / 100] * 1000) << "ms" << std::endl;
 	std::ofstream tscsv("bounce.csv");
 	if(tscsv.is_open()) {
 		tscsv << "t1\tt2\n" << std::setprecision(15) << std::fixed;
@@ -3,8 +3,11 @@
 #include <catch2/catch_approx.hpp>
 #include <catch2/catch_template_test_macros.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <cmath>
 #include <cstdint>
+#include <limits>
 #include <lsl_cpp.h>
+#include <memory>
 #include <thread>
 
 // clazy:excludeall=non-pod-global-static
@@ -76,6 +79,76 @@ TEST_CASE("TypeConversion", "[datatransfer][types][basic]") {
 	}
 }
 
+TEMPLATE_TEST_CASE("NumericConversion", "[datatransfer][types][basic]", int16_t, int32_t,
+	int64_t, float, double) {
+	// enough channels for the vectorized conversions and a remainder
+	const int32_t numChannels = 19;
+	const char *name = SampleType<TestType>::fmt_string();
+	auto cf = static_cast<lsl::channel_format_t>(SampleType<TestType>::chan_fmt);
+	Streampair sp(create_streampair(lsl::stream_info(
+		name, "NumericConversion", numChannels, lsl::IRREGULAR_RATE, cf, "NumericConversion")));
+
+	std::vector<TestType> sent_data(numChannels);
+	for (int32_t i = 0; i < numChannels; ++i)
+		sent_data[i] = static_cast<TestType>(
+			(i % 2 ? -1 : 1) * (std::numeric_limits<TestType>::max() / (i + 1)));
+	sp.out_.push_sample(sent_data);
+	sp.out_.push_sample(sent_data);
+
+	// the results have to be the same as for a plain static_cast
+	std::vector<float> received_floats(numChannels);
+	std::vector<double> received_doubles(numChannels);
+	REQUIRE(sp.in_.pull_sample(received_floats, 2.) != 0.0);
+	REQUIRE(sp.in_.pull_sample(received_doubles, 2.) != 0.0);
+	for (int32_t i = 0; i < numChannels; ++i) {
+		CHECK(received_floats[i] == static_cast<float>(sent_data[i]));
+		CHECK(received_doubles[i] == static_cast<double>(sent_data[i]));
+	}
+}
+
+TEST_CASE("pull_chunk", "[datatransfer][basic]") {
+	Streampair sp{create_streampair(
+		lsl::stream_info("PullChunk", "chunks", 2, 100, lsl::cf_int32, "PullChunk"))};
+	const int n = 200;
+	std::vector<int32_t> data(n * 2);
+	std::vector<double> timestamps(n);
+	for (int i = 0; i < n; ++i) {
+		data[2 * i] = i;
+		data[2 * i + 1] = -i;
+		timestamps[i] = 1000. + i;
+	}
+	sp.out_.push_chunk_multiplexed(data.data(), timestamps.data(), data.size(), true);
+
+	std::vector<int32_t> data_in(data.size());
+	std::vector<double> ts_in(n);
+	// blocks until the buffers are full or the timeout expires
+	REQUIRE(sp.in_.pull_chunk_multiplexed(
+				data_in.data(), ts_in.data(), data_in.size(), ts_in.size(), 5.) == data.size());
+	CHECK(data_in == data);
+	CHECK(ts_in == timestamps);
+	// nothing left to pull
+	CHECK(sp.in_.pull_chunk_multiplexed(data_in.data(), nullptr, data_in.size(), 0) == 0);
+}
+
+TEST_CASE("large samples", "[datatransfer][basic]") {
+	// samples this large are sent straight from the outlet's sample memory
+	const int32_t numChannels = 300, n = 50;
+	const double srate = 100.;
+	Streampair sp{create_streampair(lsl::stream_info(
+		"LargeSamples", "large", numChannels, srate, lsl::cf_double64, "LargeSamples"))};
+	std::vector<double> data(numChannels * n);
+	for (std::size_t i = 0; i < data.size(); ++i) data[i] = i * .5;
+	// only the last sample gets a time stamp, the others have deduced time stamps
+	sp.out_.push_chunk_multiplexed(data.data(), data.size(), 1000., true);
+
+	std::vector<double> data_in(data.size()), ts_in(n);
+	REQUIRE(sp.in_.pull_chunk_multiplexed(
+				data_in.data(), ts_in.data(), data_in.size(), ts_in.size(), 5.) == data.size());
+	CHECK(data_in == data);
+	CHECK(ts_in.back() == Catch::Approx(1000.));
+	for (int32_t i = 1; i < n; ++i) CHECK(ts_in[i] - ts_in[i - 1] == Catch::Approx(1 / srate));
+}
+
 TEST_CASE("Flush", "[datatransfer][basic]") {
 	Streampair sp{create_streampair(
 		lsl::stream_info("FlushTest", "flush", 1, 1, lsl::cf_double64, "FlushTest"))};
@@ -107,3 +180,100 @@ TEST_CASE("Flush", "[datatransfer][basic]") {
 	pusher.join();
 	//sp.in_.set_postprocessing(lsl::post_none);
 }
+
+TEST_CASE("busy polling", "[datatransfer][basic]") {
+	lsl::stream_outlet outlet(
+		lsl::stream_info("BusyPoll", "Test", 1, lsl::IRREGULAR_RATE, lsl::cf_int32, "BusyPoll"));
+	auto found = lsl::resolve_stream("source_id", "BusyPoll", 1, 2.);
+	REQUIRE(found.size() == 1);
+	auto inlet = std::make_unique<lsl::stream_inlet>(found[0], 360, 0, true, transp_busy_poll);
+	inlet->open_stream(2);
+	outlet.wait_for_consumers(2);
+
+	SECTION("pull") {
+		// the inlet polls the socket (and pulls poll the inlet's buffer) for each sample
+		for (int32_t i = 0; i < 200; ++i) {
+			if (i % 50 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			outlet.push_sample(&i, 0, true);
+			int32_t value = -1;
+			REQUIRE(inlet->pull_sample(&value, 1, 2.) != 0.);
+			CHECK(value == i);
+		}
+	}
+
+	SECTION("close_stream while polling") {
+		// one thread polls the inlet's buffer, the data thread polls the socket
+		std::thread puller([&]() {
+			int32_t value;
+			inlet->pull_sample(&value, 1, .5);
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		const double start = lsl::local_clock();
+		inlet->close_stream();
+		CHECK(lsl::local_clock() - start < 2.);
+		puller.join();
+
+		// the stream can be opened again
+		inlet->open_stream(2);
+		int32_t value = 1, value_in = 0;
+		const double end = lsl::local_clock() + 5.;
+		while (value_in != value && lsl::local_clock() < end) {
+			outlet.push_sample(&value, 0, true);
+			inlet->pull_sample(&value_in, 1, .2);
+		}
+		CHECK(value_in == value);
+	}
+
+	SECTION("destroyed while polling") {
+		int32_t value;
+		CHECK(inlet->pull_sample(&value, 1, .1) == 0.);
+		const double start = lsl::local_clock();
+		inlet.reset();
+		CHECK(lsl::local_clock() - start < 2.);
+	}
+}
+
+TEST_CASE("compressed data feed", "[compression][basic]") {
+	const int32_t numChannels = 8, n = 1000;
+	lsl::stream_outlet outlet(lsl::stream_info(
+		"CompressedFeed", "Test", numChannels, 1000., lsl::cf_int16, "CompressedFeed"));
+	auto found = lsl::resolve_stream("source_id", "CompressedFeed", 1, 2.);
+	REQUIRE(found.size() == 1);
+	lsl::stream_inlet plain(found[0]), compressed(found[0], 360, 0, true, transp_compress);
+
+	// wait_for_consumers() returns as soon as one inlet is served, so push markers until both
+	// inlets receive them
+	std::vector<int16_t> marker(numChannels, INT16_MIN), sample(numChannels);
+	for (lsl::stream_inlet *inlet : {&plain, &compressed}) {
+		const double end = lsl::local_clock() + 5.;
+		sample[0] = 0;
+		while (sample[0] != INT16_MIN && lsl::local_clock() < end) {
+			outlet.push_sample(marker);
+			inlet->pull_sample(sample, .2);
+		}
+		REQUIRE(sample[0] == INT16_MIN);
+	}
+	const uint64_t plain_before = plain.stats()[lsl_stat_bytes],
+				   compressed_before = compressed.stats()[lsl_stat_bytes];
+
+	// slowly changing values compress well, so the compressed feed has to be much smaller
+	std::vector<int16_t> data(numChannels * n);
+	for (std::size_t i = 0; i < data.size(); ++i)
+		data[i] = static_cast<int16_t>(100 * std::sin(i / numChannels * .01 + i % numChannels));
+	outlet.push_chunk_multiplexed(data.data(), data.size(), 1000., true);
+
+	for (lsl::stream_inlet *inlet : {&plain, &compressed}) {
+		std::vector<int16_t> data_in;
+		double ts = 0.;
+		for (int32_t i = 0; i < n; ++i) {
+			// skip the markers that were still on their way
+			do REQUIRE((ts = inlet->pull_sample(sample, 5.)) != 0.);
+			while (sample[0] == INT16_MIN);
+			data_in.insert(data_in.end(), sample.begin(), sample.end());
+		}
+		CHECK(data_in == data);
+		CHECK(ts == Catch::Approx(1000.));
+	}
+	CHECK(compressed.stats()[lsl_stat_bytes] - compressed_before <
+		  (plain.stats()[lsl_stat_bytes] - plain_before) / 2);
+}
@@ -24,6 +24,37 @@ TEST_CASE("resolve multiple streams", "[resolver][basic]") {
 	REQUIRE(resolver.results().size() == n);
 }
 
+TEST_CASE("resolver change notifications", "[resolver][basic]") {
+	lsl::continuous_resolver resolver("type", "ResolveChanges", 0.5);
+	uint64_t generation = 0;
+	REQUIRE(resolver.changes(generation).empty());
+
+	std::string uid;
+	{
+		lsl::stream_outlet outlet(lsl::stream_info("resolvechanges", "ResolveChanges"));
+		uid = outlet.info().uid();
+		REQUIRE(resolver.wait_for_changes(generation, 5.));
+		auto changes = resolver.changes(generation);
+		REQUIRE(!changes.empty());
+		CHECK(changes.front().kind == lsl_resolver_added);
+		CHECK(changes.front().info.uid() == uid);
+		for (const auto &change : changes) CHECK(change.kind != lsl_resolver_removed);
+	}
+
+	// the outlet is gone, so it's forgotten after forget_after seconds
+	bool removed = false;
+	for (int i = 0; i < 10 && !removed; ++i) {
+		resolver.wait_for_changes(generation, 1.);
+		for (const auto &change : resolver.changes(generation))
+			if (change.kind == lsl_resolver_removed) {
+				CHECK(change.info.uid() == uid);
+				removed = true;
+			}
+	}
+	REQUIRE(removed);
+	REQUIRE(resolver.results().empty());
+}
+
 TEST_CASE("resolve from streaminfo", "[resolver][streaminfo][basic]") {
 	lsl::stream_outlet outlet(lsl::stream_info("resolvetest", "from_streaminfo"));
 	lsl::stream_inlet(outlet.info());
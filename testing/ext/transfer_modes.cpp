@@ -0,0 +1,398 @@
+#include "../common/create_streampair.hpp"
+#include <atomic>
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <lsl_cpp.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// clazy:excludeall=non-pod-global-static
+
+// The transfer modes in this file are enabled in the process-wide configuration, so each test is
+// hidden and only run by the ctest run with the matching config file from testing/lslcfgs.
+
+namespace {
+
+/// Pull samples until the inlet reports the loss of its stream or the time is up.
+void pull_until_lost(lsl::stream_inlet &inlet, double max_time) {
+	const double end = lsl::local_clock() + max_time;
+	int32_t value;
+	while (lsl::local_clock() < end) inlet.pull_sample(&value, 1, .1);
+}
+
+/// Push the value until the inlet receives it (e.g., after recovering) or the time is up.
+bool push_until_received(
+	lsl::stream_outlet &outlet, lsl::stream_inlet &inlet, int32_t value, double max_time) {
+	const double end = lsl::local_clock() + max_time;
+	int32_t value_in = value - 1;
+	while (value_in != value && lsl::local_clock() < end) {
+		outlet.push_sample(&value);
+		inlet.pull_sample(&value_in, 1, .2);
+	}
+	return value_in == value;
+}
+
+#ifdef __linux__
+/// Remove the names of new shared memory rings until `done` is set, so inlets can't attach.
+void unlink_rings(const std::atomic<bool> &done) {
+	const int fd = inotify_init1(IN_NONBLOCK);
+	if (fd < 0) return;
+	if (inotify_add_watch(fd, "/dev/shm", IN_CREATE) < 0) {
+		close(fd);
+		return;
+	}
+	alignas(inotify_event) char events[4096];
+	pollfd pfd{fd, POLLIN, 0};
+	while (!done) {
+		if (poll(&pfd, 1, 10) <= 0) continue;
+		const ssize_t len = read(fd, events, sizeof(events));
+		for (ssize_t pos = 0; pos < len;) {
+			const auto *event = reinterpret_cast<const inotify_event *>(events + pos);
+			if (event->len && std::strncmp(event->name, "lsl_", 4) == 0)
+				unlink((std::string("/dev/shm/") + event->name).c_str());
+			pos += sizeof(inotify_event) + event->len;
+		}
+	}
+	close(fd);
+}
+#endif
+
+TEST_CASE("intra-process inlets", "[.intra_process]") {
+	const double srate = 100.;
+	lsl::stream_info info("IntraProcess", "Test", 1, srate, lsl::cf_int32, "IntraProcess");
+	auto outlet = std::make_unique<lsl::stream_outlet>(info);
+	auto found = lsl::resolve_stream("source_id", "IntraProcess", 1, 2.);
+	REQUIRE(found.size() == 1);
+	lsl::stream_inlet inlet(found[0]), inlet2(found[0], 360, 0, false);
+	inlet.open_stream(2);
+	inlet2.open_stream(2);
+	outlet->wait_for_consumers(2);
+
+	SECTION("pull from an outlet in the same process") {
+		const int n = 50;
+		std::vector<int32_t> data(n), data_in(n), data_in2(n);
+		std::vector<double> ts_in(n), ts_in2(n);
+		for (int i = 0; i < n; ++i) data[i] = i;
+		// only the last sample gets a time stamp, the others have deduced time stamps
+		outlet->push_chunk_multiplexed(data.data(), data.size(), 1000., true);
+
+		REQUIRE(inlet.pull_chunk_multiplexed(data_in.data(), ts_in.data(), n, n, 5.) == n);
+		CHECK(data_in == data);
+		CHECK(ts_in.back() == Catch::Approx(1000.));
+		for (int i = 1; i < n; ++i) CHECK(ts_in[i] - ts_in[i - 1] == Catch::Approx(1 / srate));
+
+		// the samples are shared, so deducing the time stamps for one inlet mustn't change them
+		// for the other one
+		for (int i = 0; i < n; ++i) {
+			ts_in2[i] = inlet2.pull_sample(&data_in2[i], 1, 5.);
+			REQUIRE(ts_in2[i] != 0.);
+		}
+		CHECK(data_in2 == data);
+		CHECK(ts_in2 == ts_in);
+	}
+
+	SECTION("outlet destroyed mid-stream") {
+		int32_t value = 1;
+		outlet->push_sample(&value);
+		int32_t value_in = 0;
+		REQUIRE(inlet.pull_sample(&value_in, 1, 5.) != 0.);
+		REQUIRE(inlet2.pull_sample(&value_in, 1, 5.) != 0.);
+		CHECK(value_in == 1);
+		outlet.reset();
+
+		// without recovery, the inlet falls back to the data thread and reports the loss
+		CHECK_THROWS_AS(pull_until_lost(inlet2, 10.), lsl::lost_error);
+
+		// a recovering inlet reconnects to the outlet that replaces the lost one
+		outlet = std::make_unique<lsl::stream_outlet>(info);
+		CHECK(push_until_received(*outlet, inlet, 2, 10.));
+	}
+
+	SECTION("outlet destroyed with samples queued") {
+		// the queued samples outlive the outlet that created them
+		const int n = 50;
+		std::vector<int32_t> data(n);
+		for (int i = 0; i < n; ++i) data[i] = i;
+		outlet->push_chunk_multiplexed(data);
+		outlet.reset();
+		std::vector<int32_t> data_in(n);
+		for (auto &value : data_in) REQUIRE(inlet2.pull_sample(&value, 1, 5.) != 0.);
+		CHECK(data_in == data);
+		CHECK_THROWS_AS(pull_until_lost(inlet2, 10.), lsl::lost_error);
+	}
+}
+
+TEST_CASE("inlet churn on shared IO threads", "[.shared_io][timesync]") {
+	lsl::stream_info info("SharedIOInlets", "Test", 1, lsl::IRREGULAR_RATE, lsl::cf_int32,
+		"SharedIOInlets");
+	auto outlet = std::make_unique<lsl::stream_outlet>(info);
+	auto found = lsl::resolve_stream("source_id", "SharedIOInlets", 1, 2.);
+	REQUIRE(found.size() == 1);
+	lsl::stream_inlet survivor(found[0]);
+	survivor.open_stream(2);
+	CHECK(std::abs(survivor.time_correction(5.)) < .01);
+
+	// inlets are created and destroyed with time probes, watchdog checks and recoveries in
+	// flight, while their outlet disappears and comes back
+	std::atomic<bool> done{false};
+	std::atomic<int> churned{0};
+	auto churn = [&](bool recover) {
+		while (!done) {
+			lsl::stream_inlet inlet(found[0], 360, 0, recover);
+			try {
+				if (churned++ % 2) inlet.open_stream(.05);
+				inlet.time_correction(.05);
+			} catch (std::exception &) {
+				// timeouts and lost streams are expected while the outlet is gone
+			}
+		}
+	};
+	std::thread recovering(churn, true), irrecoverable(churn, false);
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	outlet.reset();
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	outlet = std::make_unique<lsl::stream_outlet>(info);
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	done = true;
+	recovering.join();
+	irrecoverable.join();
+	CHECK(churned > 2);
+
+	// the remaining inlet recovered, and its time correction starts over for the new outlet
+	CHECK(push_until_received(*outlet, survivor, 1, 10.));
+	CHECK(std::abs(survivor.time_correction(5.)) < .01);
+	CHECK(survivor.was_clock_reset());
+}
+
+TEST_CASE("outlet churn on shared IO threads", "[.shared_io][datatransfer]") {
+	// more outlets than shared IO threads, so the threads serve several outlets at once
+	const int num_outlets = 5;
+	auto source_id = [](int k) { return "SharedIOOutlet" + std::to_string(k); };
+	std::vector<std::unique_ptr<lsl::stream_outlet>> outlets;
+	std::vector<std::unique_ptr<lsl::stream_inlet>> inlets;
+	for (int round = 0; round < 2; ++round) {
+		INFO(round);
+		for (int k = 0; k < num_outlets; ++k)
+			outlets.push_back(std::make_unique<lsl::stream_outlet>(lsl::stream_info(
+				"SharedIOOutlet", "Test", 1, lsl::IRREGULAR_RATE, lsl::cf_int32, source_id(k))));
+
+		// every outlet resolves and delivers its own samples
+		for (int k = 0; k < num_outlets; ++k) {
+			INFO(k);
+			auto found = lsl::resolve_stream("source_id", source_id(k), 1, 2.);
+			REQUIRE(found.size() == 1);
+			inlets.push_back(std::make_unique<lsl::stream_inlet>(found[0], 360, 0, false));
+			inlets[k]->open_stream(2);
+			CHECK(push_until_received(*outlets[k], *inlets[k], 100 * round + k, 5.));
+		}
+
+		// destroying every other outlet (while its sessions still hold samples) neither stops the
+		// IO threads for the remaining ones nor leaves the destroyed ones resolvable
+		const std::vector<int32_t> backlog(5000, 1);
+		for (int k = 0; k < num_outlets; k += 2) {
+			outlets[k]->push_chunk_multiplexed(backlog);
+			outlets[k].reset();
+		}
+		inlets.clear();
+		for (int k = 0; k < num_outlets; ++k) {
+			INFO(k);
+			auto found = lsl::resolve_stream("source_id", source_id(k), 1, .5);
+			CHECK(found.size() == (outlets[k] ? 1U : 0U));
+		}
+		for (int k = 1; k < num_outlets; k += 2) {
+			INFO(k);
+			auto found = lsl::resolve_stream("source_id", source_id(k), 1, 2.);
+			REQUIRE(found.size() == 1);
+			lsl::stream_inlet inlet(found[0], 360, 0, false);
+			inlet.open_stream(2);
+			CHECK(push_until_received(*outlets[k], inlet, 100 * round + 50 + k, 5.));
+		}
+		outlets.clear();
+	}
+}
+
+TEST_CASE("asynchronous transfer", "[.async_transfer]") {
+	lsl::stream_info info(
+		"AsyncTransfer", "Test", 1, lsl::IRREGULAR_RATE, lsl::cf_int32, "AsyncTransfer");
+
+	SECTION("sample order") {
+		// the chunks end either after 16 samples or at a pushthrough sample
+		lsl::stream_outlet outlet(info, 16);
+		auto found = lsl::resolve_stream("source_id", "AsyncTransfer", 1, 2.);
+		REQUIRE(found.size() == 1);
+		lsl::stream_inlet inlet(found[0], 360, 0, false);
+		inlet.open_stream(2);
+		outlet.wait_for_consumers(2);
+
+		const int n = 2000;
+		for (int32_t i = 0; i < n; ++i) outlet.push_sample(&i, 0., i % 7 == 0 || i == n - 1);
+		std::vector<int32_t> received(n);
+		for (auto &value : received) REQUIRE(inlet.pull_sample(&value, 1, 5.) != 0.);
+		for (int32_t i = 0; i < n; ++i)
+			if (received[i] != i) FAIL("sample " << i << " arrived as " << received[i]);
+	}
+
+	SECTION("pushthrough") {
+		// without pushthrough, samples are held back until 1000 of them make up a chunk
+		lsl::stream_outlet outlet(info, 1000);
+		auto found = lsl::resolve_stream("source_id", "AsyncTransfer", 1, 2.);
+		REQUIRE(found.size() == 1);
+		lsl::stream_inlet inlet(found[0], 360, 0, false);
+		inlet.open_stream(2);
+		outlet.wait_for_consumers(2);
+
+		int32_t value = 1, value_in = 0;
+		outlet.push_sample(&value, 0., false);
+		CHECK(inlet.pull_sample(&value_in, 1, .5) == 0.);
+		value = 2;
+		outlet.push_sample(&value, 0., true);
+		REQUIRE(inlet.pull_sample(&value_in, 1, 5.) != 0.);
+		CHECK(value_in == 1);
+		REQUIRE(inlet.pull_sample(&value_in, 1, 5.) != 0.);
+		CHECK(value_in == 2);
+	}
+
+	SECTION("shutdown while a write is pending") {
+		// chunks large enough to fill the socket buffers, so writes are still in flight when
+		// either side goes away
+		const int channels = 25000, n = 100;
+		lsl::stream_info big_info("AsyncTransferBig", "Test", channels, lsl::IRREGULAR_RATE,
+			lsl::cf_float32, "AsyncTransferBig");
+		auto outlet = std::make_unique<lsl::stream_outlet>(big_info);
+		auto found = lsl::resolve_stream("source_id", "AsyncTransferBig", 1, 2.);
+		REQUIRE(found.size() == 1);
+		std::vector<float> data(static_cast<std::size_t>(channels) * n, 1.f);
+
+		// an inlet that disappears mid-transfer doesn't stall the outlet for the other inlets
+		auto leaving = std::make_unique<lsl::stream_inlet>(found[0], 360, 0, false);
+		lsl::stream_inlet inlet(found[0], 360, 0, false);
+		leaving->open_stream(2);
+		inlet.open_stream(2);
+		outlet->wait_for_consumers(2);
+		outlet->push_chunk_multiplexed(data.data(), data.size());
+		leaving.reset();
+		std::vector<float> sample(channels);
+		for (int i = 0; i < n; ++i) REQUIRE(inlet.pull_sample(sample, 5.) != 0.);
+
+		// destroying the outlet aborts the pending writes
+		outlet->push_chunk_multiplexed(data.data(), data.size());
+		const double start = lsl::local_clock();
+		outlet.reset();
+		CHECK(lsl::local_clock() - start < 2.);
+		auto pull_all = [&]() {
+			const double end = lsl::local_clock() + 10.;
+			while (lsl::local_clock() < end) inlet.pull_sample(sample, .1);
+		};
+		CHECK_THROWS_AS(pull_all(), lsl::lost_error);
+	}
+}
+
+TEST_CASE("shared memory transport", "[.shared_memory]") {
+	lsl::stream_info info(
+		"SharedMemory", "Test", 1, lsl::IRREGULAR_RATE, lsl::cf_int32, "SharedMemory");
+	auto outlet = std::make_unique<lsl::stream_outlet>(info);
+	auto found = lsl::resolve_stream("source_id", "SharedMemory", 1, 2.);
+	REQUIRE(found.size() == 1);
+
+	SECTION("wakeups") {
+		lsl::stream_inlet inlet(found[0], 360, 0, false);
+		inlet.open_stream(2);
+		outlet->wait_for_consumers(2);
+		// the inlet has run out of samples before each push, so each one needs a wakeup byte
+		const int32_t n = 20;
+		for (int32_t i = 0; i < n; ++i) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			outlet->push_sample(&i, 100. + i);
+			int32_t value = -1;
+			CHECK(inlet.pull_sample(&value, 1, 1.) == 100. + i);
+			CHECK(value == i);
+		}
+		// the samples didn't go through the socket, only the wakeup bytes did
+		CHECK(outlet->stats()[lsl_stat_bytes] <= static_cast<uint64_t>(n));
+	}
+
+	SECTION("full ring") {
+		// the inlet blocks when its buffer is full, so the ring fills up and the outlet has to
+		// retry until there's room again
+		const int32_t n = 500;
+		lsl::stream_inlet inlet(found[0], 16, 0, false,
+			static_cast<lsl_transport_options_t>(transp_bufsize_samples | transp_block_when_full));
+		inlet.open_stream(2);
+		outlet->wait_for_consumers(2);
+		std::thread pusher([&]() {
+			for (int32_t i = 0; i < n; ++i) outlet->push_sample(&i);
+		});
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		std::vector<int32_t> received(n);
+		for (auto &value : received) REQUIRE(inlet.pull_sample(&value, 1, 5.) != 0.);
+		pusher.join();
+		for (int32_t i = 0; i < n; ++i)
+			if (received[i] != i) FAIL("sample " << i << " arrived as " << received[i]);
+		CHECK(inlet.stats()[lsl_stat_dropped] == 0);
+	}
+
+	SECTION("outlet lost") {
+		lsl::stream_inlet inlet(found[0]), inlet2(found[0], 360, 0, false);
+		inlet.open_stream(2);
+		inlet2.open_stream(2);
+		CHECK(push_until_received(*outlet, inlet2, 1, 5.));
+		// both inlets are waiting for a wakeup when the outlet goes away
+		outlet.reset();
+		CHECK_THROWS_AS(pull_until_lost(inlet2, 10.), lsl::lost_error);
+		outlet = std::make_unique<lsl::stream_outlet>(info);
+		CHECK(push_until_received(*outlet, inlet, 2, 10.));
+	}
+
+#ifdef __linux__
+	SECTION("fallback if the inlet can't attach") {
+		// e.g., the outlet runs in another container with its own /dev/shm; the names are removed
+		// as soon as they're created, which usually (but not always) happens before the inlets
+		// attach
+		const int32_t n = 100;
+		std::vector<int32_t> data(n), data_in(n);
+		for (int32_t i = 0; i < n; ++i) data[i] = i;
+		bool fell_back = false;
+		for (int attempt = 0; attempt < 10 && !fell_back; ++attempt) {
+			std::atomic<bool> connected{false};
+			std::thread unlinker(unlink_rings, std::cref(connected));
+			lsl::stream_inlet inlet(found[0], 360, 0, false);
+			bool opened = true;
+			try {
+				inlet.open_stream(5);
+			} catch (lsl::timeout_error &) { opened = false; }
+			connected = true;
+			unlinker.join();
+			REQUIRE(opened);
+
+			// the outlet may not serve the inlet yet when open_stream() returns, and the earlier
+			// inlets might keep wait_for_consumers() from waiting
+			REQUIRE(push_until_received(*outlet, inlet, -1, 5.));
+
+			// either way, the inlet receives the samples; through the socket if it fell back
+			const uint64_t bytes_before = outlet->stats()[lsl_stat_bytes];
+			outlet->push_chunk_multiplexed(data);
+			for (auto &value : data_in) {
+				// skip the repeated samples that were still on their way
+				do REQUIRE(inlet.pull_sample(&value, 1, 5.) != 0.);
+				while (value < 0);
+			}
+			CHECK(data_in == data);
+			fell_back = outlet->stats()[lsl_stat_bytes] - bytes_before >= n * sizeof(int32_t);
+		}
+		CHECK(fell_back);
+	}
+#endif
+}
+
+} // namespace
@@ -0,0 +1,76 @@
+#include "feed_compression.h"
+#include "sample.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// clazy:excludeall=non-pod-global-static
+
+/**
+ * Serialize 100ms of synthetic EEG (32 channels at 500 Hz): an alpha rhythm, slowly drifting
+ * offsets and amplifier noise, quantized like a 24 bit amplifier with a resolution of 0.0223 uV.
+ */
+static std::string synthetic_eeg(lsl_channel_format_t fmt) {
+	const uint32_t channels = 32, n = 50;
+	const double srate = 500., resolution = 0.0223;
+	std::mt19937 rng(42);
+	std::normal_distribution<double> noise(0., 5.);
+	std::vector<double> drift(channels), values(channels);
+	lsl::factory fac(fmt, channels, 1);
+	std::stringbuf chunk;
+	char scratch[channels * sizeof(double)];
+	for (uint32_t i = 0; i < n; ++i) {
+		for (uint32_t c = 0; c < channels; ++c) {
+			drift[c] = .98 * drift[c] + noise(rng);
+			const double uv = 20. * std::sin(2 * 3.14159265 * 10. * i / srate + c) + drift[c] +
+							  .1 * noise(rng);
+			const double steps = std::round(uv / resolution);
+			values[c] = fmt == cft_float32 ? steps * resolution : steps;
+		}
+		// only the first sample of a pushed chunk has a time stamp
+		auto samp = fac.new_sample(i ? lsl::DEDUCED_TIMESTAMP : 1000., false);
+		samp->assign_typed(values.data());
+		samp->save_streambuf(chunk, 110, false, scratch);
+	}
+	return chunk.str();
+}
+
+static void bench_filters(lsl_channel_format_t fmt) {
+	const std::string chunk = synthetic_eeg(fmt);
+	std::string frame;
+	const std::pair<const char *, lsl::chunk_filter> filters[] = {
+		{"none", lsl::chunk_filter::none}, {"shuffle", lsl::chunk_filter::shuffle},
+		{"delta", lsl::chunk_filter::delta}, {"xor", lsl::chunk_filter::xor_delta}};
+	for (const auto &filter : filters) {
+		lsl::chunk_encoder encoder(fmt, 32);
+		encoder.set_filter(filter.second);
+		frame.clear();
+		encoder.encode(chunk.data(), chunk.size(), frame);
+		WARN(filter.first << ": " << chunk.size() << " bytes compressed to " << frame.size()
+						  << " (ratio " << static_cast<double>(chunk.size()) / frame.size()
+						  << ")");
+		BENCHMARK(std::string("encode ") + filter.first) {
+			frame.clear();
+			encoder.encode(chunk.data(), chunk.size(), frame);
+			return frame.size();
+		};
+		std::string decoded(chunk.size(), '\0');
+		BENCHMARK(std::string("decode ") + filter.first) {
+			std::stringbuf src(frame);
+			lsl::chunk_decoder decoder(src, fmt, 32);
+			return decoder.sgetn(&decoded[0], decoded.size());
+		};
+		REQUIRE(decoded == chunk);
+	}
+}
+
+TEST_CASE("feed compression of synthetic EEG", "[bench][compression]") {
+	SECTION("float32") { bench_filters(cft_float32); }
+	SECTION("int32") { bench_filters(cft_int32); }
+	SECTION("int16") { bench_filters(cft_int16); }
+}
@@ -0,0 +1,47 @@
+#include "sample.h"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// clazy:excludeall=non-pod-global-static
+
+const uint32_t bench_channels = 1000;
+
+TEST_CASE("convert_endian", "[basic][bench]") {
+	std::vector<uint64_t> data(bench_channels, UINT64_C(0x0102030405060708));
+	BENCHMARK("int16") { lsl::sample::convert_endian(data.data(), bench_channels, 2); };
+	BENCHMARK("float32") { lsl::sample::convert_endian(data.data(), bench_channels, 4); };
+	BENCHMARK("double64") { lsl::sample::convert_endian(data.data(), bench_channels, 8); };
+}
+
+TEST_CASE("suppress_subnormals", "[basic][bench]") {
+	std::vector<float> floats(bench_channels, std::numeric_limits<float>::denorm_min());
+	std::vector<double> doubles(bench_channels, 1.);
+	BENCHMARK("float32") {
+		lsl::sample::suppress_subnormals(floats.data(), bench_channels, sizeof(float));
+	};
+	BENCHMARK("double64") {
+		lsl::sample::suppress_subnormals(doubles.data(), bench_channels, sizeof(double));
+	};
+}
+
+template <typename T> void bench_retrieve(lsl_channel_format_t fmt) {
+	lsl::factory fac(fmt, bench_channels, 1);
+	auto sample = fac.new_sample(0., false);
+	std::vector<float> floats(bench_channels);
+	std::vector<double> doubles(bench_channels);
+	std::vector<T> values(bench_channels, 1);
+	sample->assign_typed(values.data());
+	BENCHMARK("as float32") { sample->retrieve_typed(floats.data()); };
+	BENCHMARK("as double64") { sample->retrieve_typed(doubles.data()); };
+}
+
+TEST_CASE("retrieve_typed conversions", "[basic][bench]") {
+	SECTION("int16") { bench_retrieve<int16_t>(cft_int16); }
+	SECTION("int32") { bench_retrieve<int32_t>(cft_int32); }
+	SECTION("int64") { bench_retrieve<int64_t>(cft_int64); }
+	SECTION("float32") { bench_retrieve<float>(cft_float32); }
+	SECTION("double64") { bench_retrieve<double>(cft_double64); }
+}
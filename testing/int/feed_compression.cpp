@@ -0,0 +1,206 @@
+#include "feed_compression.h"
+#include "sample.h"
+#include "util/lz4.hpp"
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// clazy:excludeall=non-pod-global-static
+
+/// Serialize samples with drop notices and both kinds of time stamps, send them through the
+/// encoder and decoder in two chunks and check that the same samples arrive.
+static void check_round_trip(lsl_channel_format_t fmt, lsl::chunk_filter filter, bool fixed) {
+	const uint32_t channels = 5, n = 40;
+	lsl::factory fac(fmt, channels, n);
+	std::vector<lsl::sample_p> sent;
+	std::stringbuf chunk;
+	char scratch[channels * sizeof(double)];
+	for (uint32_t i = 0; i < n; ++i) {
+		auto samp = fac.new_sample(i % 3 ? lsl::DEDUCED_TIMESTAMP : 100. + i, false);
+		std::vector<double> values(channels);
+		for (uint32_t c = 0; c < channels; ++c) values[c] = 50 * std::sin(i * .1 + c) - 20;
+		samp->assign_typed(values.data());
+		if (i % 7 == 3) {
+			char notice[lsl::sample::drop_notice_bytes];
+			chunk.sputn(notice, lsl::sample::save_drop_notice(notice, i, false));
+		}
+		samp->save_streambuf(chunk, 110, false, scratch);
+		sent.push_back(samp);
+	}
+	const std::string serialized = chunk.str();
+
+	lsl::chunk_encoder encoder(fmt, channels);
+	if (fixed) encoder.set_filter(filter);
+	std::string frames;
+	const std::size_t half = serialized.size() / 2;
+	// the first chunk ends in the middle of a sample, so it can't be prefiltered
+	encoder.encode(serialized.data(), half, frames);
+	encoder.encode(serialized.data() + half, serialized.size() - half, frames);
+	encoder.encode(serialized.data(), 0, frames);
+
+	std::stringbuf src(frames);
+	lsl::chunk_decoder decoder(src, fmt, channels);
+	for (uint32_t i = 0; i < n; ++i) {
+		INFO(i);
+		auto received = fac.new_sample(0., false);
+		uint32_t dropped = 0;
+		received->load_streambuf(decoder, 110, false, false, &dropped);
+		CHECK(*received == *sent[i]);
+		CHECK(dropped == (i % 7 == 3 ? i : 0));
+	}
+	CHECK(decoder.sgetc() == std::stringbuf::traits_type::eof());
+}
+
+TEST_CASE("compressed chunks", "[basic][compression]") {
+	for (auto fmt : {cft_float32, cft_double64, cft_int8, cft_int16, cft_int32, cft_int64}) {
+		INFO(fmt);
+		check_round_trip(fmt, lsl::chunk_filter::delta, false);
+		for (auto filter : {lsl::chunk_filter::none, lsl::chunk_filter::shuffle,
+				 lsl::chunk_filter::delta, lsl::chunk_filter::xor_delta})
+			check_round_trip(fmt, filter, true);
+	}
+}
+
+TEST_CASE("compressed string chunks", "[basic][compression]") {
+	lsl::factory fac(cft_string, 2, 4);
+	std::stringbuf chunk;
+	std::vector<std::string> values{"a repeated string", "a repeated string"};
+	auto samp = fac.new_sample(1., false);
+	samp->assign_typed(values.data());
+	for (int i = 0; i < 10; ++i) samp->save_streambuf(chunk, 110, false, nullptr);
+	const std::string serialized = chunk.str();
+
+	lsl::chunk_encoder encoder(cft_string, 2);
+	std::string frames;
+	encoder.encode(serialized.data(), serialized.size(), frames);
+	CHECK(frames.size() < serialized.size() / 2);
+
+	std::stringbuf src(frames);
+	lsl::chunk_decoder decoder(src, cft_string, 2);
+	std::string decoded(serialized.size(), '\0');
+	CHECK(decoder.sgetn(&decoded[0], decoded.size()) ==
+		  static_cast<std::streamsize>(decoded.size()));
+	CHECK(decoded == serialized);
+}
+
+TEST_CASE("malformed compressed chunks", "[basic][compression]") {
+	lsl::chunk_encoder encoder(cft_int16, 2);
+	std::string frames;
+	const std::string chunk(100, '\1');
+	encoder.encode(chunk.data(), chunk.size(), frames);
+
+	// truncated frames are the end of the feed
+	std::stringbuf truncated(frames.substr(0, frames.size() - 1));
+	lsl::chunk_decoder truncated_decoder(truncated, cft_int16, 2);
+	CHECK(truncated_decoder.sgetc() == std::stringbuf::traits_type::eof());
+
+	// a too large chunk size
+	std::string corrupted(frames);
+	corrupted[3] = '\x7f';
+	std::stringbuf src(corrupted);
+	lsl::chunk_decoder decoder(src, cft_int16, 2);
+	CHECK_THROWS(decoder.sgetc());
+}
+
+/// Set the little endian integer at `pos` in a frame.
+static void set_le32(std::string &frame, std::size_t pos, uint32_t value) {
+	for (int i = 0; i < 4; ++i) frame[pos + i] = static_cast<char>((value >> (8 * i)) & 0xff);
+}
+
+TEST_CASE("hostile compressed frames", "[basic][compression]") {
+	// a frame with ten delta filtered int16 samples, some with transmitted time stamps
+	const uint32_t channels = 2, n = 10;
+	lsl::factory fac(cft_int16, channels, n);
+	std::stringbuf chunk;
+	for (uint32_t i = 0; i < n; ++i) {
+		auto samp = fac.new_sample(i % 2 ? lsl::DEDUCED_TIMESTAMP : 100. + i, false);
+		const int16_t values[channels] = {static_cast<int16_t>(i), 7};
+		samp->assign_typed(values);
+		samp->save_streambuf(chunk, 110, false, nullptr);
+	}
+	const std::string serialized = chunk.str();
+	lsl::chunk_encoder encoder(cft_int16, channels);
+	encoder.set_filter(lsl::chunk_filter::delta);
+	std::string frame;
+	encoder.encode(serialized.data(), serialized.size(), frame);
+	// the frame header: chunk size, stored size, number of samples, codec and prefilter
+	const std::size_t stored_pos = 4, samples_pos = 8, codec_pos = 12, filter_pos = 13;
+	const uint32_t len = static_cast<uint32_t>(serialized.size());
+	REQUIRE(frame[codec_pos] == 1);
+
+	auto decode = [len](const std::string &frame, lsl_channel_format_t fmt = cft_int16) {
+		std::stringbuf src(frame);
+		lsl::chunk_decoder decoder(src, fmt, channels);
+		std::string decoded(len, '\0');
+		return decoder.sgetn(&decoded[0], len) == len ? decoded : std::string();
+	};
+	REQUIRE(decode(frame) == serialized);
+
+	SECTION("the number of samples doesn't match the sample headers") {
+		// the most samples whose channel data would fit into the chunk
+		const uint32_t max_samples = len / (channels * sizeof(int16_t));
+		for (uint32_t num_samples : {0U, n - 1, n + 1, max_samples, max_samples + 1, 0xffffffffU}) {
+			INFO(num_samples);
+			std::string hostile(frame);
+			set_le32(hostile, samples_pos, num_samples);
+			CHECK_THROWS_AS(decode(hostile), std::runtime_error);
+		}
+	}
+
+	SECTION("unknown prefilter") {
+		for (int filter : {4, 0x7f, 0xff}) {
+			INFO(filter);
+			std::string hostile(frame);
+			hostile[filter_pos] = static_cast<char>(filter);
+			CHECK_THROWS_AS(decode(hostile), std::runtime_error);
+		}
+		// strings are never filtered
+		CHECK_THROWS_AS(decode(frame, cft_string), std::runtime_error);
+	}
+
+	SECTION("unknown codec") {
+		for (int codec : {2, 0x7f, 0xff}) {
+			INFO(codec);
+			std::string hostile(frame);
+			hostile[codec_pos] = static_cast<char>(codec);
+			CHECK_THROWS_AS(decode(hostile), std::runtime_error);
+		}
+		// compressed data can't be stored as it is
+		std::string hostile(frame);
+		hostile[codec_pos] = 0;
+		CHECK_THROWS_AS(decode(hostile), std::runtime_error);
+	}
+
+	SECTION("stored data larger than the compression bound") {
+		for (std::size_t stored : {lsl::lz4_compress_bound(len) + 1, std::size_t(0xffffffffU)}) {
+			INFO(stored);
+			std::string hostile(frame);
+			set_le32(hostile, stored_pos, static_cast<uint32_t>(stored));
+			hostile.append(stored > 1000 ? 0 : stored, '\0');
+			CHECK_THROWS_AS(decode(hostile), std::runtime_error);
+		}
+	}
+
+	SECTION("corrupted bytes") {
+		// anything may come out, but the decoder mustn't read or write outside its buffers
+		for (std::size_t pos = 0; pos < frame.size(); ++pos)
+			for (int bits : {0x01, 0x10, 0x80, 0xff}) {
+				std::string hostile(frame);
+				hostile[pos] = static_cast<char>(hostile[pos] ^ bits);
+				try {
+					decode(hostile);
+				} catch (std::exception &) {}
+			}
+	}
+
+	SECTION("chunk size doesn't match the compressed data") {
+		for (uint32_t size : {len - 1, len + 1}) {
+			INFO(size);
+			std::string hostile(frame);
+			set_le32(hostile, 0, size);
+			CHECK_THROWS_AS(decode(hostile), std::runtime_error);
+		}
+	}
+}
@@ -0,0 +1,120 @@
+#include "util/lz4.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+// clazy:excludeall=non-pod-global-static
+
+static const char fixture_text[] =
+	"LSL transmits time series over the network. LSL transmits time series over the local "
+	"network, and markers too: LSL transmits markers over the network.";
+
+/// Long literal runs, a long overlapping match and the text with matches to it.
+static std::string fixture_mixed() {
+	std::string data;
+	uint32_t x = 1;
+	auto noise = [&](std::size_t n) {
+		for (std::size_t i = 0; i < n; ++i) {
+			x = x * 1103515245U + 12345U;
+			data += static_cast<char>((x >> 16) & 0xff);
+		}
+	};
+	noise(300);
+	data.append(600, 'x');
+	data += fixture_text;
+	noise(20);
+	return data;
+}
+
+// The fixtures as compressed by liblz4 1.9.4: LZ4_compress_default(), and LZ4_compress_HC() with
+// level 12 for the last one.
+static const char text_lz4[] =
+	"ff1d4c534c207472616e736d6974732074696d6520736572696573206f76657220746865206e6574776f726b"
+	"2e202c0010546c6f63616c3200fb032c20616e64206d61726b65727320746f6f3a4300041b00086b0050776f"
+	"726b2e";
+static const char mixed_lz4[] =
+	"ffff21c67e816b4bfbe2fb54f6bddf7c1ce18701bf31de56720f4767668759aa883c59ea56137bd285a1d83c"
+	"54552f37ae655bda027998cce31a768e5fd9998f1f3f36ee43784d0dfabea6dae4868edc296d4eff56e17020"
+	"fb8fb1580590c509dc53cdaa3b489952d3529d069feab5c206139849b2011eac3288319c52469571368f57f6"
+	"391d16fa8874f5987c175c41bb6d718e0f7059c7011b2f333d91c01da50d0dab338d7e5e8f3ee66874a63ab1"
+	"c39311a864c7dbcae060e1f3bf090067a2e325a0213187d562c5a84f7e2e096b949fb06da99e5a0b467080b6"
+	"cf470ca6a52ad8acfba0ebb779247223924880c5a6a785b7d78c90e4ab63445266e39c3325f95eaaba73605d"
+	"4b717ebea98c571971c3ca5ee52a33ac885166a17b7567649a69ef6f5642a01d51c502f7bb92457878780300"
+	"ffff44ff1d4c534c207472616e736d6974732074696d6520736572696573206f76657220746865206e657477"
+	"6f726b2e202c0010546c6f63616c3200fb032c20616e64206d61726b65727320746f6f3a4300041b000d6b00"
+	"f005be6f0db638cc10fdbb54511c7b079427937d92c3";
+static const char mixed_lz4hc[] =
+	"ffff1fc67e816b4bfbe2fb54f6bddf7c1ce18701bf31de56720f4767668759aa883c59ea56137bd285a1d83c"
+	"54552f37ae655bda027998cce31a768e5fd9998f1f3f36ee43784d0dfabea6dae4868edc296d4eff56e17020"
+	"fb8fb1580590c509dc53cdaa3b489952d3529d069feab5c206139849b2011eac3288319c52469571368f57f6"
+	"391d16fa8874f5987c175c41bb6d718e0f7059c7011b2f333d91c01da50d0dab338d7e5e8f3ee66874a63ab1"
+	"c39311a864c7dbcae060e1f3bf090067a2e325a0213187d562c5a84f7e2e096b949fb06da99e5a0b467080b6"
+	"cf470ca6a52ad8acfba0ebb779247223924880c5a6a785b7d78c90e4ab63445266e39c3325f95eaaba73605d"
+	"4b717ebea98c571971c3ca5ee52a33ac885166a17b7567649a69ef6f5642a01d51c502f7bb9245780100ffff"
+	"46ff1d4c534c207472616e736d6974732074696d6520736572696573206f76657220746865206e6574776f72"
+	"6b2e202c0010546c6f63616c3200fb032c20616e64206d61726b65727320746f6f3a4300041b000d6b00f005"
+	"be6f0db638cc10fdbb54511c7b079427937d92c3";
+
+static std::string from_hex(const char *hex) {
+	std::string bytes;
+	for (const char *p = hex; p[0] && p[1]; p += 2)
+		bytes += static_cast<char>(std::stoi(std::string(p, 2), nullptr, 16));
+	return bytes;
+}
+
+static std::string compress(const std::string &data) {
+	std::string block(lsl::lz4_compress_bound(data.size()), '\0');
+	block.resize(lsl::lz4_compress(data.data(), data.size(), &block[0]));
+	return block;
+}
+
+static std::string decompress(const std::string &block, std::size_t capacity) {
+	std::string data(capacity, '\0');
+	data.resize(lsl::lz4_decompress(block.data(), block.size(), &data[0], capacity));
+	return data;
+}
+
+TEST_CASE("lz4 reference blocks", "[basic][compression]") {
+	const std::string text(fixture_text), mixed(fixture_mixed());
+	const struct {
+		const std::string &data;
+		const char *block;
+	} cases[] = {{text, text_lz4}, {mixed, mixed_lz4}, {mixed, mixed_lz4hc}};
+	for (const auto &c : cases) {
+		const std::string block = from_hex(c.block);
+		CHECK(decompress(block, c.data.size()) == c.data);
+		CHECK(decompress(block, c.data.size() + 100) == c.data);
+		CHECK_THROWS_AS(decompress(block, c.data.size() - 1), std::runtime_error);
+	}
+
+	// our blocks are the same as liblz4's, so LZ4_decompress_safe() decodes them; if the
+	// compressor changes, its output has to be checked with liblz4 again
+	CHECK(compress(text) == from_hex(text_lz4));
+	CHECK(compress(mixed) == from_hex(mixed_lz4hc));
+	CHECK(compress(std::string()) == std::string(1, '\0'));
+	CHECK(decompress(std::string(1, '\0'), 0).empty());
+}
+
+TEST_CASE("malformed lz4 blocks", "[basic][compression]") {
+	// blocks that have to be rejected when they're decompressed into a 16 byte buffer (liblz4's
+	// LZ4_decompress_safe() rejects them as well)
+	const char *const cases[][2] = {
+		{"", "empty block"},
+		{"10610000", "match offset 0"},
+		{"10610200", "match before the start of the output"},
+		{"10610100", "block ends with a match"},
+		{"5061626364", "literals beyond the end of the block"},
+		{"f0026161616161616161616161616161616161", "literals beyond the end of the output"},
+		{"1f61010000", "match beyond the end of the output"},
+		{"f0", "missing literal length"},
+		{"f0ffff", "truncated literal length"},
+		{"106101", "truncated match offset"},
+		{"1f610100", "missing match length"},
+		{"1f610100ff", "truncated match length"},
+	};
+	for (const auto &c : cases) {
+		INFO(c[1]);
+		CHECK_THROWS_AS(decompress(from_hex(c[0]), 16), std::runtime_error);
+	}
+}
@@ -1,6 +1,8 @@
 #include "time_postprocessor.h"
+#include <cmath>
 #include <loguru.hpp>
 #include <random>
+#include <vector>
 #include <thread>
 // include loguru before catch
 #include <catch2/catch_approx.hpp>
@@ -79,3 +81,45 @@ TEST_CASE("rls_smoothing", "[basic]") {
 	CHECK(fabs(pp.w0_ - latency) < .1);
 	CHECK(fabs(pp.w1_ - 1 / srate) < 1e-6);
 }
+
+TEST_CASE("postprocessing chunks", "[basic]") {
+	const std::size_t n = 1000;
+	const double srate = 100.;
+	auto query_offset = []() { return -50.; };
+	auto query_srate = [&]() { return srate; };
+	auto query_reset = []() { return false; };
+	std::default_random_engine rng;
+	std::normal_distribution<double> jitter(0., .005);
+	std::vector<double> stamps(n);
+	for (std::size_t i = 0; i < n; ++i) stamps[i] = 5000 + i / srate + jitter(rng);
+
+	for (uint32_t options : {proc_clocksync, proc_dejitter, proc_monotonize, proc_ALL}) {
+		INFO("options " << options);
+		lsl::time_postprocessor pp_single(query_offset, query_srate, query_reset),
+			pp_chunk(query_offset, query_srate, query_reset);
+		pp_single.set_options(options);
+		pp_chunk.set_options(options);
+		std::vector<double> chunked(stamps);
+		// process the time stamps in unevenly sized chunks
+		for (std::size_t pos = 0, len = 1; pos < n; pos += len, len = len * 2 + 1)
+			pp_chunk.process_timestamps(&chunked[pos], std::min(len, n - pos));
+		for (std::size_t i = 0; i < n; ++i)
+			CHECK(chunked[i] == Catch::Approx(pp_single.process_timestamp(stamps[i])));
+	}
+}
+
+TEST_CASE("postprocessing skipped samples", "[basic][threading]") {
+	const double srate = 100.;
+	lsl::time_postprocessor pp([]() { return 0.; }, [&]() { return srate; }, []() { return false; });
+	pp.set_options(proc_dejitter | proc_threadsafe);
+	pp.process_timestamp(5000.);
+
+	// the samples flushed on another thread count towards the dejitterer's sample index
+	std::thread flusher([&]() {
+		for (int i = 0; i < 1000; ++i) pp.skip_samples(1);
+	});
+	double stamp = 5000.;
+	for (int i = 0; i < 1000; ++i) stamp = pp.process_timestamp(5000. + i / srate);
+	flusher.join();
+	CHECK(std::isfinite(stamp));
+}
@@ -0,0 +1,163 @@
+#include "../src/resolver_impl.h"
+#include "../src/stream_info_impl.h"
+#include <asio/ip/address.hpp>
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "../src/api_types.hpp"
+// include api_types before public API header
+#include "../include/lsl/resolver.h"
+}
+
+// clazy:excludeall=non-pod-global-static
+
+using namespace lsl;
+
+static const auto v4 = asio::ip::make_address("127.0.0.1");
+static const auto v6 = asio::ip::make_address("::1");
+
+/// A stream info with a new UID, as if a stream answered the resolver's query.
+static stream_info_impl found_stream() {
+	stream_info_impl info("resolvertest", "ResolverChanges", 1, 0., cft_float32, "");
+	info.reset_uid();
+	return info;
+}
+
+/// Start a resolver whose results are only the ones added by the test.
+static void start(resolver_impl &resolver, double forget_after) {
+	resolver.resolve_continuous(
+		resolver_impl::build_query("type", "ResolverChangesNoSuchStream"), forget_after);
+}
+
+TEST_CASE("resolver changes after a reset fit into a small buffer", "[resolver][basic]") {
+	resolver_impl resolver;
+	start(resolver, 1.);
+	uint64_t generation = 0;
+	std::vector<result_update> changes;
+	resolver.add_result(found_stream(), v4);
+	generation = resolver.changes_since(generation, changes);
+	REQUIRE(changes.size() == 1);
+
+	// more streams come and go than the resolver remembers, so the consumer has to start over
+	for (int i = 0; i < 1100; ++i) resolver.add_result(found_stream(), v4);
+	std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+	// forget them before the new streams are found
+	REQUIRE(resolver.results().empty());
+	std::set<std::string> present;
+	for (int i = 0; i < 5; ++i) {
+		auto info = found_stream();
+		present.insert(info.uid());
+		resolver.add_result(std::move(info), v4);
+	}
+
+	lsl_streaminfo buffer[2];
+	int32_t kinds[2];
+	// the reset doesn't fit without a result
+	const uint64_t before = generation;
+	REQUIRE(lsl_resolver_changes(&resolver, &generation, buffer, kinds, 1) == 2);
+	REQUIRE(generation == before);
+
+	std::set<std::string> received;
+	int resets = 0, calls = 0;
+	for (int32_t n; (n = lsl_resolver_changes(&resolver, &generation, buffer, kinds, 2)) > 0;) {
+		REQUIRE(n <= 2);
+		++calls;
+		for (int32_t k = 0; k < n; ++k) {
+			if (kinds[k] == lsl_resolver_reset) {
+				CHECK(buffer[k] == nullptr);
+				++resets;
+				continue;
+			}
+			CHECK(kinds[k] == lsl_resolver_added);
+			received.insert(buffer[k]->uid());
+			delete buffer[k];
+		}
+	}
+	CHECK(resets == 1);
+	CHECK(calls == 3);
+	CHECK(received == present);
+}
+
+TEST_CASE("resolver changes are only split where the consumer can continue", "[resolver][basic]") {
+	resolver_impl resolver;
+	start(resolver, 5.);
+	std::vector<result_update> changes;
+	uint64_t generation = resolver.changes_since(0, changes);
+
+	// a stream found and then changed can't be returned as changed before it was added
+	auto first = found_stream();
+	const std::string first_uid = first.uid();
+	resolver.add_result(stream_info_impl(first), v4);
+	resolver.add_result(found_stream(), v4);
+	resolver.add_result(std::move(first), v6);
+	uint64_t next = resolver.changes_since(generation, changes, 1);
+	REQUIRE(changes.size() == 2);
+	for (const auto &change : changes) CHECK(change.kind == result_change::added);
+	CHECK(changes.back().info.uid() == first_uid);
+	generation = next;
+
+	// other changes are returned in parts
+	resolver.add_result(found_stream(), v4);
+	resolver.add_result(found_stream(), v4);
+	generation = resolver.changes_since(generation, changes, 1);
+	REQUIRE(changes.size() == 1);
+	CHECK(changes[0].kind == result_change::added);
+	generation = resolver.changes_since(generation, changes, 1);
+	REQUIRE(changes.size() == 1);
+	CHECK(changes[0].kind == result_change::added);
+	resolver.changes_since(generation, changes, 1);
+	CHECK(changes.empty());
+}
+
+TEST_CASE("resolver changes skip streams the consumer never saw", "[resolver][basic]") {
+	resolver_impl resolver;
+	start(resolver, .5);
+	std::vector<result_update> changes;
+	auto known = found_stream();
+	const std::string known_uid = known.uid();
+	resolver.add_result(std::move(known), v4);
+	uint64_t generation = resolver.changes_since(0, changes);
+	REQUIRE(changes.size() == 1);
+
+	// both streams are forgotten, but the consumer only knew the first one
+	resolver.add_result(found_stream(), v4);
+	std::this_thread::sleep_for(std::chrono::milliseconds(700));
+	resolver.changes_since(generation, changes);
+	REQUIRE(changes.size() == 1);
+	CHECK(changes[0].kind == result_change::removed);
+	CHECK(changes[0].info.uid() == known_uid);
+}
+
+TEST_CASE("resolver change callback runs on the resolver's thread", "[resolver][basic]") {
+	resolver_impl resolver;
+	start(resolver, .3);
+	std::atomic<int> calls{0}, calls_here{0}, removed{0};
+	const auto test_thread = std::this_thread::get_id();
+	resolver.set_change_callback([&](uint64_t generation) {
+		if (std::this_thread::get_id() == test_thread) calls_here++;
+		// the callback can get the changes
+		std::vector<result_update> changes;
+		resolver.changes_since(generation - 1, changes);
+		for (const auto &change : changes)
+			if (change.kind == result_change::removed) removed++;
+		calls++;
+	});
+	resolver.add_result(found_stream(), v4);
+	std::this_thread::sleep_for(std::chrono::milliseconds(400));
+	// forgetting the stream here notifies the consumers
+	std::vector<result_update> changes;
+	resolver.changes_since(0, changes);
+	for (int i = 0; i < 100 && !calls; ++i)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	resolver.set_change_callback(nullptr);
+	CHECK(calls > 0);
+	CHECK(calls_here == 0);
+	CHECK(removed > 0);
+}
@@ -1,8 +1,16 @@
 #include "../src/consumer_queue.h"
 #include "../src/sample.h"
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <boost/endian/conversion.hpp>
 #include <catch2/catch_all.hpp>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
 #include <thread>
+#include <vector>
 
 // clazy:excludeall=non-pod-global-static
 
@@ -54,6 +62,265 @@ TEST_CASE("consumer_queue_threaded", "[queue][threads]") {
 	pusher.join();
 }
 
+TEST_CASE("consumer_queue chunks", "[queue][basic]") {
+	const int size = 10;
+	lsl::factory fac(lsl_channel_format_t::cft_int8, 4, size);
+	lsl::consumer_queue queue(size);
+	std::vector<lsl::sample_p> samples;
+	for (int i = 0; i <= size; ++i) samples.push_back(fac.new_sample(i, true));
+	queue.push_chunk(samples.data(), samples.size());
+
+	// Does the queue respect the capacity and drop the oldest sample?
+	CHECK(queue.read_available() == size);
+
+	std::vector<lsl::sample_p> out(size);
+	// Does pop_chunk() stop at max_n?
+	REQUIRE(queue.pop_chunk(out.data(), 3, 0.0) == 3);
+	for (int i = 0; i < 3; ++i) CHECK(static_cast<int>(out[i]->timestamp()) == i + 1);
+
+	// Does it return only the available samples?
+	REQUIRE(queue.pop_chunk(out.data(), out.size(), 0.0) == size - 3);
+	for (int i = 0; i < size - 3; ++i) CHECK(static_cast<int>(out[i]->timestamp()) == i + 4);
+
+	// Does it time out on an empty queue?
+	CHECK(queue.pop_chunk(out.data(), out.size(), 0.01) == 0);
+	CHECK(queue.empty());
+}
+
+TEST_CASE("consumer_queue_threaded chunks", "[queue][threads]") {
+	const unsigned int size = 100000, chunk = 50;
+	lsl::factory fac(lsl_channel_format_t::cft_int8, 4, chunk);
+	std::vector<lsl::sample_p> samples;
+	for (unsigned int i = 0; i < chunk; ++i) samples.push_back(fac.new_sample(i, true));
+	lsl::consumer_queue queue(size);
+
+	std::thread pusher([&]() {
+		for (unsigned int i = 0; i < size; i += chunk) queue.push_chunk(samples.data(), chunk);
+	});
+
+	// Two consumers pull until all samples arrived, each sample only once and in order
+	std::atomic<unsigned> pulled{0};
+	std::atomic<bool> in_order{true};
+	auto consumer = [&]() {
+		std::vector<lsl::sample_p> out(chunk * 2);
+		while (pulled < size) {
+			std::size_t n = queue.pop_chunk(out.data(), out.size(), 0.01);
+			for (std::size_t i = 1; i < n; ++i)
+				if (static_cast<unsigned>(out[i]->timestamp()) !=
+					(static_cast<unsigned>(out[i - 1]->timestamp()) + 1) % chunk)
+					in_order = false;
+			pulled += static_cast<unsigned>(n);
+		}
+	};
+	std::thread consumer2(consumer);
+	consumer();
+	pusher.join();
+	consumer2.join();
+	CHECK(pulled == size);
+	CHECK(in_order);
+}
+
+TEST_CASE("consumer_queue blocking wakeup", "[queue][threads]") {
+	const int rounds = 1000;
+	const uint32_t spins = GENERATE(0u, 100u);
+	lsl::factory fac(lsl_channel_format_t::cft_int8, 4, 4);
+	auto sample = fac.new_sample(0.0, true);
+	lsl::consumer_queue ping(4), pong(4);
+	ping.set_wait_spins(spins);
+	pong.set_wait_spins(spins);
+
+	// Bounce a sample back and forth; a lost wakeup stalls a round until the timeout expires
+	const auto start = std::chrono::steady_clock::now();
+	std::thread echo([&]() {
+		for (int i = 0; i < rounds; ++i) {
+			ping.pop_sample(5.0);
+			pong.push_sample(sample);
+		}
+	});
+	int received = 0;
+	for (int i = 0; i < rounds; ++i) {
+		ping.push_sample(sample);
+		if (pong.pop_sample(5.0)) ++received;
+	}
+	echo.join();
+	CHECK(received == rounds);
+	CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+}
+
+TEST_CASE("consumer_queue push notification", "[queue][basic]") {
+	lsl::factory fac(lsl_channel_format_t::cft_int8, 4, 4);
+	int notifications = 0;
+	lsl::consumer_queue queue(10, lsl::send_buffer_p(), [&]() { ++notifications; });
+
+	// No notification unless armed
+	queue.push_sample(fac.new_sample(0.0, true));
+	CHECK(notifications == 0);
+
+	// Arming fails while there are samples to be popped
+	CHECK(!queue.arm_push_notification());
+	queue.flush();
+
+	// Armed notifications fire once
+	CHECK(queue.arm_push_notification());
+	queue.push_sample(fac.new_sample(1.0, true));
+	queue.push_sample(fac.new_sample(2.0, true));
+	CHECK(notifications == 1);
+}
+
+TEST_CASE("consumer_queue statistics", "[queue][basic]") {
+	lsl::factory fac(lsl_channel_format_t::cft_int8, 4, 1);
+	lsl::consumer_queue queue(4);
+	const int64_t t0 = lsl::latency_histogram::now();
+	for (int i = 0; i < 6; ++i) queue.push_sample(fac.new_sample(i, true), t0);
+	CHECK(queue.stats().pushed.value() == 6);
+	CHECK(queue.stats().dropped.value() == 2);
+
+	// Only popped samples count towards the dwell time, flushed ones don't
+	lsl::sample_p samples[2];
+	REQUIRE(queue.pop_chunk(samples, 2, 0.0) == 2);
+	REQUIRE(queue.pop_sample(0.0));
+	CHECK(queue.flush() == 1);
+	CHECK(queue.stats().dwell.count() == 3);
+	const auto elapsed = static_cast<uint64_t>(lsl::latency_histogram::now() - t0);
+	CHECK(queue.stats().dwell.percentile(1.0) <= 2 * elapsed);
+}
+
+TEST_CASE("consumer_queue overflow policies", "[queue][basic]") {
+	lsl::factory fac(lsl_channel_format_t::cft_int8, 4, 1);
+	uint32_t dropped[4];
+	lsl::sample_p samples[4];
+
+	// The oldest samples are dropped by default, which the consumer learns about
+	lsl::consumer_queue oldest(2);
+	for (int i = 0; i < 5; ++i) oldest.push_sample(fac.new_sample(i, true));
+	REQUIRE(oldest.pop_chunk(samples, 4, 0.0, dropped) == 2);
+	CHECK(samples[0]->timestamp() == 3.0);
+	CHECK(dropped[0] == 3);
+	CHECK(dropped[1] == 0);
+
+	// The new samples are dropped instead, but a gap is reported all the same
+	lsl::consumer_queue newest(2, nullptr, nullptr, lsl::overflow_policy::drop_newest);
+	lsl::sample_p chunk[] = {fac.new_sample(0, true), fac.new_sample(1, true),
+		fac.new_sample(2, true), fac.new_sample(3, true)};
+	newest.push_chunk(chunk, 4);
+	CHECK(newest.stats().dropped.value() == 2);
+	REQUIRE(newest.pop_chunk(samples, 4, 0.0, dropped) == 2);
+	CHECK(samples[1]->timestamp() == 1.0);
+	CHECK((dropped[0] == 0 && dropped[1] == 0));
+	newest.push_sample(fac.new_sample(4, true));
+	REQUIRE(newest.pop_sample(0.0, dropped));
+	CHECK(dropped[0] == 2);
+
+	// Samples the producer lost further upstream and flushed samples
+	newest.push_sample(fac.new_sample(5, true), lsl::latency_histogram::now(), 3);
+	newest.push_sample(fac.new_sample(6, true));
+	CHECK(newest.flush() == 2);
+	newest.push_sample(fac.new_sample(7, true));
+	REQUIRE(newest.pop_sample(0.0, dropped));
+	CHECK(dropped[0] == 3);
+}
+
+TEST_CASE("consumer_queue blocking overflow", "[queue][threads]") {
+	lsl::factory fac(lsl_channel_format_t::cft_int8, 4, 1);
+	lsl::consumer_queue queue(2, nullptr, nullptr, lsl::overflow_policy::block);
+	for (int i = 0; i < 2; ++i) queue.push_sample(fac.new_sample(i, true));
+
+	// The producer waits for the consumer to make room
+	std::thread consumer([&]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		queue.pop_sample();
+	});
+	queue.push_sample(fac.new_sample(2, true));
+	consumer.join();
+	CHECK(queue.stats().dropped.value() == 0);
+
+	// ... but not forever, and not again until the consumer pops something
+	const auto start = std::chrono::steady_clock::now();
+	queue.push_sample(fac.new_sample(3, true));
+	const auto first_wait = std::chrono::steady_clock::now() - start;
+	queue.push_sample(fac.new_sample(4, true));
+	const auto both_waits = std::chrono::steady_clock::now() - start;
+	CHECK(queue.stats().dropped.value() == 2);
+	CHECK(both_waits - first_wait < first_wait);
+	uint32_t dropped;
+	REQUIRE(queue.pop_sample(0.0, &dropped)->timestamp() == 3.0);
+	CHECK(dropped == 2);
+}
+
+TEST_CASE("latency histogram", "[basic]") {
+	lsl::latency_histogram hist;
+	CHECK(hist.percentile(.5) == 0);
+	// 1..1000 us
+	for (uint64_t us = 1; us <= 1000; ++us) hist.record(us * 1000);
+	CHECK(hist.count() == 1000);
+	// the reported percentiles are at most 12.5% larger than the exact ones
+	for (double q : {.01, .5, .9, .99, 1.}) {
+		const auto exact = static_cast<uint64_t>(q * 1000) * 1000;
+		CHECK(hist.percentile(q) >= exact);
+		CHECK(hist.percentile(q) <= exact + exact / 8);
+	}
+	// small values are exact, huge ones end up in the last bucket
+	lsl::latency_histogram other;
+	other.record(3);
+	other.record(UINT64_MAX);
+	CHECK(other.percentile(.5) == 3);
+	CHECK(other.percentile(1.) >= UINT64_C(1) << 39);
+	hist.merge(other);
+	CHECK(hist.count() == 1002);
+	CHECK(hist.percentile(0) == 3);
+}
+
+TEST_CASE("factory growth and trimming", "[basic]") {
+	lsl::factory fac(lsl_channel_format_t::cft_string, 4, 8);
+	CHECK(fac.stats().allocated == 8);
+
+	// Does the factory grow beyond its reserve?
+	std::vector<lsl::sample_p> samples;
+	for (int i = 0; i < 100; ++i) samples.push_back(fac.new_sample(i, true));
+	auto stats = fac.stats();
+	CHECK(stats.allocated >= 100);
+	CHECK(stats.in_use == 100);
+	CHECK(stats.peak == 100);
+
+	// Are samples returned to the pool?
+	samples.clear();
+	CHECK(fac.stats().in_use == 0);
+
+	// The arenas are kept as long as the recent peak needs them, and then released
+	fac.trim();
+	CHECK(fac.stats().allocated >= 100);
+	fac.trim();
+	stats = fac.stats();
+	CHECK(stats.allocated == 8);
+	CHECK(stats.peak == 100);
+
+	// Are the samples of the remaining arena still usable?
+	for (int i = 0; i < 20; ++i) samples.push_back(fac.new_sample(i, true));
+	for (int i = 0; i < 20; ++i) CHECK(samples[i]->timestamp() == i);
+}
+
+TEST_CASE("factory shrinks after pushing stops", "[basic]") {
+	lsl::factory fac(lsl_channel_format_t::cft_float32, 4, 8, .05);
+	std::vector<lsl::sample_p> samples;
+	for (int i = 0; i < 2000; ++i) samples.push_back(fac.new_sample(i, true));
+	samples.clear();
+	REQUIRE(fac.stats().allocated >= 2000);
+
+	// no new_sample() call after the burst, only the periodic check from another thread
+	std::atomic<bool> done{false};
+	std::thread timer([&]() {
+		for (int i = 0; i < 100 && !done; ++i) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			fac.trim_if_due();
+		}
+	});
+	for (int i = 0; i < 100 && fac.stats().allocated > 8; ++i)
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	done = true;
+	timer.join();
+	CHECK(fac.stats().allocated == 8);
+}
+
 TEST_CASE("sample conversion", "[basic]") {
 	lsl::factory fac(lsl_channel_format_t::cft_int64, 2, 1);
 	double values[2] = {1, -1};
@@ -72,3 +339,75 @@ TEST_CASE("sample conversion", "[basic]") {
 		values[1] = (double)(-buf[0]);
 	}
 }
+
+TEST_CASE("string sample storage", "[basic]") {
+	lsl::factory fac(lsl_channel_format_t::cft_string, 3, 1);
+	const std::string large(100000, 'x'), small[3] = {"a", "", "bc"};
+	std::string values[3] = {large, "", "small"}, out[3];
+	auto sample = fac.new_sample(0.0, true);
+
+	// Do large and small values survive being stored, and overwritten by shorter ones?
+	sample->assign_typed(values);
+	sample->retrieve_typed(out);
+	for (int i = 0; i < 3; ++i) CHECK(out[i] == values[i]);
+	sample->assign_typed(small);
+	sample->retrieve_typed(out);
+	for (int i = 0; i < 3; ++i) CHECK(out[i] == small[i]);
+	std::size_t len;
+	const char *val = sample->string_value(2, len);
+	CHECK(std::string(val, len) == "bc");
+
+	// Round trip through the wire format
+	for (bool reverse : {false, true}) {
+		sample->assign_typed(values);
+		std::stringbuf sb;
+		sample->save_streambuf(sb, 110, reverse);
+		auto copy = fac.new_sample(0.0, true);
+		copy->load_streambuf(sb, 110, reverse, false);
+		CHECK(*copy == *sample);
+		copy->assign_typed(small);
+		CHECK(!(*copy == *sample));
+	}
+}
+
+template <typename T> void check_convert_endian() {
+	// 19 values so both the vectorized part and the scalar remainder are covered
+	const uint32_t n = 19;
+	T vals[n], expected[n];
+	for (uint32_t i = 0; i < n; ++i) {
+		vals[i] = static_cast<T>(UINT64_C(0x0102030405060708) + i * UINT64_C(0x1111111111111111));
+		expected[i] = lslboost::endian::endian_reverse(vals[i]);
+	}
+	lsl::sample::convert_endian(vals, n, sizeof(T));
+	for (uint32_t i = 0; i < n; ++i) CHECK(vals[i] == expected[i]);
+}
+
+TEST_CASE("endian conversion", "[basic]") {
+	check_convert_endian<uint16_t>();
+	check_convert_endian<uint32_t>();
+	check_convert_endian<uint64_t>();
+}
+
+template <typename T> void check_suppress_subnormals() {
+	using lim = std::numeric_limits<T>;
+	const T vals[] = {0, -0, 1, -1, lim::min(), -lim::min(), lim::denorm_min(), -lim::denorm_min(),
+		lim::min() / 2, -lim::min() / 3, lim::max(), lim::infinity(), -lim::infinity(),
+		lim::quiet_NaN(), lim::min() * (1 - lim::epsilon())};
+	const uint32_t n = sizeof(vals) / sizeof(vals[0]);
+	T processed[n];
+	std::copy(vals, vals + n, processed);
+	lsl::sample::suppress_subnormals(processed, n, sizeof(T));
+	for (uint32_t i = 0; i < n; ++i) {
+		INFO(vals[i]);
+		if (std::fpclassify(vals[i]) == FP_SUBNORMAL) {
+			CHECK(processed[i] == 0);
+			CHECK(std::signbit(processed[i]) == std::signbit(vals[i]));
+		} else
+			CHECK(std::memcmp(&processed[i], &vals[i], sizeof(T)) == 0);
+	}
+}
+
+TEST_CASE("subnormal suppression", "[basic]") {
+	check_suppress_subnormals<float>();
+	check_suppress_subnormals<double>();
+}
@@ -29,6 +29,8 @@
 #include "send_buffer.h"
 #include <atomic>
 #include <catch2/catch_all.hpp>
+#include <chrono>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -176,3 +178,106 @@ TEST_CASE("multi-threaded send_buffer stress", "[queue][regression][send_buffer]
 	INFO("Pushed " << push_count.load() << " samples");
 	REQUIRE(push_count.load() == num_producer_threads * iterations_per_thread);
 }
+
+/**
+ * Test: Unregister a consumer while a push waits for it
+ *
+ * A push into a full queue with the block policy waits for the consumer. If the consumer is
+ * destroyed in the meantime, the push has to stop waiting (and mustn't touch the queue anymore)
+ * instead of letting the unregistering consumer wait for the block timeout.
+ */
+TEST_CASE("unregister a blocked consumer during a push", "[send_buffer][threads]") {
+	lsl::factory fac(lsl_channel_format_t::cft_int8, 4, 8);
+	auto sendbuf = std::make_shared<lsl::send_buffer>(16);
+	auto blocked = sendbuf->new_consumer(2, nullptr, lsl::overflow_policy::block);
+	auto other = sendbuf->new_consumer();
+	for (int i = 0; i < 2; ++i) sendbuf->push_sample(fac.new_sample(i, true));
+
+	std::atomic<bool> pushed{false};
+	auto sample = fac.new_sample(2, true);
+	std::thread producer([&]() {
+		sendbuf->push_sample(sample);
+		pushed = true;
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	CHECK_FALSE(pushed);
+
+	const auto start = std::chrono::steady_clock::now();
+	blocked.reset();
+	const auto waited = std::chrono::steady_clock::now() - start;
+	producer.join();
+	// much less than the default block timeout of 0.5 seconds
+	CHECK(waited < std::chrono::milliseconds(250));
+
+	// the other consumer got all samples, and the next push skips the removed one
+	sendbuf->push_sample(fac.new_sample(3, true));
+	for (int i = 0; i < 4; ++i) {
+		auto received = other->pop_sample(0.);
+		REQUIRE(received);
+		CHECK(received->timestamp() == i);
+	}
+	lsl::queue_stats total;
+	sendbuf->collect_stats(total);
+	CHECK(total.pushed.value() == 3 + 4);
+}
+
+/**
+ * Test: Consumers with the block policy come and go while samples are pushed
+ *
+ * The consumers never pop anything, so each push waits for them until they're gone.
+ */
+TEST_CASE("blocked consumer churn during pushes", "[send_buffer][threads][concurrent]") {
+	lsl::factory fac(lsl_channel_format_t::cft_int8, 4, 16);
+	const int num_samples = 500;
+	auto sendbuf = std::make_shared<lsl::send_buffer>(num_samples);
+	auto other = sendbuf->new_consumer();
+
+	std::atomic<bool> done{false};
+	std::thread churn([&]() {
+		while (!done) {
+			auto blocked = sendbuf->new_consumer(2, nullptr, lsl::overflow_policy::block);
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+	});
+	std::vector<lsl::sample_p> samples;
+	for (int i = 0; i < num_samples; ++i) samples.push_back(fac.new_sample(i, true));
+	const auto start = std::chrono::steady_clock::now();
+	for (const auto &sample : samples) sendbuf->push_sample(sample);
+	const auto elapsed = std::chrono::steady_clock::now() - start;
+	done = true;
+	churn.join();
+
+	CHECK(other->read_available() == num_samples);
+	// without the consumers stopping the pushes, this would take minutes
+	CHECK(elapsed < std::chrono::seconds(10));
+}
+
+#ifdef CATCH_CONFIG_ENABLE_BENCHMARKING
+/**
+ * Benchmark: fan-out of single samples to 1, 10 and 100 consumers
+ *
+ * The "churn" variants add and remove consumers from another thread while the producer pushes,
+ * which must not stall the producer.
+ */
+TEST_CASE("send_buffer fan-out", "[send_buffer][bench]") {
+	lsl::factory fac(lsl_channel_format_t::cft_float32, 8, 16);
+	auto sample = fac.new_sample(0.0, true);
+
+	for (int num_consumers : {1, 10, 100}) {
+		auto sendbuf = std::make_shared<lsl::send_buffer>(1024);
+		std::vector<std::shared_ptr<lsl::consumer_queue>> queues;
+		for (int i = 0; i < num_consumers; ++i) queues.push_back(sendbuf->new_consumer());
+		const std::string suffix = std::to_string(num_consumers) + " consumers";
+
+		BENCHMARK("push_sample " + suffix) { sendbuf->push_sample(sample); };
+
+		std::atomic<bool> done{false};
+		std::thread churn([&]() {
+			while (!done) sendbuf->new_consumer(16);
+		});
+		BENCHMARK("push_sample with churn " + suffix) { sendbuf->push_sample(sample); };
+		done = true;
+		churn.join();
+	}
+}
+#endif
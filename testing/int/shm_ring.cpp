@@ -0,0 +1,89 @@
+#include "shm_ring.h"
+#include <catch2/catch_all.hpp>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+// clazy:excludeall=non-pod-global-static
+
+TEST_CASE("shm_ring basic", "[shm][basic]") {
+	const std::size_t sample_bytes = 3 * sizeof(float);
+	auto producer = lsl::shm_ring::create(sample_bytes, 5);
+	REQUIRE(producer->slots() == 8);
+	auto consumer = lsl::shm_ring::attach(producer->name(), sample_bytes);
+
+	// Is an empty ring detected and does the producer get asked for a wakeup?
+	CHECK(consumer->peek() == nullptr);
+	CHECK(consumer->prepare_wait());
+
+	float values[3] = {1.f, 2.f, 3.f};
+	for (int i = 0; i < 8; ++i) {
+		char *slot = producer->reserve();
+		REQUIRE(slot != nullptr);
+		double ts = i;
+		std::memcpy(slot + lsl::shm_ring::timestamp_offset, &ts, sizeof(ts));
+		std::memcpy(slot + lsl::shm_ring::data_offset, values, sizeof(values));
+		producer->commit();
+	}
+	// Is the capacity respected?
+	CHECK(producer->reserve() == nullptr);
+	CHECK(producer->writable() == 0);
+	// Committed samples are invisible until published
+	CHECK(consumer->peek() == nullptr);
+	CHECK(producer->publish());
+	// Only new samples make the producer check for a waiting consumer
+	CHECK(consumer->prepare_wait() == false);
+	CHECK(!producer->publish());
+
+	for (int i = 0; i < 8; ++i) {
+		const char *slot = consumer->peek();
+		REQUIRE(slot != nullptr);
+		double ts;
+		std::memcpy(&ts, slot + lsl::shm_ring::timestamp_offset, sizeof(ts));
+		CHECK(ts == i);
+		CHECK(std::memcmp(slot + lsl::shm_ring::data_offset, values, sizeof(values)) == 0);
+		consumer->pop();
+	}
+	CHECK(consumer->peek() == nullptr);
+	// Released slots can be reused
+	CHECK(producer->writable() == 8);
+	CHECK(producer->reserve() != nullptr);
+}
+
+TEST_CASE("shm_ring layout mismatch", "[shm][basic]") {
+	auto producer = lsl::shm_ring::create(8, 16);
+	CHECK_THROWS_AS(lsl::shm_ring::attach(producer->name(), 64), std::runtime_error);
+	CHECK_THROWS_AS(lsl::shm_ring::attach("not/a/ring", 8), std::runtime_error);
+}
+
+TEST_CASE("shm_ring threaded", "[shm][threads]") {
+	const uint64_t n = 100000;
+	auto producer = lsl::shm_ring::create(sizeof(uint64_t), 64);
+	auto consumer = lsl::shm_ring::attach(producer->name(), sizeof(uint64_t));
+
+	std::thread pusher([&]() {
+		for (uint64_t i = 0; i < n; ++i) {
+			char *slot;
+			while (!(slot = producer->reserve())) {
+				producer->publish();
+				std::this_thread::yield();
+			}
+			std::memcpy(slot + lsl::shm_ring::data_offset, &i, sizeof(i));
+			producer->commit();
+			if (i % 16 == 15) producer->publish();
+		}
+		producer->publish();
+	});
+
+	bool in_order = true;
+	for (uint64_t i = 0; i < n; ++i) {
+		const char *slot;
+		while (!(slot = consumer->peek())) std::this_thread::yield();
+		uint64_t value;
+		std::memcpy(&value, slot + lsl::shm_ring::data_offset, sizeof(value));
+		if (value != i) in_order = false;
+		consumer->pop();
+	}
+	pusher.join();
+	CHECK(in_order);
+}
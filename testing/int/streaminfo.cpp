@@ -1,4 +1,6 @@
 #include "../src/api_config.h"
+#include "../src/compiled_query.h"
+#include "../src/info_reply.h"
 #include "../src/stream_info_impl.h"
 #include <cctype>
 #include <loguru.hpp>
@@ -88,3 +90,200 @@ TEST_CASE("streaminfo matching via XPath", "[basic][streaminfo][xml]") {
 
 #endif
 }
+
+TEST_CASE("precompiled queries", "[basic][streaminfo]") {
+	lsl::stream_info_impl info(
+		"streamname", "EEG", 8, 500.5, lsl_channel_format_t::cft_float32, "sourceid");
+	info.session_id("default");
+	info.desc().append_child("manufacturer").append_child(pugi::node_pcdata).set_value("lsl");
+	pugi::xml_document doc;
+	REQUIRE(doc.load_string(info.to_fullinfo_message().c_str()));
+
+	// queries that are evaluated against the fields have to match exactly like XPath
+	for (const char *query : {"name='streamname'", "name = \"streamname\"", "name!='streamname'",
+			 "name='other'", "session_id='default' and type='EEG'",
+			 "session_id='default' and (type='EMG' or type='EEG')",
+			 "session_id='other' or type='EEG' and channel_count=8",
+			 "starts-with(name,'stream')", "starts-with(source_id, 'id')",
+			 "contains(name,'amna')", "not(contains(name,'x')) and channel_format='float32'",
+			 "channel_count > 5", "channel_count<=7", "channel_count!=8", "nominal_srate>=500.5",
+			 "nominal_srate=500.5", "nominal_srate<-1", "hostname=''"}) {
+		INFO(query);
+		lsl::compiled_query compiled(query);
+		REQUIRE(!compiled.needs_xml());
+		CHECK(compiled.matches(info) ==
+			  pugi::xpath_query(query).evaluate_boolean(doc.first_child()));
+	}
+
+	// everything else is left to XPath
+	for (const char *query : {"desc/manufacturer='lsl'", "name<'x'", "channel_count='8'",
+			 "name='streamname' and count(desc/*)=1", "starts-with(desc/manufacturer,'l')"}) {
+		INFO(query);
+		lsl::compiled_query compiled(query);
+		REQUIRE(compiled.needs_xml());
+		CHECK(compiled.matches_xml(doc.first_child()) ==
+			  pugi::xpath_query(query).evaluate_boolean(doc.first_child()));
+		CHECK(info.matches_query(query) == compiled.matches_xml(doc.first_child()));
+	}
+	CHECK(info.matches_query("desc/manufacturer='lsl'"));
+
+	// compiled queries are shared
+	REQUIRE(lsl::compiled_query::get("type='EEG'") == lsl::compiled_query::get("type='EEG'"));
+	REQUIRE_THROWS(lsl::compiled_query("in'va'lid"));
+}
+
+TEST_CASE("lru_cache", "[basic]") {
+	lsl::lru_cache<int> cache(2);
+	cache.insert("a", 1);
+	cache.insert("b", 2);
+	REQUIRE(*cache.find("a") == 1);
+	// b is the least recently used entry now
+	cache.insert("c", 3);
+	REQUIRE(cache.size() == 2);
+	REQUIRE(cache.find("b") == nullptr);
+	REQUIRE(*cache.find("a") == 1);
+	cache.insert("c", 4);
+	REQUIRE(*cache.find("c") == 4);
+	cache.clear();
+	REQUIRE(cache.find("a") == nullptr);
+}
+
+TEST_CASE("binary shortinfo messages", "[basic][streaminfo]") {
+	lsl::stream_info_impl info(
+		"streamname", "streamtype", 8, 500, lsl_channel_format_t::cft_int16, "sourceid");
+	info.reset_uid();
+	info.created_at(1234.5);
+	info.hostname("host");
+	info.v4data_port(16572);
+	info.v6service_port(16573);
+	info.desc().append_child("channels");
+
+	const std::string msg = info.to_shortinfo_binary();
+	REQUIRE(lsl::stream_info_impl::is_shortinfo_binary(msg.data(), msg.size()));
+	const std::string xml = info.to_shortinfo_message();
+	REQUIRE(!lsl::stream_info_impl::is_shortinfo_binary(xml.data(), xml.size()));
+
+	// The fields are the same as for the XML short-info message, without the description
+	lsl::stream_info_impl from_binary, from_xml;
+	from_binary.from_shortinfo_binary(msg.data(), msg.size());
+	from_xml.from_shortinfo_message(xml);
+	for (const auto *parsed : {&from_binary, &from_xml}) {
+		CHECK(parsed->name() == "streamname");
+		CHECK(parsed->uid() == info.uid());
+		CHECK(parsed->channel_format() == cft_int16);
+		CHECK(parsed->nominal_srate() == 500.);
+		CHECK(parsed->created_at() == 1234.5);
+		CHECK(parsed->hostname() == "host");
+		CHECK(parsed->v4data_port() == 16572);
+		CHECK(parsed->v6service_port() == 16573);
+		CHECK(!parsed->desc().empty());
+		CHECK(parsed->desc().first_child().empty());
+	}
+	CHECK(from_binary.matches_query("name='streamname' and channel_count=8"));
+
+	// Truncated messages are rejected
+	lsl::stream_info_impl truncated;
+	CHECK_THROWS(truncated.from_shortinfo_binary(msg.data(), msg.size() - 1));
+}
+
+TEST_CASE("copy-on-write stream info documents", "[basic][streaminfo]") {
+	lsl::stream_info_impl info(
+		"streamname", "streamtype", 2, 100, lsl_channel_format_t::cft_float32, "sourceid");
+	info.reset_uid();
+	info.desc().append_child("channels").append_child("channel").append_child("label").text().set(
+		"Cz");
+	const std::string msg = info.to_fullinfo_message();
+
+	lsl::stream_info_impl received;
+	received.from_fullinfo_message(msg);
+	CHECK(received.name() == "streamname");
+	CHECK(received.uid() == info.uid());
+	// unchanged documents are passed on as they were received
+	CHECK(received.to_fullinfo_message() == msg);
+
+	// copies don't see each other's changes
+	lsl::stream_info_impl copy(received);
+	copy.hostname("otherhost");
+	copy.desc().append_child("manufacturer");
+	CHECK(std::string(received.desc().child("channels").child("channel").child_value("label")) ==
+		  "Cz");
+	CHECK(received.desc().child("manufacturer").empty());
+	CHECK(!copy.desc().child("manufacturer").empty());
+	CHECK(received.matches_query("count(desc/manufacturer)=0"));
+	CHECK(copy.matches_query("count(desc/manufacturer)=1"));
+	CHECK(copy.matches_query("hostname='otherhost'"));
+	CHECK(copy.to_fullinfo_message().find("otherhost") != std::string::npos);
+
+	// changes via a description node obtained earlier don't leak into later copies
+	pugi::xml_node desc = copy.desc();
+	lsl::stream_info_impl later(copy);
+	desc.append_child("cap");
+	CHECK(later.desc().child("cap").empty());
+
+	// messages with the fields after the description are parsed right away
+	lsl::stream_info_impl reordered;
+	reordered.from_fullinfo_message("<info><desc><x/></desc><name>n</name><type/>"
+									"<channel_count>1</channel_count><channel_format>int8"
+									"</channel_format><nominal_srate>0</nominal_srate>"
+									"<version>1.1</version><created_at>0</created_at><uid>u</uid>"
+									"<v4data_port>0</v4data_port><v4service_port>0"
+									"</v4service_port><v6data_port>0</v6data_port>"
+									"<v6service_port>0</v6service_port></info>");
+	CHECK(reordered.name() == "n");
+	CHECK(reordered.uid() == "u");
+	CHECK(!reordered.desc().child("x").empty());
+}
+
+TEST_CASE("binary fullinfo messages", "[basic][streaminfo]") {
+	lsl::stream_info_impl info(
+		"streamname", "streamtype", 2, 100, lsl_channel_format_t::cft_double64, "sourceid");
+	info.reset_uid();
+	info.created_at(1234.5);
+	auto channels = info.desc().append_child("channels");
+	for (const char *label : {"C3", "C4"}) {
+		auto channel = channels.append_child("channel");
+		channel.append_attribute("unit").set_value("uV");
+		channel.append_child("label").text().set(label);
+	}
+	info.desc().append_child("note").append_child(pugi::node_cdata).set_value("<raw>");
+
+	const std::string msg = info.to_fullinfo_binary();
+	REQUIRE(lsl::stream_info_impl::is_fullinfo_binary(msg.data(), msg.size()));
+	CHECK(msg.size() < info.to_fullinfo_message().size());
+
+	lsl::stream_info_impl received;
+	received.from_fullinfo_binary(msg.data(), msg.size());
+	CHECK(received.name() == "streamname");
+	CHECK(received.uid() == info.uid());
+	CHECK(received.channel_format() == cft_double64);
+	CHECK(received.created_at() == 1234.5);
+	// unchanged infos are passed on as they were received
+	CHECK(received.to_fullinfo_binary() == msg);
+	auto channel = received.desc().child("channels").child("channel");
+	CHECK(std::string(channel.attribute("unit").value()) == "uV");
+	CHECK(std::string(channel.child_value("label")) == "C3");
+	CHECK(std::string(channel.next_sibling("channel").child_value("label")) == "C4");
+	CHECK(std::string(received.desc().child("note").first_child().value()) == "<raw>");
+	CHECK(received.matches_query("desc/channels/channel[2]/label='C4'"));
+
+	lsl::stream_info_impl truncated;
+	CHECK_THROWS(truncated.from_fullinfo_binary(msg.data(), msg.size() / 2));
+
+	// replies to LSL:fullinfo/2 requests
+	const uint64_t hash = lsl::fullinfo_hash(msg);
+	CHECK(hash != lsl::fullinfo_hash(info.to_fullinfo_message()));
+	auto reply = lsl::fullinfo_reply::parse(lsl::fullinfo_reply::make(msg, hash, false));
+	CHECK(!reply.unchanged);
+	CHECK(!reply.xml);
+	CHECK(reply.hash == hash);
+	CHECK(reply.message == msg);
+	const std::string large(100000, 'x');
+	const std::string compressed = lsl::fullinfo_reply::make(large, 1, true);
+	CHECK(compressed.size() < large.size() / 10);
+	CHECK(lsl::fullinfo_reply::parse(compressed).message == large);
+	reply = lsl::fullinfo_reply::parse(lsl::fullinfo_reply::make_unchanged(hash));
+	CHECK(reply.unchanged);
+	CHECK(reply.hash == hash);
+	CHECK(reply.message.empty());
+	CHECK_THROWS(lsl::fullinfo_reply::parse(compressed.substr(0, compressed.size() - 1)));
+}
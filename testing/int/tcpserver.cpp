@@ -204,6 +204,12 @@ TEST_CASE("tcpserver_float", "[network]") {
 	send_request(ctx, ep, asio::buffer("LSL:streamfeed\n0 0\r\n"),
 		with_read_callback("streamfeed 100", check_streamfeed_100_response));
 
+	send_request(ctx, ep, asio::buffer("LSL:streamfeed/110 \nCompression: zstd, lz4\r\n\r\n"),
+		with_read_callback("compression", [](const std::string &res) {
+			REQUIRE(res.substr(0, 14) == "LSL/110 200 OK");
+			REQUIRE(res.find("Compression: lz4") != std::string::npos);
+		}));
+
 	tcp_server.run();
 	ctx.run();
 }